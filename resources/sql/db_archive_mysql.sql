@@ -0,0 +1,28 @@
+CREATE TABLE IF NOT EXISTS ArchivedMessages (
+  id              INTEGER     PRIMARY KEY,
+  is_read         INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_read >= 0 AND is_read <= 1),
+  is_deleted      INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_deleted >= 0 AND is_deleted <= 1),
+  is_important    INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_important >= 0 AND is_important <= 1),
+  feed            TEXT        NOT NULL,
+  title           TEXT        NOT NULL CHECK (title != ''),
+  url             TEXT,
+  author          TEXT,
+  date_created    BIGINT      NOT NULL CHECK (date_created != 0),
+  is_pdeleted     INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1),
+  account_id      INTEGER     NOT NULL,
+  custom_id       TEXT,
+  custom_hash     TEXT,
+  has_enclosures  INTEGER(1)  NOT NULL DEFAULT 0 CHECK (has_enclosures >= 0 AND has_enclosures <= 1),
+  
+  INDEX ArchivedMessagesFeedDate (account_id, feed(255), date_created),
+  INDEX ArchivedMessagesCustomId (account_id, custom_id(255)),
+  FULLTEXT INDEX ArchivedMessagesFulltext (title, author)
+);
+-- !
+CREATE TABLE IF NOT EXISTS ArchivedMessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT,
+  
+  FULLTEXT INDEX ArchivedMessageBodiesFulltext (contents)
+);
\ No newline at end of file
@@ -0,0 +1,51 @@
+CREATE TABLE IF NOT EXISTS archive.Messages (
+  id              INTEGER     PRIMARY KEY,
+  is_read         INTEGER(1)  NOT NULL CHECK (is_read >= 0 AND is_read <= 1) DEFAULT 0,
+  is_deleted      INTEGER(1)  NOT NULL CHECK (is_deleted >= 0 AND is_deleted <= 1) DEFAULT 0,
+  is_important    INTEGER(1)  NOT NULL CHECK (is_important >= 0 AND is_important <= 1) DEFAULT 0,
+  feed            TEXT        NOT NULL,
+  title           TEXT        NOT NULL CHECK (title != ''),
+  url             TEXT,
+  author          TEXT,
+  date_created    INTEGER     NOT NULL CHECK (date_created != 0),
+  is_pdeleted     INTEGER(1)  NOT NULL CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1) DEFAULT 0,
+  account_id      INTEGER     NOT NULL,
+  custom_id       TEXT,
+  custom_hash     TEXT,
+  has_enclosures  INTEGER(1)  NOT NULL CHECK (has_enclosures >= 0 AND has_enclosures <= 1) DEFAULT 0
+);
+-- !
+CREATE INDEX IF NOT EXISTS archive.MessagesFeedDate ON Messages (account_id, feed, date_created);
+-- !
+CREATE INDEX IF NOT EXISTS archive.MessagesCustomId ON Messages (account_id, custom_id);
+-- !
+CREATE TABLE IF NOT EXISTS archive.MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT
+);
+-- !
+CREATE VIRTUAL TABLE IF NOT EXISTS archive.MessagesFts USING fts5(
+  title, author, contents,
+  content = ''
+);
+-- !
+/* Triggers are created again, so that archives created by older versions use current ones. */
+DROP TRIGGER IF EXISTS archive.MessagesFtsInsert;
+-- !
+DROP TRIGGER IF EXISTS archive.MessageBodiesDelete;
+-- !
+-- Compressed contents can not be indexed by triggers, application indexes them instead.
+CREATE TRIGGER IF NOT EXISTS archive.MessagesFtsInsert AFTER INSERT ON Messages
+WHEN substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''));
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS archive.MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', OLD.id, OLD.title, OLD.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), '')
+    WHERE substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), ''), 1, 6) != char(1) || 'zlib:';
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
\ No newline at end of file
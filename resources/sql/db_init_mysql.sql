@@ -12,7 +12,7 @@ CREATE TABLE IF NOT EXISTS Information (
   inf_value       TEXT        NOT NULL
 );
 -- !
-INSERT INTO Information VALUES (1, 'schema_version', '16');
+INSERT INTO Information VALUES (1, 'schema_version', '24');
 -- !
 CREATE TABLE IF NOT EXISTS Accounts (
   id              INTEGER     PRIMARY KEY,
@@ -69,6 +69,14 @@ CREATE TABLE IF NOT EXISTS GmailAccounts (
   FOREIGN KEY (id) REFERENCES Accounts (id)
 );
 -- !
+DROP TABLE IF EXISTS Icons;
+-- !
+CREATE TABLE IF NOT EXISTS Icons (
+  id              INTEGER       AUTO_INCREMENT PRIMARY KEY,
+  hash            VARCHAR(40)   NOT NULL UNIQUE, /* SHA-1 of PNG data. */
+  data            MEDIUMBLOB    NOT NULL /* PNG image. */
+);
+-- !
 DROP TABLE IF EXISTS Categories;
 -- !
 CREATE TABLE IF NOT EXISTS Categories (
@@ -80,6 +88,7 @@ CREATE TABLE IF NOT EXISTS Categories (
   icon            BLOB,
   account_id      INTEGER       NOT NULL,
   custom_id       TEXT,
+  icon_id         INTEGER, /* Icon in Icons table, "icon" column is only used by older versions. */
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
@@ -103,6 +112,7 @@ CREATE TABLE IF NOT EXISTS Feeds (
   type            INTEGER,
   account_id      INTEGER       NOT NULL,
   custom_id       TEXT,
+  icon_id         INTEGER, /* Icon in Icons table, "icon" column is only used by older versions. */
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
@@ -119,16 +129,31 @@ CREATE TABLE IF NOT EXISTS Messages (
   url             TEXT,
   author          TEXT,
   date_created    BIGINT      NOT NULL CHECK (date_created != 0),
-  contents        TEXT,
   is_pdeleted     INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1),
-  enclosures      TEXT,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
   custom_hash     TEXT,
+  has_enclosures  INTEGER(1)  NOT NULL DEFAULT 0 CHECK (has_enclosures >= 0 AND has_enclosures <= 1),
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+CREATE INDEX MessagesFeedDate ON Messages (account_id, feed(255), date_created);
+-- !
+CREATE INDEX MessagesAccountDate ON Messages (account_id, date_created);
+-- !
+CREATE INDEX MessagesAccountImportant ON Messages (account_id, is_important, date_created);
+-- !
+DROP TABLE IF EXISTS MessageBodies;
+-- !
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
 CREATE TABLE IF NOT EXISTS MessageFilters (
   id                  INTEGER     PRIMARY KEY,
   name                TEXT        NOT NULL CHECK (name != ''),
@@ -160,4 +185,86 @@ CREATE TABLE IF NOT EXISTS LabelsInMessages (
   account_id        INTEGER     NOT NULL,
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id) ON DELETE CASCADE
-);
\ No newline at end of file
+);
+-- !
+CREATE TABLE IF NOT EXISTS RetentionPolicies (
+  account_id        INTEGER     NOT NULL,
+  item_kind         INTEGER     NOT NULL, /* Kind of item, either feed or category. */
+  custom_id         VARCHAR(255) NOT NULL, /* Custom ID of item. */
+  max_age           INTEGER     NOT NULL DEFAULT 0 CHECK (max_age >= 0), /* In days, 0 means unlimited. */
+  max_count         INTEGER     NOT NULL DEFAULT 0 CHECK (max_count >= 0), /* 0 means unlimited. */
+  keep_important    INTEGER(1)  NOT NULL DEFAULT 1 CHECK (keep_important >= 0 AND keep_important <= 1),
+  
+  PRIMARY KEY (account_id, item_kind, custom_id),
+  FOREIGN KEY (account_id) REFERENCES Accounts (id) ON DELETE CASCADE
+);
+-- !
+DROP TABLE IF EXISTS FeedCounters;
+-- !
+CREATE TABLE IF NOT EXISTS FeedCounters (
+  account_id              INTEGER     NOT NULL,
+  feed                    TEXT        NOT NULL,
+  total_count             INTEGER     NOT NULL DEFAULT 0,
+  unread_count            INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count         INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count        INTEGER     NOT NULL DEFAULT 0,
+  important_total_count   INTEGER     NOT NULL DEFAULT 0,
+  important_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  
+  PRIMARY KEY (account_id, feed(255))
+);
+-- !
+CREATE TRIGGER FeedCountersInsert AFTER INSERT ON Messages
+FOR EACH ROW
+BEGIN
+  INSERT IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER FeedCountersDelete AFTER DELETE ON Messages
+FOR EACH ROW
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER FeedCountersUpdate AFTER UPDATE ON Messages
+FOR EACH ROW
+BEGIN
+  IF OLD.is_read != NEW.is_read OR OLD.is_deleted != NEW.is_deleted OR OLD.is_pdeleted != NEW.is_pdeleted OR OLD.is_important != NEW.is_important OR OLD.feed != NEW.feed OR OLD.account_id != NEW.account_id THEN
+    UPDATE FeedCounters SET
+      total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+      unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+      bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+      bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+      important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+      important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+    WHERE account_id = OLD.account_id AND feed = OLD.feed;
+    INSERT IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+    UPDATE FeedCounters SET
+      total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+      unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+      bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+      bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+      important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+      important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+    WHERE account_id = NEW.account_id AND feed = NEW.feed;
+  END IF;
+END;
+-- !
+CREATE FULLTEXT INDEX MessagesFulltext ON Messages (title, author);
+-- !
+CREATE FULLTEXT INDEX MessageBodiesFulltext ON MessageBodies (contents);
\ No newline at end of file
@@ -6,7 +6,7 @@ CREATE TABLE IF NOT EXISTS Information (
   inf_value       TEXT        NOT NULL
 );
 -- !
-INSERT INTO Information VALUES (1, 'schema_version', '16');
+INSERT INTO Information VALUES (1, 'schema_version', '24');
 -- !
 CREATE TABLE IF NOT EXISTS Accounts (
   id              INTEGER     PRIMARY KEY,
@@ -63,6 +63,14 @@ CREATE TABLE IF NOT EXISTS GmailAccounts (
   FOREIGN KEY (id) REFERENCES Accounts (id)
 );
 -- !
+DROP TABLE IF EXISTS Icons;
+-- !
+CREATE TABLE IF NOT EXISTS Icons (
+  id              INTEGER     PRIMARY KEY,
+  hash            TEXT        NOT NULL UNIQUE, /* SHA-1 of PNG data. */
+  data            BLOB        NOT NULL /* PNG image. */
+);
+-- !
 DROP TABLE IF EXISTS Categories;
 -- !
 CREATE TABLE IF NOT EXISTS Categories (
@@ -74,6 +82,7 @@ CREATE TABLE IF NOT EXISTS Categories (
   icon            BLOB,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
+  icon_id         INTEGER, /* Icon in Icons table, "icon" column is only used by older versions. */
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
@@ -97,6 +106,7 @@ CREATE TABLE IF NOT EXISTS Feeds (
   type            INTEGER,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
+  icon_id         INTEGER, /* Icon in Icons table, "icon" column is only used by older versions. */
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
@@ -113,16 +123,31 @@ CREATE TABLE IF NOT EXISTS Messages (
   url             TEXT,
   author          TEXT,
   date_created    INTEGER     NOT NULL CHECK (date_created != 0),
-  contents        TEXT,
   is_pdeleted     INTEGER(1)  NOT NULL CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1) DEFAULT 0,
-  enclosures      TEXT,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
   custom_hash     TEXT,
+  has_enclosures  INTEGER(1)  NOT NULL CHECK (has_enclosures >= 0 AND has_enclosures <= 1) DEFAULT 0,
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+CREATE INDEX IF NOT EXISTS MessagesFeedDate ON Messages (account_id, feed, date_created);
+-- !
+CREATE INDEX IF NOT EXISTS MessagesAccountDate ON Messages (account_id, date_created);
+-- !
+CREATE INDEX IF NOT EXISTS MessagesAccountImportant ON Messages (account_id, is_important, date_created);
+-- !
+DROP TABLE IF EXISTS MessageBodies;
+-- !
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
 CREATE TABLE IF NOT EXISTS MessageFilters (
   id                  INTEGER     PRIMARY KEY,
   name                TEXT        NOT NULL CHECK (name != ''),
@@ -154,4 +179,136 @@ CREATE TABLE IF NOT EXISTS LabelsInMessages (
   account_id        INTEGER     NOT NULL,
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id) ON DELETE CASCADE
-);
\ No newline at end of file
+);
+-- !
+CREATE TABLE IF NOT EXISTS RetentionPolicies (
+  account_id        INTEGER     NOT NULL,
+  item_kind         INTEGER     NOT NULL, /* Kind of item, either feed or category. */
+  custom_id         TEXT        NOT NULL, /* Custom ID of item. */
+  max_age           INTEGER     NOT NULL DEFAULT 0 CHECK (max_age >= 0), /* In days, 0 means unlimited. */
+  max_count         INTEGER     NOT NULL DEFAULT 0 CHECK (max_count >= 0), /* 0 means unlimited. */
+  keep_important    INTEGER(1)  NOT NULL DEFAULT 1 CHECK (keep_important >= 0 AND keep_important <= 1),
+  
+  PRIMARY KEY (account_id, item_kind, custom_id),
+  FOREIGN KEY (account_id) REFERENCES Accounts (id) ON DELETE CASCADE
+);
+-- !
+DROP TABLE IF EXISTS FeedCounters;
+-- !
+CREATE TABLE IF NOT EXISTS FeedCounters (
+  account_id              INTEGER     NOT NULL,
+  feed                    TEXT        NOT NULL,
+  total_count             INTEGER     NOT NULL DEFAULT 0,
+  unread_count            INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count         INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count        INTEGER     NOT NULL DEFAULT 0,
+  important_total_count   INTEGER     NOT NULL DEFAULT 0,
+  important_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  
+  PRIMARY KEY (account_id, feed)
+);
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT OR IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersDelete AFTER DELETE ON Messages
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersUpdate AFTER UPDATE OF is_read, is_deleted, is_pdeleted, is_important, feed, account_id ON Messages
+WHEN OLD.is_read != NEW.is_read OR OLD.is_deleted != NEW.is_deleted OR OLD.is_pdeleted != NEW.is_pdeleted OR OLD.is_important != NEW.is_important OR OLD.feed != NEW.feed OR OLD.account_id != NEW.account_id
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT OR IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+DROP TABLE IF EXISTS MessagesFts;
+-- !
+CREATE VIRTUAL TABLE IF NOT EXISTS MessagesFts USING fts5(
+  title, author, contents,
+  content = ''
+);
+-- !
+-- Compressed contents can not be indexed by triggers, application indexes them instead,
+-- so triggers do not change index entries of messages while their contents are compressed.
+CREATE TRIGGER IF NOT EXISTS MessagesFtsInsert AFTER INSERT ON Messages
+WHEN substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''));
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsUpdate AFTER UPDATE OF title, author ON Messages
+WHEN substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), ''));
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''));
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', OLD.id, OLD.title, OLD.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), '')
+    WHERE substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), ''), 1, 6) != char(1) || 'zlib:';
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsInsert AFTER INSERT ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id) AND substr(coalesce(NEW.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, '' FROM Messages WHERE id = NEW.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, coalesce(NEW.contents, '') FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsUpdate AFTER UPDATE OF contents ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id) AND
+     substr(coalesce(OLD.contents, ''), 1, 6) != char(1) || 'zlib:' AND substr(coalesce(NEW.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, coalesce(OLD.contents, '') FROM Messages WHERE id = OLD.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, coalesce(NEW.contents, '') FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsDelete AFTER DELETE ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = OLD.message_id) AND substr(coalesce(OLD.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, coalesce(OLD.contents, '') FROM Messages WHERE id = OLD.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, '' FROM Messages WHERE id = OLD.message_id;
+END;
\ No newline at end of file
@@ -0,0 +1,76 @@
+CREATE TABLE IF NOT EXISTS FeedCounters (
+  account_id              INTEGER     NOT NULL,
+  feed                    TEXT        NOT NULL,
+  total_count             INTEGER     NOT NULL DEFAULT 0,
+  unread_count            INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count         INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count        INTEGER     NOT NULL DEFAULT 0,
+  important_total_count   INTEGER     NOT NULL DEFAULT 0,
+  important_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  
+  PRIMARY KEY (account_id, feed(255))
+);
+-- !
+INSERT INTO FeedCounters (account_id, feed, total_count, unread_count, bin_total_count, bin_unread_count, important_total_count, important_unread_count)
+SELECT account_id, feed,
+       sum(Messages.is_deleted = 0 AND Messages.is_pdeleted = 0),
+       sum(Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.is_read = 0),
+       sum(Messages.is_deleted = 1 AND Messages.is_pdeleted = 0),
+       sum(Messages.is_deleted = 1 AND Messages.is_pdeleted = 0 AND Messages.is_read = 0),
+       sum(Messages.is_important = 1 AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0),
+       sum(Messages.is_important = 1 AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.is_read = 0)
+FROM Messages
+GROUP BY account_id, feed;
+-- !
+CREATE TRIGGER FeedCountersInsert AFTER INSERT ON Messages
+FOR EACH ROW
+BEGIN
+  INSERT IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER FeedCountersDelete AFTER DELETE ON Messages
+FOR EACH ROW
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER FeedCountersUpdate AFTER UPDATE ON Messages
+FOR EACH ROW
+BEGIN
+  IF OLD.is_read != NEW.is_read OR OLD.is_deleted != NEW.is_deleted OR OLD.is_pdeleted != NEW.is_pdeleted OR OLD.is_important != NEW.is_important OR OLD.feed != NEW.feed OR OLD.account_id != NEW.account_id THEN
+    UPDATE FeedCounters SET
+      total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+      unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+      bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+      bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+      important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+      important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+    WHERE account_id = OLD.account_id AND feed = OLD.feed;
+    INSERT IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+    UPDATE FeedCounters SET
+      total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+      unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+      bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+      bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+      important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+      important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+    WHERE account_id = NEW.account_id AND feed = NEW.feed;
+  END IF;
+END;
+-- !
+UPDATE Information SET inf_value = '17' WHERE inf_key = 'schema_version';
\ No newline at end of file
@@ -0,0 +1,24 @@
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+INSERT INTO MessageBodies (message_id, enclosures, contents)
+SELECT id, enclosures, contents FROM Messages;
+-- !
+ALTER TABLE Messages ADD COLUMN has_enclosures INTEGER(1) NOT NULL DEFAULT 0 CHECK (has_enclosures >= 0 AND has_enclosures <= 1);
+-- !
+UPDATE Messages SET has_enclosures = 1 WHERE length(enclosures) > 10;
+-- !
+DROP INDEX MessagesFulltext ON Messages;
+-- !
+ALTER TABLE Messages DROP COLUMN contents, DROP COLUMN enclosures;
+-- !
+CREATE FULLTEXT INDEX MessagesFulltext ON Messages (title, author);
+-- !
+CREATE FULLTEXT INDEX MessageBodiesFulltext ON MessageBodies (contents);
+-- !
+UPDATE Information SET inf_value = '20' WHERE inf_key = 'schema_version';
\ No newline at end of file
@@ -0,0 +1,11 @@
+CREATE TABLE IF NOT EXISTS Icons (
+  id              INTEGER       AUTO_INCREMENT PRIMARY KEY,
+  hash            VARCHAR(40)   NOT NULL UNIQUE, /* SHA-1 of PNG data. */
+  data            MEDIUMBLOB    NOT NULL /* PNG image. */
+);
+-- !
+ALTER TABLE Categories ADD COLUMN icon_id INTEGER;
+-- !
+ALTER TABLE Feeds ADD COLUMN icon_id INTEGER;
+-- !
+UPDATE Information SET inf_value = '22' WHERE inf_key = 'schema_version';
\ No newline at end of file
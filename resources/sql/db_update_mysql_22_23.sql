@@ -0,0 +1,5 @@
+CREATE INDEX MessagesAccountDate ON Messages (account_id, date_created);
+-- !
+CREATE INDEX MessagesAccountImportant ON Messages (account_id, is_important, date_created);
+-- !
+UPDATE Information SET inf_value = '23' WHERE inf_key = 'schema_version';
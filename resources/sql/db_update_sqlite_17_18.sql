@@ -0,0 +1,24 @@
+CREATE VIRTUAL TABLE IF NOT EXISTS MessagesFts USING fts5(
+  title, author, contents,
+  content = 'Messages', content_rowid = 'id'
+);
+-- !
+INSERT INTO MessagesFts (MessagesFts) VALUES ('rebuild');
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, NEW.contents);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, OLD.contents);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsUpdate AFTER UPDATE OF title, author, contents ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, OLD.contents);
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, NEW.contents);
+END;
+-- !
+UPDATE Information SET inf_value = '18' WHERE inf_key = 'schema_version';
\ No newline at end of file
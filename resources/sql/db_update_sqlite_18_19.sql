@@ -0,0 +1,23 @@
+DROP TRIGGER IF EXISTS MessagesFtsInsert;
+-- !
+DROP TRIGGER IF EXISTS MessagesFtsDelete;
+-- !
+DROP TRIGGER IF EXISTS MessagesFtsUpdate;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, CASE WHEN substr(NEW.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE NEW.contents END);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, CASE WHEN substr(OLD.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE OLD.contents END);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsUpdate AFTER UPDATE OF title, author, contents ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, CASE WHEN substr(OLD.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE OLD.contents END);
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, CASE WHEN substr(NEW.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE NEW.contents END);
+END;
+-- !
+UPDATE Information SET inf_value = '19' WHERE inf_key = 'schema_version';
\ No newline at end of file
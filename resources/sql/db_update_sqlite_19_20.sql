@@ -0,0 +1,133 @@
+DROP TABLE IF EXISTS MessagesFts;
+-- !
+CREATE TABLE backup_Messages AS SELECT * FROM Messages;
+-- !
+DROP TABLE Messages;
+-- !
+CREATE TABLE IF NOT EXISTS Messages (
+  id              INTEGER     PRIMARY KEY,
+  is_read         INTEGER(1)  NOT NULL CHECK (is_read >= 0 AND is_read <= 1) DEFAULT 0,
+  is_deleted      INTEGER(1)  NOT NULL CHECK (is_deleted >= 0 AND is_deleted <= 1) DEFAULT 0,
+  is_important    INTEGER(1)  NOT NULL CHECK (is_important >= 0 AND is_important <= 1) DEFAULT 0,
+  feed            TEXT        NOT NULL,
+  title           TEXT        NOT NULL CHECK (title != ''),
+  url             TEXT,
+  author          TEXT,
+  date_created    INTEGER     NOT NULL CHECK (date_created != 0),
+  is_pdeleted     INTEGER(1)  NOT NULL CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1) DEFAULT 0,
+  account_id      INTEGER     NOT NULL,
+  custom_id       TEXT,
+  custom_hash     TEXT,
+  has_enclosures  INTEGER(1)  NOT NULL CHECK (has_enclosures >= 0 AND has_enclosures <= 1) DEFAULT 0,
+  
+  FOREIGN KEY (account_id) REFERENCES Accounts (id)
+);
+-- !
+INSERT INTO Messages (id, is_read, is_deleted, is_important, feed, title, url, author, date_created, is_pdeleted, account_id, custom_id, custom_hash, has_enclosures)
+SELECT id, is_read, is_deleted, is_important, feed, title, url, author, date_created, is_pdeleted, account_id, custom_id, custom_hash, CASE WHEN length(enclosures) > 10 THEN 1 ELSE 0 END FROM backup_Messages;
+-- !
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  enclosures      TEXT,
+  contents        TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+INSERT INTO MessageBodies (message_id, enclosures, contents)
+SELECT id, enclosures, contents FROM backup_Messages;
+-- !
+DROP TABLE backup_Messages;
+-- !
+CREATE VIRTUAL TABLE IF NOT EXISTS MessagesFts USING fts5(
+  title, author, contents,
+  content = ''
+);
+-- !
+INSERT INTO MessagesFts (rowid, title, author, contents)
+SELECT Messages.id, Messages.title, Messages.author, CASE WHEN substr(MessageBodies.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce(MessageBodies.contents, '') END
+FROM Messages LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id;
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT OR IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersDelete AFTER DELETE ON Messages
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS FeedCountersUpdate AFTER UPDATE OF is_read, is_deleted, is_pdeleted, is_important, feed, account_id ON Messages
+WHEN OLD.is_read != NEW.is_read OR OLD.is_deleted != NEW.is_deleted OR OLD.is_pdeleted != NEW.is_pdeleted OR OLD.is_important != NEW.is_important OR OLD.feed != NEW.feed OR OLD.account_id != NEW.account_id
+BEGIN
+  UPDATE FeedCounters SET
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    important_total_count = important_total_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    important_unread_count = important_unread_count - (OLD.is_important = 1 AND OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT OR IGNORE INTO FeedCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE FeedCounters SET
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    important_total_count = important_total_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    important_unread_count = important_unread_count + (NEW.is_important = 1 AND NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, CASE WHEN substr((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), '') END);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsUpdate AFTER UPDATE OF title, author ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, CASE WHEN substr((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), '') END);
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, CASE WHEN substr((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), '') END);
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, CASE WHEN substr((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), '') END);
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsInsert AFTER INSERT ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id)
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, '' FROM Messages WHERE id = NEW.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, CASE WHEN substr(NEW.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce(NEW.contents, '') END FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsUpdate AFTER UPDATE OF contents ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id)
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, CASE WHEN substr(OLD.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce(OLD.contents, '') END FROM Messages WHERE id = OLD.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, CASE WHEN substr(NEW.contents, 1, 6) = char(1) || 'zlib:' THEN '' ELSE coalesce(NEW.contents, '') END FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+UPDATE Information SET inf_value = '20' WHERE inf_key = 'schema_version';
\ No newline at end of file
@@ -0,0 +1,15 @@
+CREATE INDEX IF NOT EXISTS MessagesFeedDate ON Messages (account_id, feed, date_created);
+-- !
+CREATE TABLE IF NOT EXISTS RetentionPolicies (
+  account_id        INTEGER     NOT NULL,
+  item_kind         INTEGER     NOT NULL, /* Kind of item, either feed or category. */
+  custom_id         TEXT        NOT NULL, /* Custom ID of item. */
+  max_age           INTEGER     NOT NULL DEFAULT 0 CHECK (max_age >= 0), /* In days, 0 means unlimited. */
+  max_count         INTEGER     NOT NULL DEFAULT 0 CHECK (max_count >= 0), /* 0 means unlimited. */
+  keep_important    INTEGER(1)  NOT NULL DEFAULT 1 CHECK (keep_important >= 0 AND keep_important <= 1),
+  
+  PRIMARY KEY (account_id, item_kind, custom_id),
+  FOREIGN KEY (account_id) REFERENCES Accounts (id) ON DELETE CASCADE
+);
+-- !
+UPDATE Information SET inf_value = '21' WHERE inf_key = 'schema_version';
\ No newline at end of file
@@ -0,0 +1,62 @@
+DROP TRIGGER IF EXISTS MessagesFtsInsert;
+-- !
+DROP TRIGGER IF EXISTS MessagesFtsUpdate;
+-- !
+DROP TRIGGER IF EXISTS MessageBodiesDelete;
+-- !
+DROP TRIGGER IF EXISTS MessageBodiesFtsInsert;
+-- !
+DROP TRIGGER IF EXISTS MessageBodiesFtsUpdate;
+-- !
+-- Compressed contents can not be indexed by triggers, application indexes them instead,
+-- so triggers do not change index entries of messages while their contents are compressed.
+CREATE TRIGGER IF NOT EXISTS MessagesFtsInsert AFTER INSERT ON Messages
+WHEN substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''));
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessagesFtsUpdate AFTER UPDATE OF title, author ON Messages
+WHEN substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents) VALUES ('delete', OLD.id, OLD.title, OLD.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), ''));
+  INSERT INTO MessagesFts (rowid, title, author, contents) VALUES (NEW.id, NEW.title, NEW.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = NEW.id), ''));
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', OLD.id, OLD.title, OLD.author, coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), '')
+    WHERE substr(coalesce((SELECT contents FROM MessageBodies WHERE message_id = OLD.id), ''), 1, 6) != char(1) || 'zlib:';
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsInsert AFTER INSERT ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id) AND substr(coalesce(NEW.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, '' FROM Messages WHERE id = NEW.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, coalesce(NEW.contents, '') FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsUpdate AFTER UPDATE OF contents ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = NEW.message_id) AND
+     substr(coalesce(OLD.contents, ''), 1, 6) != char(1) || 'zlib:' AND substr(coalesce(NEW.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, coalesce(OLD.contents, '') FROM Messages WHERE id = OLD.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, coalesce(NEW.contents, '') FROM Messages WHERE id = NEW.message_id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesFtsDelete AFTER DELETE ON MessageBodies
+WHEN EXISTS (SELECT 1 FROM Messages WHERE id = OLD.message_id) AND substr(coalesce(OLD.contents, ''), 1, 6) != char(1) || 'zlib:'
+BEGIN
+  INSERT INTO MessagesFts (MessagesFts, rowid, title, author, contents)
+    SELECT 'delete', id, title, author, coalesce(OLD.contents, '') FROM Messages WHERE id = OLD.message_id;
+  INSERT INTO MessagesFts (rowid, title, author, contents)
+    SELECT id, title, author, '' FROM Messages WHERE id = OLD.message_id;
+END;
+-- !
+UPDATE Information SET inf_value = '24' WHERE inf_key = 'schema_version';
\ No newline at end of file
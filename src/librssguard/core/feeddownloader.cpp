@@ -68,6 +68,7 @@ void FeedDownloader::updateFeeds(const QList<Feed *> &feeds)
         m_feeds = feeds;
         m_feedsOriginalCount = m_feeds.size();
         m_results.clear();
+        m_pendingWrites.clear();
         m_feedsUpdated = 0;
 
         // Job starts now.
@@ -263,15 +264,14 @@ void FeedDownloader::updateOneFeed(Feed *feed)
              "' in thread: '"
              << QThread::currentThreadId() << "'.";
 
-    int updated_messages = feed->updateMessages(msgs, error_during_obtaining);
+    // Messages are written while next feeds are downloaded,
+    // results are collected when whole update finishes.
+    PendingWrite pending;
 
-    qDebugNN << LOGSEC_FEEDDOWNLOADER
-             << updated_messages << " messages for feed "
-             << feed->customId() << " stored in DB.";
-
-    if (updated_messages > 0) {
-        m_results.appendUpdatedFeed(QPair<QString, int>(feed->title(), updated_messages));
-    }
+    pending.m_feedTitle = feed->title();
+    pending.m_updatedMessages = QSharedPointer<int>(new int(0));
+    pending.m_write = feed->updateMessages(msgs, error_during_obtaining, pending.m_updatedMessages);
+    m_pendingWrites.append(pending);
 
     qDebugNN << LOGSEC_FEEDDOWNLOADER
              << "Made progress in feed updates, total feeds count "
@@ -284,6 +284,21 @@ void FeedDownloader::finalizeUpdate()
 {
     qDebugNN << LOGSEC_FEEDDOWNLOADER << "Finished feed updates in thread: '" <<
              QThread::currentThreadId() << "'.";
+
+    // Wait for messages of all feeds, writer commits them together.
+    for (const PendingWrite &pending : m_pendingWrites) {
+        const int updated_messages = pending.m_write.result() ? *pending.m_updatedMessages : 0;
+
+        qDebugNN << LOGSEC_FEEDDOWNLOADER
+                 << updated_messages << " messages for feed '"
+                 << pending.m_feedTitle << "' stored in DB.";
+
+        if (updated_messages > 0) {
+            m_results.appendUpdatedFeed(QPair<QString, int>(pending.m_feedTitle, updated_messages));
+        }
+    }
+
+    m_pendingWrites.clear();
     m_results.sort();
 
     // Update of feeds has finished.
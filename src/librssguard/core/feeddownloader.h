@@ -5,7 +5,9 @@
 
 #include <QObject>
 
+#include <QFuture>
 #include <QPair>
+#include <QSharedPointer>
 
 #include "core/message.h"
 
@@ -56,7 +58,15 @@ private:
     void updateAvailableFeeds();
     void finalizeUpdate();
 
+    // Messages of feed, which are being written by database writer.
+    struct PendingWrite {
+        QString m_feedTitle;
+        QFuture<bool> m_write;
+        QSharedPointer<int> m_updatedMessages;
+    };
+
     QList<Feed *> m_feeds;
+    QList<PendingWrite> m_pendingWrites;
     QMutex *m_mutex;
     FeedDownloadResults m_results;
     int m_feedsUpdated;
@@ -6,6 +6,7 @@
 #include "definitions/definitions.h"
 #include "gui/dialogs/formmain.h"
 #include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databasequeries.h"
 #include "miscellaneous/feedreader.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/textfactory.h"
@@ -567,12 +568,29 @@ bool FeedsModel::emptyAllBins()
 
 void FeedsModel::loadActivatedServiceAccounts()
 {
+    // Icons are moved to icon store before items are loaded,
+    // so that loaded items do not need to decode them.
+    QSqlDatabase database = qApp->database()->connection(metaObject()->className());
+
+    DatabaseQueries::migrateLegacyIcons(database);
+    DatabaseQueries::purgeUnusedIcons(database);
+
+    // Counts of messages of all accounts are loaded at once, accounts
+    // then use them instead of querying their counts one by one.
+    bool counts_ok;
+    const QHash<int, QHash<QString, MessageCounts>> counts =
+        DatabaseQueries::getMessageCountsForAllAccounts(database, &counts_ok);
+
     // Iterate all globally available feed "service plugins".
     for (const ServiceEntryPoint *entry_point : qApp->feedReader()->feedServices()) {
         // Load all stored root nodes from the entry point and add those to the model.
         QList<ServiceRoot *>roots = entry_point->initializeSubtree();
 
         for (ServiceRoot *root : roots) {
+            if (counts_ok) {
+                root->setPreloadedCounts(counts.value(root->accountId()));
+            }
+
             addServiceAccount(root, false);
         }
     }
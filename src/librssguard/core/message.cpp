@@ -85,7 +85,7 @@ Message Message::fromSqlRecord(const QSqlRecord &record, bool *result)
     message.m_url = record.value(MSG_DB_URL_INDEX).toString();
     message.m_author = record.value(MSG_DB_AUTHOR_INDEX).toString();
     message.m_created = TextFactory::parseDateTime(record.value(MSG_DB_DCREATED_INDEX).value<qint64>());
-    message.m_contents = record.value(MSG_DB_CONTENTS_INDEX).toString();
+    message.m_contents = decompressContents(record.value(MSG_DB_CONTENTS_INDEX).toString());
     message.m_enclosures = Enclosures::decodeEnclosuresFromString(record.value(
                                MSG_DB_ENCLOSURES_INDEX).toString());
     message.m_accountId = record.value(MSG_DB_ACCOUNT_ID_INDEX).toInt();
@@ -99,6 +99,39 @@ Message Message::fromSqlRecord(const QSqlRecord &record, bool *result)
     return message;
 }
 
+QString Message::compressContents(const QString &contents)
+{
+    if (contents.size() < MSG_COMPRESSED_CONTENTS_MIN_LENGTH || isCompressedContents(contents)) {
+        return contents;
+    }
+
+    const QByteArray plain = contents.toUtf8();
+    const QByteArray compressed = qCompress(plain, 9).toBase64();
+
+    // Do not bother with contents which do not shrink enough.
+    if (compressed.size() + QL1S(MSG_COMPRESSED_CONTENTS_MARKER).size() >= plain.size()) {
+        return contents;
+    } else {
+        return QL1S(MSG_COMPRESSED_CONTENTS_MARKER) + QString::fromLatin1(compressed);
+    }
+}
+
+QString Message::decompressContents(const QString &contents)
+{
+    if (!isCompressedContents(contents)) {
+        return contents;
+    }
+
+    const QByteArray compressed = QByteArray::fromBase64(contents.mid(QL1S(MSG_COMPRESSED_CONTENTS_MARKER).size()).toLatin1());
+
+    return QString::fromUtf8(qUncompress(compressed));
+}
+
+bool Message::isCompressedContents(const QString &contents)
+{
+    return contents.startsWith(QL1S(MSG_COMPRESSED_CONTENTS_MARKER));
+}
+
 QDataStream &operator<<(QDataStream &out, const Message &myObj)
 {
     out << myObj.m_accountId
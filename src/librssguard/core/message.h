@@ -38,6 +38,13 @@ public:
     // Creates Message from given record, which contains
     // row from query SELECT * FROM Messages WHERE ....;
     static Message fromSqlRecord(const QSqlRecord &record, bool *result = nullptr);
+
+    // Compressed contents are stored with marker prefix, so that
+    // compressed and plain rows can live in the same column.
+    static QString compressContents(const QString &contents);
+    static QString decompressContents(const QString &contents);
+    static bool isCompressedContents(const QString &contents);
+
     QString m_title;
     QString m_url;
     QString m_author;
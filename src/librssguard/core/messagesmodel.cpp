@@ -6,21 +6,36 @@
 #include "definitions/definitions.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databaseprofiler.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/skinfactory.h"
 #include "miscellaneous/textfactory.h"
 #include "services/abstract/recyclebin.h"
 #include "services/abstract/serviceroot.h"
 
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QPointer>
 #include <QSqlError>
 #include <QSqlField>
+#include <QSqlQuery>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
 
 MessagesModel::MessagesModel(QObject *parent)
-    : QSqlQueryModel(parent), m_cache(new MessagesModelCache(this)),
+    : QAbstractTableModel(parent), m_cache(new MessagesModelCache(this)),
       m_messageHighlighter(MessageHighlighter::NoHighlighting),
       m_customDateFormat(QString()), m_selectedItem(nullptr), m_itemHeight(-1)
 {
+    m_loadGeneration = 0;
+    m_isLoading = false;
+    m_loader.setMaxThreadCount(1);
+    m_loader.setExpiryTimeout(-1);
+
     setupFonts();
     setupIcons();
     setupHeaderData();
@@ -31,6 +46,10 @@ MessagesModel::MessagesModel(QObject *parent)
 MessagesModel::~MessagesModel()
 {
     qDebugNN << LOGSEC_MESSAGEMODEL << "Destroying MessagesModel instance.";
+
+    // Cancel running fetch.
+    m_loadGeneration++;
+    m_loader.waitForDone();
 }
 
 void MessagesModel::setupIcons()
@@ -48,24 +67,294 @@ MessagesModelCache *MessagesModel::cache() const
 
 void MessagesModel::repopulate()
 {
-    m_cache->clear();
-    setQuery(selectStatement(), m_db);
+    loadInBackground(false);
+}
+
+void MessagesModel::refreshMessages()
+{
+    loadInBackground(true);
+}
+
+void MessagesModel::loadInBackground(bool incremental)
+{
+    if (incremental && m_isLoading) {
+        // Listed messages are going to be replaced by fetch
+        // which is running, so refresh can not be applied to them.
+        incremental = false;
+    }
+
+    if (showUnreadOnly()) {
+        // Messages which were changed in the list are still shown,
+        // even if they are read now.
+        QVector<int> changed_ids;
+
+        for (int row : m_cache->changedRows()) {
+            changed_ids.append(m_ids.at(row));
+        }
+
+        keepMessages(changed_ids);
+    }
+
+    const QString statement = idsStatement();
+    const QStringList kept_ids = showUnreadOnly() ? keptMessages() : QStringList();
+    const int generation = ++m_loadGeneration;
+    auto *watcher = new QFutureWatcher<LoadedIds>(this);
+
+    connect(watcher, &QFutureWatcher<LoadedIds>::finished, this, [this, watcher, generation]() {
+        watcher->deleteLater();
 
-    if (lastError().isValid()) {
+        if (generation != m_loadGeneration) {
+            // Newer fetch was requested, its result will be used instead.
+            return;
+        }
+
+        const LoadedIds loaded = watcher->result();
+
+        if (loaded.m_isDelta) {
+            applyDelta(loaded);
+        } else {
+            // Whole result is swapped into the model at once.
+            beginResetModel();
+            m_ids = loaded.m_ids;
+            m_rowsById = loaded.m_rows;
+            m_unreadRows = loaded.m_unreadRows;
+            m_cache->clear(m_ids.size());
+            endResetModel();
+        }
+
+        if (showUnreadOnly()) {
+            // Kept messages which are not listed anymore
+            // would only make the statement slower.
+            retainKeptMessages(m_rowsById);
+        }
+
+        m_isLoading = false;
+        emit loadingFinished();
+    });
+
+    const QHash<int, int> listed_rows = incremental ? m_rowsById : QHash<int, int>();
+    const int listed_count = m_ids.size();
+
+    watcher->setFuture(QtConcurrent::run(&m_loader, [this, statement, kept_ids, generation, incremental,
+                                                     listed_rows, listed_count]() {
+        LoadedIds loaded = loadIds(statement, kept_ids, generation);
+
+        if (incremental && generation == m_loadGeneration) {
+            compareIds(listed_rows, listed_count, loaded);
+        }
+
+        return loaded;
+    }));
+
+    if (!m_isLoading) {
+        m_isLoading = true;
+        emit loadingStarted();
+    }
+}
+
+bool MessagesModel::isLoading() const
+{
+    return m_isLoading;
+}
+
+MessagesModel::LoadedIds MessagesModel::loadIds(const QString &statement, const QStringList &kept_ids,
+                                                int generation) const
+{
+    LoadedIds loaded;
+    QVector<int> &ids = loaded.m_ids;
+
+    if (generation != m_loadGeneration) {
+        // This fetch was superseded while it was waiting.
+        return loaded;
+    }
+
+    QSqlDatabase database = qApp->database()->connection(QSL("MessagesModelLoader"));
+    QElapsedTimer timer;
+    QSqlQuery q(database);
+
+    if (!kept_ids.isEmpty()) {
+        storeKeptMessages(database, kept_ids);
+    }
+
+    DatabaseProfiler::explain(database, QSL("MessagesModel::repopulate"), statement);
+    timer.start();
+    q.setForwardOnly(true);
+
+    if (q.exec(statement)) {
+        while (q.next()) {
+            if (ids.size() % MSG_MODEL_PAGE_SIZE == 0 && generation != m_loadGeneration) {
+                qDebugNN << LOGSEC_MESSAGEMODEL << "Fetching of messages was cancelled.";
+                return LoadedIds();
+            }
+
+            if (!q.value(1).toBool()) {
+                loaded.m_unreadRows.append(ids.size());
+            }
+
+            ids.append(q.value(0).toInt());
+        }
+    } else {
         qCriticalNN << LOGSEC_MESSAGEMODEL << "Error when setting new msg view query: '" <<
-                    lastError().text() << "'.";
-        qCriticalNN << LOGSEC_MESSAGEMODEL << "Used SQL select statement: '" << selectStatement() << "'.";
+                    q.lastError().text() << "'.";
+        qCriticalNN << LOGSEC_MESSAGEMODEL << "Used SQL select statement: '" << statement << "'.";
+    }
+
+    if (DatabaseProfiler::isEnabled()) {
+        // Measured time includes fetching of all IDs.
+        DatabaseProfiler::record(QSL("MessagesModel::repopulate"), statement,
+                                 timer.nsecsElapsed() / 1000, 0, !q.lastError().isValid());
     }
 
-    while (canFetchMore()) {
-        fetchMore();
+    // Rows of messages are looked up by their IDs when messages
+    // are changed outside of the list.
+    loaded.m_rows.reserve(ids.size());
+
+    for (int i = 0; i < ids.size(); i++) {
+        loaded.m_rows.insert(ids.at(i), i);
     }
+
+    return loaded;
+}
+
+void MessagesModel::compareIds(const QHash<int, int> &listed_rows, int listed_count, LoadedIds &loaded)
+{
+    QBitArray kept_rows(listed_count);
+    int last_row = -1;
+
+    for (int i = 0; i < loaded.m_ids.size(); i++) {
+        const int row = listed_rows.value(loaded.m_ids.at(i), -1);
+
+        if (row < 0) {
+            loaded.m_insertedRows.append(i);
+        } else if (row > last_row) {
+            kept_rows.setBit(row);
+            last_row = row;
+        } else {
+            // Messages were reordered, whole list is replaced.
+            loaded.m_insertedRows.clear();
+            return;
+        }
+    }
+
+    for (int i = 0; i < listed_count; i++) {
+        if (!kept_rows.testBit(i)) {
+            loaded.m_removedRows.append(i);
+        }
+    }
+
+    loaded.m_isDelta = true;
+}
+
+void MessagesModel::applyDelta(const LoadedIds &loaded)
+{
+    const QVector<int> &removed = loaded.m_removedRows;
+    const QVector<int> &inserted = loaded.m_insertedRows;
+
+    // Rows are removed from the bottom, so that rows
+    // of next removed blocks stay valid.
+    for (int i = removed.size() - 1; i >= 0;) {
+        const int last = removed.at(i);
+        int first = last;
+
+        while (i > 0 && removed.at(i - 1) == first - 1) {
+            first = removed.at(--i);
+        }
+
+        i--;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_ids.remove(first, last - first + 1);
+        m_cache->removeRows(first, last - first + 1);
+        endRemoveRows();
+    }
+
+    for (int i = 0; i < inserted.size();) {
+        const int first = inserted.at(i);
+        int last = first;
+
+        while (i + 1 < inserted.size() && inserted.at(i + 1) == last + 1) {
+            last = inserted.at(++i);
+        }
+
+        i++;
+
+        beginInsertRows(QModelIndex(), first, last);
+        m_ids.insert(first, last - first + 1, 0);
+        std::copy(loaded.m_ids.constBegin() + first, loaded.m_ids.constBegin() + last + 1, m_ids.begin() + first);
+        m_cache->insertRows(first, last - first + 1);
+        endInsertRows();
+    }
+
+    m_ids = loaded.m_ids;
+    m_rowsById = loaded.m_rows;
+    m_unreadRows = loaded.m_unreadRows;
+
+    // Remaining rows are loaded again when they are displayed,
+    // so that they show changes done by the update.
+    m_cache->dropPages();
+
+    if (!m_ids.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_ids.size() - 1, MSG_DB_CUSTOM_HASH_INDEX));
+    }
+}
+
+bool MessagesModel::ensureRowLoaded(int row_index) const
+{
+    if (row_index < 0 || row_index >= m_ids.size()) {
+        return false;
+    }
+
+    const int page_index = row_index / MSG_MODEL_PAGE_SIZE;
+
+    if (m_cache->containsPage(page_index)) {
+        return true;
+    }
+
+    const QVector<int> ids = m_ids.mid(page_index * MSG_MODEL_PAGE_SIZE, MSG_MODEL_PAGE_SIZE);
+    QSqlQuery q(m_db);
+
+    q.setForwardOnly(true);
+
+    if (!DB_EXEC_SQL(q, rowsStatement(ids))) {
+        qCriticalNN << LOGSEC_MESSAGEMODEL << "Error when loading page of messages: '" <<
+                    q.lastError().text() << "'.";
+    }
+
+    // Page is stored even if it failed, so that it is not loaded over and over.
+    m_cache->insertPage(page_index, ids, q);
+    return true;
+}
+
+QVariant MessagesModel::rawData(int row_index, int column) const
+{
+    if (!ensureRowLoaded(row_index)) {
+        return QVariant();
+    }
+
+    return column == MSG_DB_ID_INDEX ? QVariant(m_ids.at(row_index)) : m_cache->data(row_index, column);
+}
+
+int MessagesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_ids.size();
+}
+
+int MessagesModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : MSG_DB_HAS_ENCLOSURES + 1;
 }
 
 bool MessagesModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
     Q_UNUSED(role)
-    m_cache->setData(index, value, record(index.row()));
+
+    // NOTE: Row does not have to be loaded, changed
+    // state is combined with the row when it is loaded.
+    if (index.row() < 0 || index.row() >= m_ids.size()) {
+        return false;
+    }
+
+    setCachedData(index.row(), index.column(), value);
     return true;
 }
 
@@ -97,6 +386,7 @@ void MessagesModel::setupFonts()
 void MessagesModel::loadMessages(RootItem *item)
 {
     m_selectedItem = item;
+    clearKeptMessages();
 
     if (item == nullptr) {
         setFilter(QSL(DEFAULT_SQL_MESSAGES_FILTER));
@@ -119,21 +409,47 @@ void MessagesModel::loadMessages(RootItem *item)
 
 bool MessagesModel::setMessageImportantById(int id, RootItem::Importance important)
 {
-    for (int i = 0; i < rowCount(); i++) {
-        int found_id = data(i, MSG_DB_ID_INDEX, Qt::EditRole).toInt();
+    return setMessagesImportantById(QList<int>() << id, important);
+}
 
-        if (found_id == id) {
-            bool set = setData(index(i, MSG_DB_IMPORTANT_INDEX), int(important));
+bool MessagesModel::setMessagesImportantById(const QList<int> &ids, RootItem::Importance important)
+{
+    return setMessagesDataById(ids, MSG_DB_IMPORTANT_INDEX, int(important));
+}
 
-            if (set) {
-                emit dataChanged(index(i, 0), index(i, MSG_DB_CUSTOM_HASH_INDEX));
-            }
+bool MessagesModel::setMessagesDataById(const QList<int> &ids, int column, const QVariant &value)
+{
+    QVector<int> rows;
+
+    for (int id : ids) {
+        const int row = rowForMessageId(id);
+
+        if (row >= 0 && setData(index(row, column), value)) {
+            rows.append(row);
+        }
+    }
+
+    if (rows.isEmpty()) {
+        return false;
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
 
-            return set;
+    // Views are notified once per each block of adjacent rows.
+    int block_start = rows.first();
+
+    for (int i = 1; i <= rows.size(); i++) {
+        if (i == rows.size() || rows.at(i) != rows.at(i - 1) + 1) {
+            emit dataChanged(index(block_start, 0), index(rows.at(i - 1), MSG_DB_CUSTOM_HASH_INDEX));
+
+            if (i < rows.size()) {
+                block_start = rows.at(i);
+            }
         }
     }
 
-    return false;
+    return true;
 }
 
 void MessagesModel::highlightMessages(MessagesModel::MessageHighlighter highlight)
@@ -166,6 +482,9 @@ void MessagesModel::updateDateFormat()
     } else {
         m_customDateFormat = QString();
     }
+
+    // Dates have to be formatted again.
+    m_cache->clearDisplayData();
 }
 
 void MessagesModel::reloadWholeLayout()
@@ -176,8 +495,50 @@ void MessagesModel::reloadWholeLayout()
 
 Message MessagesModel::messageAt(int row_index) const
 {
-    return Message::fromSqlRecord(m_cache->containsData(row_index) ? m_cache->record(
-                                      row_index) : record(row_index));
+    if (!ensureRowLoaded(row_index)) {
+        return Message();
+    }
+
+    return m_cache->message(row_index, m_ids.at(row_index));
+}
+
+int MessagesModel::rowForMessageId(int id) const
+{
+    return m_rowsById.value(id, -1);
+}
+
+int MessagesModel::nextUnreadRow(int row_index) const
+{
+    auto next = std::lower_bound(m_unreadRows.constBegin(), m_unreadRows.constEnd(), row_index);
+
+    return next == m_unreadRows.constEnd() ? -1 : *next;
+}
+
+void MessagesModel::setCachedData(int row_index, int column, const QVariant &value)
+{
+    m_cache->setData(row_index, column, value);
+
+    if (column == MSG_DB_READ_INDEX) {
+        auto position = std::lower_bound(m_unreadRows.begin(), m_unreadRows.end(), row_index);
+        const bool listed = position != m_unreadRows.end() && *position == row_index;
+
+        if (value.toInt() == int(RootItem::ReadStatus::Unread) && !listed) {
+            m_unreadRows.insert(position, row_index);
+        } else if (value.toInt() == int(RootItem::ReadStatus::Read) && listed) {
+            m_unreadRows.erase(position);
+        }
+    }
+}
+
+Message MessagesModel::messageWithBodyAt(int row_index) const
+{
+    Message message = messageAt(row_index);
+
+    if (message.m_id > 0) {
+        DatabaseQueries::fillMessageBody(m_db, &message);
+    }
+
+    return message;
 }
 
 void MessagesModel::setupHeaderData()
@@ -252,6 +613,25 @@ QVariant MessagesModel::data(int row, int column, int role) const
     return data(index(row, column), role);
 }
 
+QString MessagesModel::displayText(int row_index, int column) const
+{
+    if (column == MSG_DB_DCREATED_INDEX) {
+        QDateTime dt = TextFactory::parseDateTime(rawData(row_index, column).value<qint64>()).toLocalTime();
+
+        if (m_customDateFormat.isEmpty()) {
+            return QLocale().toString(dt, QLocale::FormatType::ShortFormat);
+        } else {
+            return dt.toString(m_customDateFormat);
+        }
+    } else {
+        // Only beginning of contents is loaded, it is already decompressed.
+        const QString contents = rawData(row_index, column).toString();
+
+        // Empty text is not null, so that it is cached too.
+        return contents.isEmpty() ? QSL("") : contents.left(64).simplified() + QL1S("...");
+    }
+}
+
 QVariant MessagesModel::data(const QModelIndex &idx, int role) const
 {
     // This message is not in cache, return real data from live query.
@@ -260,34 +640,31 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const
         case Qt::DisplayRole: {
             int index_column = idx.column();
 
-            if (index_column == MSG_DB_DCREATED_INDEX) {
-                QDateTime dt = TextFactory::parseDateTime(QSqlQueryModel::data(idx,
-                               role).value<qint64>()).toLocalTime();
+            if (index_column == MSG_DB_DCREATED_INDEX || index_column == MSG_DB_CONTENTS_INDEX) {
+                // Formatting is expensive and visible rows are painted very often,
+                // so formatted texts are kept in cache.
+                QString text = m_cache->displayData(idx.row(), index_column);
 
-                if (m_customDateFormat.isEmpty()) {
-                    return QLocale().toString(dt, QLocale::FormatType::ShortFormat);
-                } else {
-                    return dt.toString(m_customDateFormat);
+                if (text.isNull()) {
+                    text = displayText(idx.row(), index_column);
+                    m_cache->setDisplayData(idx.row(), index_column, text);
                 }
-            } else if (index_column == MSG_DB_CONTENTS_INDEX) {
-                // Do not display full contents here.
-                QString contents = data(idx, Qt::EditRole).toString().mid(0, 64).simplified() + QL1S("...");
 
-                return contents;
+                return text;
             } else if (index_column == MSG_DB_AUTHOR_INDEX) {
-                const QString author_name = QSqlQueryModel::data(idx, role).toString();
+                const QString author_name = rawData(idx.row(), index_column).toString();
 
                 return author_name.isEmpty() ? QSL("-") : author_name;
             } else if (index_column != MSG_DB_IMPORTANT_INDEX && index_column != MSG_DB_READ_INDEX
                        && index_column != MSG_DB_HAS_ENCLOSURES) {
-                return QSqlQueryModel::data(idx, role);
+                return rawData(idx.row(), index_column);
             } else {
                 return QVariant();
             }
         }
 
         case Qt::EditRole:
-            return m_cache->containsData(idx.row()) ? m_cache->data(idx) : QSqlQueryModel::data(idx, role);
+            return rawData(idx.row(), idx.column());
 
         case Qt::FontRole: {
             QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
@@ -317,18 +694,14 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const
         case Qt::ForegroundRole:
             switch (m_messageHighlighter) {
                 case MessageHighlighter::HighlightImportant: {
-                    QModelIndex idx_important = index(idx.row(), MSG_DB_IMPORTANT_INDEX);
-                    QVariant dta = m_cache->containsData(idx_important.row()) ? m_cache->data(
-                                       idx_important) : QSqlQueryModel::data(idx_important);
+                    QVariant dta = rawData(idx.row(), MSG_DB_IMPORTANT_INDEX);
 
                     return dta.toInt() == 1 ?
                            qApp->skins()->currentSkin().m_colorPalette[Skin::PaletteColors::Highlight] : QVariant();
                 }
 
                 case MessageHighlighter::HighlightUnread: {
-                    QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
-                    QVariant dta = m_cache->containsData(idx_read.row()) ? m_cache->data(idx_read) :
-                                   QSqlQueryModel::data(idx_read);
+                    QVariant dta = rawData(idx.row(), MSG_DB_READ_INDEX);
 
                     return dta.toInt() == 0 ?
                            qApp->skins()->currentSkin().m_colorPalette[Skin::PaletteColors::Highlight] : QVariant();
@@ -343,20 +716,15 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const
             const int index_column = idx.column();
 
             if (index_column == MSG_DB_READ_INDEX) {
-                QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
-                QVariant dta = m_cache->containsData(idx_read.row()) ? m_cache->data(idx_read) :
-                               QSqlQueryModel::data(idx_read);
+                QVariant dta = rawData(idx.row(), MSG_DB_READ_INDEX);
 
                 return dta.toInt() == 1 ? m_readIcon : m_unreadIcon;
             } else if (index_column == MSG_DB_IMPORTANT_INDEX) {
-                QModelIndex idx_important = index(idx.row(), MSG_DB_IMPORTANT_INDEX);
-                QVariant dta = m_cache->containsData(idx_important.row()) ? m_cache->data(
-                                   idx_important) : QSqlQueryModel::data(idx_important);
+                QVariant dta = rawData(idx.row(), MSG_DB_IMPORTANT_INDEX);
 
                 return dta.toInt() == 1 ? m_favoriteIcon : QVariant();
             } else if (index_column == MSG_DB_HAS_ENCLOSURES) {
-                QModelIndex idx_important = index(idx.row(), MSG_DB_HAS_ENCLOSURES);
-                QVariant dta = QSqlQueryModel::data(idx_important);
+                QVariant dta = rawData(idx.row(), MSG_DB_HAS_ENCLOSURES);
 
                 return dta.toBool() ? m_enclosuresIcon : QVariant();
             } else {
@@ -394,32 +762,28 @@ bool MessagesModel::setMessageRead(int row_index, RootItem::ReadStatus read)
         return false;
     }
 
-    if (DatabaseQueries::markMessagesReadUnread(m_db, QStringList() << QString::number(message.m_id),
-            read)) {
-        return m_selectedItem->getParentServiceRoot()->onAfterSetMessagesRead(m_selectedItem,
-                QList<Message>() << message, read);
-    } else {
-        return false;
-    }
+    const QStringList message_ids = QStringList() << QString::number(message.m_id);
+    QPointer<RootItem> item = m_selectedItem;
+
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids, read](const QSqlDatabase &db) {
+        return DatabaseQueries::markMessagesReadUnread(db, message_ids, read);
+    }), this, [item, message, read]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterSetMessagesRead(item.data(), QList<Message>() << message, read);
+        }
+    });
+
+    return true;
 }
 
 bool MessagesModel::setMessageReadById(int id, RootItem::ReadStatus read)
 {
-    for (int i = 0; i < rowCount(); i++) {
-        int found_id = data(i, MSG_DB_ID_INDEX, Qt::EditRole).toInt();
-
-        if (found_id == id) {
-            bool set = setData(index(i, MSG_DB_READ_INDEX), int(read));
-
-            if (set) {
-                emit dataChanged(index(i, 0), index(i, MSG_DB_CUSTOM_HASH_INDEX));
-            }
-
-            return set;
-        }
-    }
+    return setMessagesReadById(QList<int>() << id, read);
+}
 
-    return false;
+bool MessagesModel::setMessagesReadById(const QList<int> &ids, RootItem::ReadStatus read)
+{
+    return setMessagesDataById(ids, MSG_DB_READ_INDEX, int(read));
 }
 
 bool MessagesModel::switchMessageImportance(int row_index)
@@ -448,16 +812,24 @@ bool MessagesModel::switchMessageImportance(int row_index)
         return false;
     }
 
+    emit dataChanged(index(row_index, 0), index(row_index, MSG_DB_FEED_CUSTOM_ID_INDEX),
+                     QVector<int>() << Qt::FontRole);
+
     // Commit changes.
-    if (DatabaseQueries::markMessageImportant(m_db, message.m_id, next_importance)) {
-        emit dataChanged(index(row_index, 0), index(row_index, MSG_DB_FEED_CUSTOM_ID_INDEX),
-                         QVector<int>() << Qt::FontRole);
+    const int message_id = message.m_id;
+    QPointer<RootItem> item = m_selectedItem;
+
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_id,
+                                  next_importance](const QSqlDatabase &db) {
+        return DatabaseQueries::markMessageImportant(db, message_id, next_importance);
+    }), this, [item, pair]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterSwitchMessageImportance(item.data(),
+                    QList<QPair<Message, RootItem::Importance>>() << pair);
+        }
+    });
 
-        return m_selectedItem->getParentServiceRoot()->onAfterSwitchMessageImportance(m_selectedItem,
-                QList<QPair<Message, RootItem::Importance>>() << pair);
-    } else {
-        return false;
-    }
+    return true;
 }
 
 bool MessagesModel::switchBatchMessageImportance(const QModelIndexList &messages)
@@ -490,109 +862,138 @@ bool MessagesModel::switchBatchMessageImportance(const QModelIndexList &messages
         return false;
     }
 
-    if (DatabaseQueries::switchMessagesImportance(m_db, message_ids)) {
-        return m_selectedItem->getParentServiceRoot()->onAfterSwitchMessageImportance(m_selectedItem,
-                message_states);
-    } else {
-        return false;
-    }
+    QPointer<RootItem> item = m_selectedItem;
+
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids](const QSqlDatabase &db) {
+        return DatabaseQueries::switchMessagesImportance(db, message_ids);
+    }), this, [item, message_states]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterSwitchMessageImportance(item.data(), message_states);
+        }
+    });
+
+    return true;
 }
 
 bool MessagesModel::setBatchMessagesDeleted(const QModelIndexList &messages)
 {
-    QStringList message_ids;
-    QList<Message> msgs;
+    QVector<int> rows;
+    const QStringList message_ids = idsOfMessages(messages, rows);
 
-    // Obtain IDs of all desired messages.
-    for (const QModelIndex &message : messages) {
-        const Message msg = messageAt(message.row());
+    if (!m_selectedItem->getParentServiceRoot()->onBeforeBatchMessagesDelete(m_selectedItem, message_ids)) {
+        return false;
+    }
 
-        msgs.append(msg);
-        message_ids.append(QString::number(msg.m_id));
+    const bool from_bin = m_selectedItem->kind() == RootItem::Kind::Bin;
 
-        if (qobject_cast<RecycleBin *>(m_selectedItem) != nullptr) {
-            setData(index(message.row(), MSG_DB_PDELETED_INDEX), 1);
+    setRowsData(rows, QVector<int>() << (from_bin ? MSG_DB_PDELETED_INDEX : MSG_DB_DELETED_INDEX), 1);
+
+    QPointer<RootItem> item = m_selectedItem;
+
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids,
+                                  from_bin](const QSqlDatabase &db) {
+        if (from_bin) {
+            return DatabaseQueries::permanentlyDeleteMessages(db, message_ids);
         } else {
-            setData(index(message.row(), MSG_DB_DELETED_INDEX), 1);
+            return DatabaseQueries::deleteOrRestoreMessagesToFromBin(db, message_ids, true);
         }
-    }
+    }), this, [item, message_ids]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterBatchMessagesDelete(item.data(), message_ids);
+        }
+    });
 
-    reloadWholeLayout();
+    return true;
+}
+
+bool MessagesModel::setBatchMessagesRead(const QModelIndexList &messages,
+        RootItem::ReadStatus read)
+{
+    QVector<int> rows;
+    const QStringList message_ids = idsOfMessages(messages, rows);
 
-    if (!m_selectedItem->getParentServiceRoot()->onBeforeMessagesDelete(m_selectedItem, msgs)) {
+    if (!m_selectedItem->getParentServiceRoot()->onBeforeSetBatchMessagesRead(m_selectedItem, message_ids, read)) {
         return false;
     }
 
-    bool deleted;
+    setRowsData(rows, QVector<int>() << MSG_DB_READ_INDEX, int(read));
 
-    if (m_selectedItem->kind() != RootItem::Kind::Bin) {
-        deleted = DatabaseQueries::deleteOrRestoreMessagesToFromBin(m_db, message_ids, true);
-    } else {
-        deleted = DatabaseQueries::permanentlyDeleteMessages(m_db, message_ids);
-    }
+    QPointer<RootItem> item = m_selectedItem;
 
-    if (deleted) {
-        return m_selectedItem->getParentServiceRoot()->onAfterMessagesDelete(m_selectedItem, msgs);
-    } else {
-        return false;
-    }
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids, read](const QSqlDatabase &db) {
+        return DatabaseQueries::markMessagesReadUnread(db, message_ids, read);
+    }), this, [item, message_ids, read]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterSetBatchMessagesRead(item.data(), message_ids, read);
+        }
+    });
+
+    return true;
 }
 
-bool MessagesModel::setBatchMessagesRead(const QModelIndexList &messages,
-        RootItem::ReadStatus read)
+bool MessagesModel::setBatchMessagesRestored(const QModelIndexList &messages)
 {
-    QStringList message_ids;
-    QList<Message> msgs;
+    QVector<int> rows;
+    const QStringList message_ids = idsOfMessages(messages, rows);
 
-    // Obtain IDs of all desired messages.
-    for (const QModelIndex &message : messages) {
-        Message msg = messageAt(message.row());
-
-        msgs.append(msg);
-        message_ids.append(QString::number(msg.m_id));
-        setData(index(message.row(), MSG_DB_READ_INDEX), int(read));
+    if (!m_selectedItem->getParentServiceRoot()->onBeforeBatchMessagesRestoredFromBin(m_selectedItem,
+            message_ids)) {
+        return false;
     }
 
-    reloadWholeLayout();
+    setRowsData(rows, QVector<int>() << MSG_DB_PDELETED_INDEX << MSG_DB_DELETED_INDEX, 0);
 
-    if (!m_selectedItem->getParentServiceRoot()->onBeforeSetMessagesRead(m_selectedItem, msgs, read)) {
-        return false;
-    }
+    QPointer<RootItem> item = m_selectedItem;
 
-    if (DatabaseQueries::markMessagesReadUnread(m_db, message_ids, read)) {
-        return m_selectedItem->getParentServiceRoot()->onAfterSetMessagesRead(m_selectedItem, msgs, read);
-    } else {
-        return false;
-    }
+    DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids](const QSqlDatabase &db) {
+        return DatabaseQueries::deleteOrRestoreMessagesToFromBin(db, message_ids, false);
+    }), this, [item, message_ids]() {
+        if (!item.isNull()) {
+            item->getParentServiceRoot()->onAfterBatchMessagesRestoredFromBin(item.data(), message_ids);
+        }
+    });
+
+    return true;
 }
 
-bool MessagesModel::setBatchMessagesRestored(const QModelIndexList &messages)
+QStringList MessagesModel::idsOfMessages(const QModelIndexList &messages, QVector<int> &rows) const
 {
-    QStringList message_ids;
-    QList<Message> msgs;
+    QStringList ids;
+
+    rows.clear();
+    rows.reserve(messages.size());
 
-    // Obtain IDs of all desired messages.
     for (const QModelIndex &message : messages) {
-        const Message msg = messageAt(message.row());
+        if (message.row() >= 0 && message.row() < m_ids.size()) {
+            rows.append(message.row());
+        }
+    }
 
-        msgs.append(msg);
-        message_ids.append(QString::number(msg.m_id));
-        setData(index(message.row(), MSG_DB_PDELETED_INDEX), 0);
-        setData(index(message.row(), MSG_DB_DELETED_INDEX), 0);
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    ids.reserve(rows.size());
+
+    for (int row : rows) {
+        ids.append(QString::number(m_ids.at(row)));
     }
 
-    reloadWholeLayout();
+    return ids;
+}
 
-    if (!m_selectedItem->getParentServiceRoot()->onBeforeMessagesRestoredFromBin(m_selectedItem,
-            msgs)) {
-        return false;
+void MessagesModel::setRowsData(const QVector<int> &rows, const QVector<int> &columns, int value)
+{
+    if (rows.isEmpty()) {
+        return;
     }
 
-    if (DatabaseQueries::deleteOrRestoreMessagesToFromBin(m_db, message_ids, false)) {
-        return m_selectedItem->getParentServiceRoot()->onAfterMessagesRestoredFromBin(m_selectedItem, msgs);
-    } else {
-        return false;
+    for (int row : rows) {
+        for (int column : columns) {
+            setCachedData(row, column, value);
+        }
     }
+
+    // Rows are sorted, so single range covers all of them.
+    emit dataChanged(index(rows.first(), 0), index(rows.last(), MSG_DB_CUSTOM_HASH_INDEX));
 }
 
 QVariant MessagesModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -4,18 +4,25 @@
 #define MESSAGESMODEL_H
 
 #include "core/messagesmodelsqllayer.h"
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
 
 #include "core/message.h"
 #include "definitions/definitions.h"
 #include "services/abstract/rootitem.h"
 
 #include <QFont>
+#include <QHash>
 #include <QIcon>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
 
 class MessagesModelCache;
 
-class MessagesModel : public QSqlQueryModel, public MessagesModelSqlLayer
+// Model of message list. Only IDs of all listed messages are loaded
+// at once, other data are loaded in pages when rows are accessed.
+class MessagesModel : public QAbstractTableModel, public MessagesModelSqlLayer
 {
     Q_OBJECT
 
@@ -33,11 +40,24 @@ public:
     explicit MessagesModel(QObject *parent = nullptr);
     virtual ~MessagesModel();
 
-    // Fetches ALL available data to the model.
-    // NOTE: This activates the SQL query and populates the model with new data.
+    // Fetches IDs of all messages to the model, rows are loaded on demand.
+    // NOTE: IDs are fetched in background, model is reset once they are
+    // ready. Previous unfinished fetches are cancelled.
     void repopulate();
 
+    // Fetches IDs of messages again and applies only differences to the model,
+    // new messages are inserted, messages which are not listed anymore
+    // are removed and other rows keep their positions and selections.
+    // NOTE: Model is reset as with repopulate() if order of listed
+    // messages was changed.
+    void refreshMessages();
+
+    // Returns true if messages are being fetched.
+    bool isLoading() const;
+
     // Model implementation.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
     QVariant data(const QModelIndex &idx, int role = Qt::DisplayRole) const;
     QVariant data(int row, int column, int role = Qt::DisplayRole) const;
@@ -45,9 +65,19 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const;
 
     // Returns message at given index.
-
     QList<Message> messagesAt(QList<int> row_indices) const;
     Message messageAt(int row_index) const;
+
+    // Returns row of message with given ID or -1.
+    int rowForMessageId(int id) const;
+
+    // Returns first row with unread message which is not
+    // before given row or -1 if there is no such row.
+    int nextUnreadRow(int row_index) const;
+
+    // Returns message at given index including its contents and enclosures,
+    // which are not part of the list and are loaded from database on demand.
+    Message messageWithBodyAt(int row_index) const;
     int messageId(int row_index) const;
     RootItem::Importance messageImportance(int row_index) const;
 
@@ -80,11 +110,81 @@ public slots:
     // These are particularly used by msg browser.
     bool setMessageImportantById(int id, RootItem::Importance important);
     bool setMessageReadById(int id, RootItem::ReadStatus read);
+    bool setMessagesImportantById(const QList<int> &ids, RootItem::Importance important);
+    bool setMessagesReadById(const QList<int> &ids, RootItem::ReadStatus read);
+
+signals:
+    void loadingStarted();
+    void loadingFinished();
 
 private:
     void setupHeaderData();
     void setupIcons();
 
+    // IDs of messages in the list order and rows of messages by their IDs.
+    struct LoadedIds {
+        QVector<int> m_ids;
+        QHash<int, int> m_rows;
+        QVector<int> m_unreadRows;
+
+        // Filled only when messages are refreshed and messages which stay
+        // in the list keep their order. Rows of removed messages are from
+        // the old list, rows of inserted messages are from the new list.
+        bool m_isDelta = false;
+        QVector<int> m_removedRows;
+        QVector<int> m_insertedRows;
+    };
+
+    // Fetches IDs of messages in background, either replacing whole
+    // list or applying only differences to it.
+    void loadInBackground(bool incremental);
+
+    // Fetches IDs of messages with given statement, runs in loader thread.
+    LoadedIds loadIds(const QString &statement, const QStringList &kept_ids, int generation) const;
+
+    // Compares loaded IDs with listed messages, runs in loader thread.
+    static void compareIds(const QHash<int, int> &listed_rows, int listed_count, LoadedIds &loaded);
+
+    // Removes and inserts rows so that model lists loaded messages.
+    void applyDelta(const LoadedIds &loaded);
+
+    // Changes column of messages with given IDs, only rows which
+    // are in the list are changed.
+    bool setMessagesDataById(const QList<int> &ids, int column, const QVariant &value);
+
+    // Returns IDs of messages with given indexes and their rows, in ascending order.
+    QStringList idsOfMessages(const QModelIndexList &messages, QVector<int> &rows) const;
+
+    // Changes columns of given rows and notifies views once for all of them.
+    void setRowsData(const QVector<int> &rows, const QVector<int> &columns, int value);
+
+    // Changes data of row in cache and keeps list of unread rows up to date.
+    void setCachedData(int row_index, int column, const QVariant &value);
+
+    // Returns value of message, with its changes applied.
+    QVariant rawData(int row_index, int column) const;
+
+    // Formats value of message for displaying.
+    QString displayText(int row_index, int column) const;
+
+    // Loads page which contains given row if it is not loaded yet.
+    bool ensureRowLoaded(int row_index) const;
+
+    // IDs of all messages in the list, in the list order,
+    // other data of messages are kept in cache.
+    QVector<int> m_ids;
+    QHash<int, int> m_rowsById;
+
+    // Sorted rows of unread messages.
+    QVector<int> m_unreadRows;
+
+    // Only result of the newest fetch is used, older fetches are cancelled.
+    std::atomic_int m_loadGeneration;
+    bool m_isLoading;
+
+    // Single thread which keeps its own database connection.
+    QThreadPool m_loader;
+
     MessagesModelCache *m_cache;
     MessageHighlighter m_messageHighlighter;
     QString m_customDateFormat;
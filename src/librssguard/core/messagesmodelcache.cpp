@@ -2,21 +2,363 @@
 
 #include "core/messagesmodelcache.h"
 
+#include "definitions/definitions.h"
 #include "miscellaneous/textfactory.h"
 
 MessagesModelCache::MessagesModelCache(QObject *parent) : QObject(parent) {}
 
-void MessagesModelCache::setData(const QModelIndex &index, const QVariant &value,
-                                 const QSqlRecord &record)
+void MessagesModelCache::clear(int row_count)
 {
-    if (!m_msgCache.contains(index.row())) {
-        m_msgCache[index.row()] = record;
+    dropPages();
+    m_changed = QBitArray(row_count);
+    m_changedFlags.clear();
+    m_changedMasks.clear();
+}
+
+void MessagesModelCache::dropPages()
+{
+    m_pages.clear();
+    m_pageUsage.clear();
+    m_strings.clear();
+    m_stringIndexes.clear();
+}
+
+void MessagesModelCache::insertRows(int row_idx, int count)
+{
+    QBitArray changed(m_changed.size() + count);
+
+    for (int i = 0; i < m_changed.size(); i++) {
+        if (m_changed.testBit(i)) {
+            changed.setBit(i < row_idx ? i : i + count);
+        }
+    }
+
+    if (!m_changedFlags.isEmpty()) {
+        m_changedFlags.insert(row_idx, QByteArray(count, 0));
+        m_changedMasks.insert(row_idx, QByteArray(count, 0));
+    }
+
+    m_changed = changed;
+    dropPages();
+}
+
+void MessagesModelCache::removeRows(int row_idx, int count)
+{
+    QBitArray changed(m_changed.size() - count);
+
+    for (int i = 0; i < m_changed.size(); i++) {
+        if (m_changed.testBit(i) && (i < row_idx || i >= row_idx + count)) {
+            changed.setBit(i < row_idx ? i : i - count);
+        }
+    }
+
+    if (!m_changedFlags.isEmpty()) {
+        m_changedFlags.remove(row_idx, count);
+        m_changedMasks.remove(row_idx, count);
+    }
+
+    m_changed = changed;
+    dropPages();
+}
+
+QVector<int> MessagesModelCache::changedRows() const
+{
+    QVector<int> rows;
+
+    for (int i = 0; i < m_changed.size(); i++) {
+        if (m_changed.testBit(i)) {
+            rows.append(i);
+        }
+    }
+
+    return rows;
+}
+
+bool MessagesModelCache::containsPage(int page_idx)
+{
+    if (!m_pages.contains(page_idx)) {
+        return false;
+    }
+
+    if (m_pageUsage.last() != page_idx) {
+        m_pageUsage.removeOne(page_idx);
+        m_pageUsage.append(page_idx);
+    }
+
+    return true;
+}
+
+void MessagesModelCache::insertPage(int page_idx, const QVector<int> &ids, QSqlQuery &query)
+{
+    const int count = ids.size();
+    QHash<int, int> positions;
+    Page page;
+
+    for (int i = 0; i < count; i++) {
+        positions.insert(ids.at(i), i);
     }
 
-    m_msgCache[index.row()].setValue(index.column(), value);
+    page.m_loaded = QBitArray(count);
+    page.m_flags.resize(count);
+    page.m_created.resize(count);
+    page.m_accountIds.resize(count);
+    page.m_feedTitles.fill(-1, count);
+    page.m_feedIds.fill(-1, count);
+    page.m_authors.fill(-1, count);
+    page.m_titles.resize(count);
+    page.m_urls.resize(count);
+    page.m_customIds.resize(count);
+    page.m_customHashes.resize(count);
+    page.m_contents.resize(count);
+
+    while (query.next()) {
+        const int i = positions.value(query.value(MSG_DB_ID_INDEX).toInt(), -1);
+
+        if (i < 0) {
+            continue;
+        }
+
+        quint8 flags = 0;
+
+        flags |= query.value(MSG_DB_READ_INDEX).toBool() ? Read : 0;
+        flags |= query.value(MSG_DB_DELETED_INDEX).toBool() ? Deleted : 0;
+        flags |= query.value(MSG_DB_IMPORTANT_INDEX).toBool() ? Important : 0;
+        flags |= query.value(MSG_DB_PDELETED_INDEX).toBool() ? PermanentlyDeleted : 0;
+        flags |= query.value(MSG_DB_HAS_ENCLOSURES).toBool() ? HasEnclosures : 0;
+
+        page.m_loaded.setBit(i);
+        page.m_flags[i] = flags;
+        page.m_created[i] = query.value(MSG_DB_DCREATED_INDEX).value<qint64>();
+        page.m_accountIds[i] = query.value(MSG_DB_ACCOUNT_ID_INDEX).toInt();
+        page.m_feedTitles[i] = intern(query.value(MSG_DB_FEED_TITLE_INDEX).toString());
+        page.m_feedIds[i] = intern(query.value(MSG_DB_FEED_CUSTOM_ID_INDEX).toString());
+        page.m_authors[i] = intern(query.value(MSG_DB_AUTHOR_INDEX).toString());
+        page.m_titles[i] = query.value(MSG_DB_TITLE_INDEX).toString();
+        page.m_urls[i] = query.value(MSG_DB_URL_INDEX).toString();
+        page.m_customIds[i] = query.value(MSG_DB_CUSTOM_ID_INDEX).toString();
+        page.m_customHashes[i] = query.value(MSG_DB_CUSTOM_HASH_INDEX).toString();
+        page.m_contents[i] = Message::decompressContents(query.value(MSG_DB_CONTENTS_INDEX).toString())
+                             .left(MSG_CONTENTS_PREVIEW_LENGTH);
+    }
+
+    // Pages which were not used for longest time are far from
+    // the visible part of the list, so they are dropped first.
+    while (m_pages.size() >= MSG_MODEL_MAX_PAGES && !m_pageUsage.isEmpty()) {
+        m_pages.remove(m_pageUsage.takeFirst());
+    }
+
+    m_pages.insert(page_idx, page);
+    m_pageUsage.append(page_idx);
 }
 
-QVariant MessagesModelCache::data(const QModelIndex &idx)
+QVariant MessagesModelCache::data(int row_idx, int column) const
 {
-    return m_msgCache[idx.row()].value(idx.column());
+    const Page *pg = page(row_idx);
+    const int i = row_idx % MSG_MODEL_PAGE_SIZE;
+
+    if (pg == nullptr || !pg->m_loaded.testBit(i)) {
+        return QVariant();
+    }
+
+    switch (column) {
+        case MSG_DB_READ_INDEX:
+        case MSG_DB_DELETED_INDEX:
+        case MSG_DB_IMPORTANT_INDEX:
+        case MSG_DB_PDELETED_INDEX:
+        case MSG_DB_HAS_ENCLOSURES:
+            return (flags(row_idx) & flagForColumn(column)) > 0 ? 1 : 0;
+
+        case MSG_DB_FEED_TITLE_INDEX:
+            return m_strings.at(pg->m_feedTitles.at(i));
+
+        case MSG_DB_TITLE_INDEX:
+            return pg->m_titles.at(i);
+
+        case MSG_DB_URL_INDEX:
+            return pg->m_urls.at(i);
+
+        case MSG_DB_AUTHOR_INDEX:
+            return m_strings.at(pg->m_authors.at(i));
+
+        case MSG_DB_DCREATED_INDEX:
+            return pg->m_created.at(i);
+
+        case MSG_DB_ACCOUNT_ID_INDEX:
+            return pg->m_accountIds.at(i);
+
+        case MSG_DB_CUSTOM_ID_INDEX:
+            return pg->m_customIds.at(i);
+
+        case MSG_DB_CUSTOM_HASH_INDEX:
+            return pg->m_customHashes.at(i);
+
+        case MSG_DB_FEED_CUSTOM_ID_INDEX:
+            return m_strings.at(pg->m_feedIds.at(i));
+
+        case MSG_DB_CONTENTS_INDEX:
+            return pg->m_contents.at(i);
+
+        default:
+            // Enclosures are not part of the list.
+            return QVariant();
+    }
+}
+
+Message MessagesModelCache::message(int row_idx, int id) const
+{
+    const Page *pg = page(row_idx);
+    const int i = row_idx % MSG_MODEL_PAGE_SIZE;
+    Message message;
+
+    if (pg == nullptr || !pg->m_loaded.testBit(i)) {
+        return message;
+    }
+
+    const quint8 msg_flags = flags(row_idx);
+
+    message.m_id = id;
+    message.m_isRead = (msg_flags & Read) > 0;
+    message.m_isImportant = (msg_flags & Important) > 0;
+    message.m_feedId = m_strings.at(pg->m_feedIds.at(i));
+    message.m_title = pg->m_titles.at(i);
+    message.m_url = pg->m_urls.at(i);
+    message.m_author = m_strings.at(pg->m_authors.at(i));
+    message.m_created = TextFactory::parseDateTime(pg->m_created.at(i));
+    message.m_accountId = pg->m_accountIds.at(i);
+    message.m_customId = pg->m_customIds.at(i);
+    message.m_customHash = pg->m_customHashes.at(i);
+
+    return message;
+}
+
+QString MessagesModelCache::displayData(int row_idx, int column) const
+{
+    const Page *pg = page(row_idx);
+
+    if (pg == nullptr) {
+        return QString();
+    }
+
+    auto texts = pg->m_displayTexts.constFind(column);
+
+    return texts == pg->m_displayTexts.constEnd() ? QString() : texts.value().at(row_idx % MSG_MODEL_PAGE_SIZE);
+}
+
+void MessagesModelCache::setDisplayData(int row_idx, int column, const QString &text)
+{
+    Page *pg = page(row_idx);
+
+    if (pg == nullptr) {
+        return;
+    }
+
+    QVector<QString> &texts = pg->m_displayTexts[column];
+
+    if (texts.isEmpty()) {
+        texts.resize(pg->m_loaded.size());
+    }
+
+    texts[row_idx % MSG_MODEL_PAGE_SIZE] = text;
+}
+
+void MessagesModelCache::clearDisplayData()
+{
+    for (Page &pg : m_pages) {
+        pg.m_displayTexts.clear();
+    }
+}
+
+void MessagesModelCache::setData(int row_idx, int column, const QVariant &value)
+{
+    const quint8 flag = flagForColumn(column);
+
+    if (flag == 0 || row_idx < 0 || row_idx >= m_changed.size()) {
+        return;
+    }
+
+    if (m_changedFlags.size() != m_changed.size()) {
+        m_changedFlags.resize(m_changed.size());
+        m_changedMasks.resize(m_changed.size());
+    }
+
+    if (!m_changed.testBit(row_idx)) {
+        m_changedFlags[row_idx] = 0;
+        m_changedMasks[row_idx] = 0;
+        m_changed.setBit(row_idx);
+    }
+
+    quint8 changed_flags = quint8(m_changedFlags.at(row_idx));
+
+    if (value.toBool()) {
+        changed_flags |= flag;
+    } else {
+        changed_flags &= ~flag;
+    }
+
+    m_changedFlags[row_idx] = char(changed_flags);
+    m_changedMasks[row_idx] = char(quint8(m_changedMasks.at(row_idx)) | flag);
+}
+
+quint8 MessagesModelCache::flagForColumn(int column)
+{
+    switch (column) {
+        case MSG_DB_READ_INDEX:
+            return Read;
+
+        case MSG_DB_DELETED_INDEX:
+            return Deleted;
+
+        case MSG_DB_IMPORTANT_INDEX:
+            return Important;
+
+        case MSG_DB_PDELETED_INDEX:
+            return PermanentlyDeleted;
+
+        case MSG_DB_HAS_ENCLOSURES:
+            return HasEnclosures;
+
+        default:
+            return 0;
+    }
+}
+
+int MessagesModelCache::intern(const QString &string)
+{
+    auto existing = m_stringIndexes.constFind(string);
+
+    if (existing != m_stringIndexes.constEnd()) {
+        return existing.value();
+    }
+
+    m_strings.append(string);
+    m_stringIndexes.insert(string, m_strings.size() - 1);
+    return m_strings.size() - 1;
+}
+
+const MessagesModelCache::Page *MessagesModelCache::page(int row_idx) const
+{
+    auto pg = m_pages.constFind(row_idx / MSG_MODEL_PAGE_SIZE);
+
+    return pg == m_pages.constEnd() ? nullptr : &pg.value();
+}
+
+MessagesModelCache::Page *MessagesModelCache::page(int row_idx)
+{
+    auto pg = m_pages.find(row_idx / MSG_MODEL_PAGE_SIZE);
+
+    return pg == m_pages.end() ? nullptr : &pg.value();
+}
+
+quint8 MessagesModelCache::flags(int row_idx) const
+{
+    const Page *pg = page(row_idx);
+    const quint8 loaded_flags = pg == nullptr ? 0 : pg->m_flags.at(row_idx % MSG_MODEL_PAGE_SIZE);
+
+    if (containsData(row_idx)) {
+        const quint8 mask = quint8(m_changedMasks.at(row_idx));
+
+        return (loaded_flags & ~mask) | (quint8(m_changedFlags.at(row_idx)) & mask);
+    }
+
+    return loaded_flags;
 }
@@ -7,9 +7,15 @@
 
 #include "core/message.h"
 
-#include <QModelIndex>
+#include <QBitArray>
+#include <QHash>
+#include <QSqlQuery>
+#include <QStringList>
 #include <QVariant>
+#include <QVector>
 
+// Keeps loaded pages of message list in compact, column-wise form
+// together with states of messages which were changed in the list.
 class MessagesModelCache : public QObject
 {
     Q_OBJECT
@@ -18,30 +24,110 @@ public:
     explicit MessagesModelCache(QObject *parent = nullptr);
     virtual ~MessagesModelCache() = default;
 
+    // Drops all pages and changes, list now has given number of rows.
+    void clear(int row_count = 0);
+
+    // Drops all pages, changes of messages are kept.
+    void dropPages();
+
+    // Shift changes of messages when rows are inserted to or removed from the list.
+    // NOTE: Pages are dropped as their rows are not valid anymore.
+    void insertRows(int row_idx, int count);
+    void removeRows(int row_idx, int count);
+
+    // Returns true if state of message in given row was changed.
     bool containsData(int row_idx) const;
-    QSqlRecord record(int row_idx) const;
-    QVariant data(const QModelIndex &idx);
 
-    void clear();
-    void setData(const QModelIndex &index, const QVariant &value, const QSqlRecord &record);
+    // Returns rows with changed state of messages.
+    QVector<int> changedRows() const;
+
+    // Returns true if page is loaded, page is then marked as recently used.
+    bool containsPage(int page_idx);
+
+    // Stores rows of given page, "ids" are IDs of messages of the page in their order
+    // and "query" is executed query which selects those messages.
+    // Least recently used pages are dropped if there are too many of them.
+    void insertPage(int page_idx, const QVector<int> &ids, QSqlQuery &query);
+
+    // Returns value of loaded row with any changes applied.
+    // NOTE: ID column is not kept here.
+    QVariant data(int row_idx, int column) const;
+
+    // Returns message without contents and enclosures.
+    Message message(int row_idx, int id) const;
+
+    // Returns text of column formatted for displaying or null string if it
+    // was not formatted yet, texts are kept until page of row is dropped.
+    QString displayData(int row_idx, int column) const;
+    void setDisplayData(int row_idx, int column, const QString &text);
+
+    // Drops all formatted texts, for example when date format changes.
+    void clearDisplayData();
+
+    // Changes state of message, only flag columns can be changed.
+    // NOTE: Row does not have to be loaded, only changed flag
+    // is then used and other flags are taken from the page later.
+    void setData(int row_idx, int column, const QVariant &value);
 
 private:
-    QHash<int, QSqlRecord> m_msgCache;
-};
+    enum Flag : quint8 {
+        Read = 1,
+        Deleted = 2,
+        Important = 4,
+        PermanentlyDeleted = 8,
+        HasEnclosures = 16
+    };
 
-inline bool MessagesModelCache::containsData(int row_idx) const
-{
-    return m_msgCache.contains(row_idx);
-}
+    // Columns of single page of rows.
+    struct Page {
+        QBitArray m_loaded;
+        QVector<quint8> m_flags;
+        QVector<qint64> m_created;
+        QVector<int> m_accountIds;
 
-inline QSqlRecord MessagesModelCache::record(int row_idx) const
-{
-    return m_msgCache.value(row_idx);
-}
+        // Indexes into interned strings.
+        QVector<int> m_feedTitles;
+        QVector<int> m_feedIds;
+        QVector<int> m_authors;
+
+        QVector<QString> m_titles;
+        QVector<QString> m_urls;
+        QVector<QString> m_customIds;
+        QVector<QString> m_customHashes;
+
+        // Beginnings of decompressed contents.
+        QVector<QString> m_contents;
+
+        // Formatted texts of rows by column.
+        QHash<int, QVector<QString>> m_displayTexts;
+    };
+
+    static quint8 flagForColumn(int column);
+
+    int intern(const QString &string);
+    const Page *page(int row_idx) const;
+    Page *page(int row_idx);
+    quint8 flags(int row_idx) const;
 
-inline void MessagesModelCache::clear()
+    QHash<int, Page> m_pages;
+
+    // Most recently used page is the last one.
+    QList<int> m_pageUsage;
+
+    // Values which repeat a lot in the list are stored only once.
+    QStringList m_strings;
+    QHash<QString, int> m_stringIndexes;
+
+    // Rows with changed state, their changed flags and
+    // masks of flags which were changed.
+    QBitArray m_changed;
+    QByteArray m_changedFlags;
+    QByteArray m_changedMasks;
+};
+
+inline bool MessagesModelCache::containsData(int row_idx) const
 {
-    m_msgCache.clear();
+    return row_idx >= 0 && row_idx < m_changed.size() && m_changed.testBit(row_idx);
 }
 
 #endif // MESSAGESMODELCACHE_H
@@ -4,8 +4,10 @@
 
 #include "definitions/definitions.h"
 #include "miscellaneous/application.h"
+#include "miscellaneous/databasequeries.h"
 
-MessagesModelSqlLayer::MessagesModelSqlLayer() : m_filter(QSL(DEFAULT_SQL_MESSAGES_FILTER))
+MessagesModelSqlLayer::MessagesModelSqlLayer()
+    : m_filter(QSL(DEFAULT_SQL_MESSAGES_FILTER)), m_showArchived(false), m_showUnreadOnly(false)
 {
     m_db = qApp->database()->connection(QSL("MessagesModel"));
 
@@ -19,15 +21,14 @@ MessagesModelSqlLayer::MessagesModelSqlLayer() : m_filter(QSL(DEFAULT_SQL_MESSAG
     m_fieldNames[MSG_DB_URL_INDEX] = "Messages.url";
     m_fieldNames[MSG_DB_AUTHOR_INDEX] = "Messages.author";
     m_fieldNames[MSG_DB_DCREATED_INDEX] = "Messages.date_created";
-    m_fieldNames[MSG_DB_CONTENTS_INDEX] = "Messages.contents";
+    m_fieldNames[MSG_DB_CONTENTS_INDEX] = contentsField();
     m_fieldNames[MSG_DB_PDELETED_INDEX] = "Messages.is_pdeleted";
-    m_fieldNames[MSG_DB_ENCLOSURES_INDEX] = "Messages.enclosures";
+    m_fieldNames[MSG_DB_ENCLOSURES_INDEX] = "NULL AS enclosures";
     m_fieldNames[MSG_DB_ACCOUNT_ID_INDEX] = "Messages.account_id";
     m_fieldNames[MSG_DB_CUSTOM_ID_INDEX] = "Messages.custom_id";
     m_fieldNames[MSG_DB_CUSTOM_HASH_INDEX] = "Messages.custom_hash";
     m_fieldNames[MSG_DB_FEED_CUSTOM_ID_INDEX] = "Messages.feed";
-    m_fieldNames[MSG_DB_HAS_ENCLOSURES] =
-        "CASE WHEN length(Messages.enclosures) > 10 THEN 'true' ELSE 'false' END AS has_enclosures";
+    m_fieldNames[MSG_DB_HAS_ENCLOSURES] = "Messages.has_enclosures";
 
     // Used in <x>: SELECT ... FROM ... ORDER BY <x1> DESC, <x2> ASC;
     m_orderByNames[MSG_DB_ID_INDEX] = "Messages.id";
@@ -39,14 +40,14 @@ MessagesModelSqlLayer::MessagesModelSqlLayer() : m_filter(QSL(DEFAULT_SQL_MESSAG
     m_orderByNames[MSG_DB_URL_INDEX] = "Messages.url";
     m_orderByNames[MSG_DB_AUTHOR_INDEX] = "Messages.author";
     m_orderByNames[MSG_DB_DCREATED_INDEX] = "Messages.date_created";
-    m_orderByNames[MSG_DB_CONTENTS_INDEX] = "Messages.contents";
+    m_orderByNames[MSG_DB_CONTENTS_INDEX] = "NULL";
     m_orderByNames[MSG_DB_PDELETED_INDEX] = "Messages.is_pdeleted";
-    m_orderByNames[MSG_DB_ENCLOSURES_INDEX] = "Messages.enclosures";
+    m_orderByNames[MSG_DB_ENCLOSURES_INDEX] = "NULL";
     m_orderByNames[MSG_DB_ACCOUNT_ID_INDEX] = "Messages.account_id";
     m_orderByNames[MSG_DB_CUSTOM_ID_INDEX] = "Messages.custom_id";
     m_orderByNames[MSG_DB_CUSTOM_HASH_INDEX] = "Messages.custom_hash";
     m_orderByNames[MSG_DB_FEED_CUSTOM_ID_INDEX] = "Messages.feed";
-    m_orderByNames[MSG_DB_HAS_ENCLOSURES] = "has_enclosures";
+    m_orderByNames[MSG_DB_HAS_ENCLOSURES] = "Messages.has_enclosures";
 }
 
 void MessagesModelSqlLayer::addSortState(int column, Qt::SortOrder order)
@@ -87,17 +88,183 @@ void MessagesModelSqlLayer::setFilter(const QString &filter)
     m_filter = filter;
 }
 
+void MessagesModelSqlLayer::setSearchPhrase(const QString &phrase)
+{
+    m_searchPhrase = phrase;
+}
+
+void MessagesModelSqlLayer::setShowArchived(bool show_archived)
+{
+    m_showArchived = show_archived;
+    m_fieldNames[MSG_DB_CONTENTS_INDEX] = contentsField();
+}
+
+bool MessagesModelSqlLayer::showUnreadOnly() const
+{
+    return m_showUnreadOnly;
+}
+
+void MessagesModelSqlLayer::setShowUnreadOnly(bool show_unread_only)
+{
+    m_showUnreadOnly = show_unread_only;
+    m_keptIds.clear();
+}
+
+void MessagesModelSqlLayer::keepMessages(const QVector<int> &ids)
+{
+    for (int id : ids) {
+        m_keptIds.insert(id);
+    }
+}
+
+void MessagesModelSqlLayer::clearKeptMessages()
+{
+    m_keptIds.clear();
+}
+
+void MessagesModelSqlLayer::retainKeptMessages(const QHash<int, int> &listed_rows)
+{
+    for (auto it = m_keptIds.begin(); it != m_keptIds.end();) {
+        if (listed_rows.contains(*it)) {
+            ++it;
+        } else {
+            it = m_keptIds.erase(it);
+        }
+    }
+}
+
+QStringList MessagesModelSqlLayer::keptMessages() const
+{
+    QStringList textual_ids;
+
+    textual_ids.reserve(m_keptIds.size());
+
+    for (int id : m_keptIds) {
+        textual_ids.append(QString::number(id));
+    }
+
+    return textual_ids;
+}
+
+bool MessagesModelSqlLayer::storeKeptMessages(const QSqlDatabase &db, const QStringList &ids)
+{
+    QSqlError error;
+
+    if (DatabaseQueries::storeMessageIds(db, QSL("KeptMessageIds"), ids, &error)) {
+        return true;
+    } else {
+        qWarningNN << LOGSEC_MESSAGEMODEL
+                   << "Failed to store IDs of kept messages: '"
+                   << error.text() << "'.";
+        return false;
+    }
+}
+
 QString MessagesModelSqlLayer::formatFields() const
 {
     return m_fieldNames.values().join(QSL(", "));
 }
 
+QString MessagesModelSqlLayer::fromClause() const
+{
+    QString messages = QSL("Messages");
+
+    if (showsArchived()) {
+        // Archived messages are appended to working ones, result
+        // keeps name of the table so that filters work as they are.
+        const QString columns = QSL("id, is_read, is_deleted, is_important, feed, title, url, author, date_created, "
+                                    "is_pdeleted, account_id, custom_id, custom_hash, has_enclosures");
+
+        messages = QSL("(SELECT %1 FROM Messages UNION ALL SELECT %1 FROM %2) AS Messages")
+                   .arg(columns, DatabaseQueries::archivedTable(m_db, QSL("Messages")));
+    }
+
+    return QL1S("FROM ") + messages +
+           QL1S(" LEFT JOIN Feeds ON Messages.feed = Feeds.custom_id AND Messages.account_id = Feeds.account_id ");
+}
+
+QString MessagesModelSqlLayer::bodiesClause() const
+{
+    QString bodies = QSL("LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id ");
+
+    if (showsArchived()) {
+        bodies += QSL("LEFT JOIN %1 AS ArchivedMessageBodies ON ArchivedMessageBodies.message_id = Messages.id ")
+                  .arg(DatabaseQueries::archivedTable(m_db, QSL("MessageBodies")));
+    }
+
+    return bodies;
+}
+
+QString MessagesModelSqlLayer::contentsField() const
+{
+    // Only beginning of contents is selected, compressed contents
+    // are selected whole, because they must be decompressed first.
+    const QString preview = QSL("CASE WHEN substr(%1.contents, 2, 5) = 'zlib:' THEN %1.contents "
+                                "ELSE substr(%1.contents, 1, %2) END");
+
+    if (showsArchived()) {
+        return QSL("coalesce(%1, %2) AS contents").arg(preview.arg(QSL("MessageBodies"),
+                                                                   QString::number(MSG_CONTENTS_PREVIEW_LENGTH)),
+                                                       preview.arg(QSL("ArchivedMessageBodies"),
+                                                                   QString::number(MSG_CONTENTS_PREVIEW_LENGTH)));
+    } else {
+        return preview.arg(QSL("MessageBodies"), QString::number(MSG_CONTENTS_PREVIEW_LENGTH)) + QSL(" AS contents");
+    }
+}
+
+bool MessagesModelSqlLayer::showsArchived() const
+{
+    return m_showArchived && qApp->database()->archiveAvailable();
+}
+
+QString MessagesModelSqlLayer::whereClause() const
+{
+    QString where = QL1S("WHERE (") + m_filter + QL1C(')');
+    const QString search = DatabaseQueries::searchCondition(m_db, m_searchPhrase, showsArchived());
+
+    if (!search.isEmpty()) {
+        where += QL1S(" AND ") + search;
+    }
+
+    if (!m_showUnreadOnly) {
+        return where;
+    }
+
+    QString unread = QSL("Messages.is_read = 0");
+
+    if (!m_keptIds.isEmpty()) {
+        // IDs are not part of the statement, so that it stays
+        // short no matter how many messages are kept.
+        unread = QSL("(%1 OR Messages.id IN (SELECT id FROM KeptMessageIds))").arg(unread);
+    }
+
+    return where + QL1S(" AND ") + unread;
+}
+
 QString MessagesModelSqlLayer::selectStatement() const
 {
-    return QL1S("SELECT ") + formatFields() + QL1C(' ') +
-           QL1S("FROM Messages LEFT JOIN Feeds ON Messages.feed = Feeds.custom_id AND Messages.account_id = Feeds.account_id "
-                "WHERE ") +
-           m_filter + orderByClause() + QL1C(';');
+    return QL1S("SELECT ") + formatFields() + QL1C(' ') + fromClause() + bodiesClause() +
+           whereClause() + orderByClause() + QL1C(';');
+}
+
+QString MessagesModelSqlLayer::idsStatement() const
+{
+    return QL1S("SELECT Messages.id, Messages.is_read ") + fromClause() +
+           whereClause() + orderByClause() + QL1C(';');
+}
+
+QString MessagesModelSqlLayer::rowsStatement(const QVector<int> &ids) const
+{
+    QStringList textual_ids;
+
+    textual_ids.reserve(ids.size());
+
+    for (int id : ids) {
+        textual_ids.append(QString::number(id));
+    }
+
+    return QL1S("SELECT ") + formatFields() + QL1C(' ') + fromClause() + bodiesClause() +
+           QL1S("WHERE Messages.id IN (") + textual_ids.join(QL1C(',')) + QL1S(");");
 }
 
 QString MessagesModelSqlLayer::orderByClause() const
@@ -113,6 +280,14 @@ QString MessagesModelSqlLayer::orderByClause() const
             sorts.append(field_name + (m_sortOrders[i] == Qt::AscendingOrder ? QSL(" ASC") : QSL(" DESC")));
         }
 
+        // Messages with same values are ordered by their IDs, so that their order
+        // is always the same and sorting by indexed columns can be done by reading
+        // index, which has IDs of messages as its last column.
+        if (!m_sortColumns.contains(MSG_DB_ID_INDEX)) {
+            sorts.append(m_orderByNames[MSG_DB_ID_INDEX] +
+                         (m_sortOrders.first() == Qt::AscendingOrder ? QSL(" ASC") : QSL(" DESC")));
+        }
+
         return QL1S(" ORDER BY ") + sorts.join(QSL(", "));
     }
 }
@@ -5,8 +5,11 @@
 
 #include <QSqlDatabase>
 
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QSet>
+#include <QVector>
 
 class MessagesModelSqlLayer
 {
@@ -19,15 +22,59 @@ public:
     // Sets SQL WHERE clause, without "WHERE" keyword.
     void setFilter(const QString &filter);
 
+    // Includes messages from archive database.
+    // NOTE: Archived messages are read-only, changes of them are not saved.
+    void setShowArchived(bool show_archived);
+
+    // Lists only messages which match given phrase, they are
+    // searched by full-text index of database.
+    void setSearchPhrase(const QString &phrase);
+
+    // Lists only unread messages and messages which are kept in the list.
+    bool showUnreadOnly() const;
+    void setShowUnreadOnly(bool show_unread_only);
+
+    // Messages with given IDs stay in the list even if they are read,
+    // so that messages do not disappear right after user reads them.
+    void keepMessages(const QVector<int> &ids);
+    void clearKeptMessages();
+
 protected:
+    // Forgets kept messages which are not in the list anymore.
+    void retainKeptMessages(const QHash<int, int> &listed_rows);
+
+    // Returns IDs of kept messages, select statements expect them
+    // stored with storeKeptMessages() in connection which runs them.
+    QStringList keptMessages() const;
+    static bool storeKeptMessages(const QSqlDatabase &db, const QStringList &ids);
+
     QString orderByClause() const;
     QString selectStatement() const;
     QString formatFields() const;
 
+    // Selects only IDs and read states of all messages in the list, in their final order.
+    QString idsStatement() const;
+
+    // Selects all columns of messages with given IDs, in no particular order.
+    QString rowsStatement(const QVector<int> &ids) const;
+
     QSqlDatabase m_db;
 
 private:
+    QString fromClause() const;
+    QString whereClause() const;
+
+    // Joins bodies of messages, only rows of the list need them
+    // for previews of contents, so IDs of messages are selected without them.
+    QString bodiesClause() const;
+    QString contentsField() const;
+    bool showsArchived() const;
+
     QString m_filter;
+    QString m_searchPhrase;
+    bool m_showArchived;
+    bool m_showUnreadOnly;
+    QSet<int> m_keptIds;
 
     // NOTE: These two lists contain data for multicolumn sorting.
     // They are always same length. Most important sort column/order
@@ -3,7 +3,6 @@
 #include "core/messagesproxymodel.h"
 
 #include "core/messagesmodel.h"
-#include "core/messagesmodelcache.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/regexfactory.h"
 #include "miscellaneous/settings.h"
@@ -11,7 +10,7 @@
 #include <QTimer>
 
 MessagesProxyModel::MessagesProxyModel(MessagesModel *source_model, QObject *parent)
-    : QSortFilterProxyModel(parent), m_sourceModel(source_model), m_showUnreadOnly(false)
+    : QSortFilterProxyModel(parent), m_sourceModel(source_model)
 {
     setObjectName(QSL("MessagesProxyModel"));
 
@@ -46,17 +45,25 @@ QModelIndex MessagesProxyModel::getNextPreviousUnreadItemIndex(int default_row)
 
 QModelIndex MessagesProxyModel::getNextUnreadItemIndex(int default_row, int max_row) const
 {
-    while (default_row <= max_row) {
-        // Get info if the message is read or not.
-        const QModelIndex proxy_index = index(default_row, MSG_DB_READ_INDEX);
-        const bool is_read = m_sourceModel->data(mapToSource(proxy_index).row(),
-                             MSG_DB_READ_INDEX, Qt::EditRole).toInt() == 1;
+    if (default_row > max_row) {
+        return QModelIndex();
+    }
+
+    // NOTE: Proxy does not sort messages, so rows keep order of source rows
+    // and source model can look up unread messages for us.
+    int source_row = mapToSource(index(default_row, MSG_DB_READ_INDEX)).row();
+
+    while ((source_row = m_sourceModel->nextUnreadRow(source_row)) >= 0) {
+        const QModelIndex proxy_index = mapFromSource(m_sourceModel->index(source_row, MSG_DB_READ_INDEX));
 
-        if (!is_read) {
+        if (!proxy_index.isValid()) {
+            // Message is filtered out, try next one.
+            source_row++;
+        } else if (proxy_index.row() > max_row) {
+            break;
+        } else {
             // We found unread message, mark it.
             return proxy_index;
-        } else {
-            default_row++;
         }
     }
 
@@ -74,26 +81,19 @@ bool MessagesProxyModel::lessThan(const QModelIndex &left, const QModelIndex &ri
 
 bool MessagesProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
-    // We want to show only regexped messages when "all" should be visible
-    // and we want to show only regexped AND unread messages when unread should be visible.
-    //
-    // But also, we want to see messages which have their dirty states cached, because
-    // otherwise they would just disappeaar from the list for example when batch marked as read
-    // which is distracting.
-    return
-        QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent) &&
-        (m_sourceModel->cache()->containsData(source_row) ||
-         (!m_showUnreadOnly || !m_sourceModel->messageAt(source_row).m_isRead));
+    // NOTE: Read messages and messages which do not match searched
+    // phrase are filtered out by SQL query of source model.
+    return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
 }
 
 bool MessagesProxyModel::showUnreadOnly() const
 {
-    return m_showUnreadOnly;
+    return m_sourceModel->showUnreadOnly();
 }
 
 void MessagesProxyModel::setShowUnreadOnly(bool show_unread_only)
 {
-    m_showUnreadOnly = show_unread_only;
+    m_sourceModel->setShowUnreadOnly(show_unread_only);
     qApp->settings()->setValue(GROUP(Messages), Messages::ShowOnlyUnreadMessages, show_unread_only);
 }
 
@@ -39,7 +39,6 @@ private:
 
     // Source model pointer.
     MessagesModel *m_sourceModel;
-    bool m_showUnreadOnly;
 };
 
 #endif // MESSAGESPROXYMODEL_H
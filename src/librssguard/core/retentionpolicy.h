@@ -0,0 +1,29 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#ifndef RETENTIONPOLICY_H
+#define RETENTIONPOLICY_H
+
+// Limits how many messages of a feed are kept in DB.
+// Policy can be set for feed or for category, in which case
+// it applies to all feeds under the category which do not
+// have their own policy.
+struct RetentionPolicy {
+public:
+
+    // Policy without any limit is "empty" and means that
+    // policy of parent category is used instead.
+    bool isEmpty() const {
+        return m_maxAge <= 0 && m_maxCount <= 0;
+    }
+
+    // Messages older than this count of days are removed, 0 means unlimited.
+    int m_maxAge = 0;
+
+    // Only this count of newest messages is kept, 0 means unlimited.
+    int m_maxCount = 0;
+
+    // Important (starred) messages are never removed and do not count to the limit.
+    bool m_keepImportant = true;
+};
+
+#endif // RETENTIONPOLICY_H
@@ -27,6 +27,14 @@
 #define MAX_MULTICOLUMN_SORT_STATES           3
 #define ENCLOSURES_OUTER_SEPARATOR            '#'
 #define ECNLOSURES_INNER_SEPARATOR            '&'
+#define MSG_COMPRESSED_CONTENTS_MARKER        "\001zlib:"
+#define MSG_COMPRESSED_CONTENTS_MIN_LENGTH    256
+#define MSG_COMPRESSION_BATCH_SIZE            500
+#define MSG_BULK_CHUNK_SIZE                   500
+#define MSG_ARCHIVE_BATCH_SIZE                500
+#define MSG_MODEL_PAGE_SIZE                   256
+#define MSG_MODEL_MAX_PAGES                   32
+#define MSG_CONTENTS_PREVIEW_LENGTH           256
 #define URI_SCHEME_FEED_SHORT                 "feed:"
 #define URI_SCHEME_FEED                       "feed://"
 #define URI_SCHEME_HTTP                       "http://"
@@ -123,6 +131,7 @@
 
 #define APP_DB_MYSQL_DRIVER           "QMYSQL"
 #define APP_DB_MYSQL_INIT             "db_init_mysql.sql"
+#define APP_DB_MYSQL_ARCHIVE          "db_archive_mysql.sql"
 #define APP_DB_MYSQL_TEST             "MySQLTest"
 #define APP_DB_MYSQL_PORT             3306
 
@@ -130,13 +139,25 @@
 #define APP_DB_SQLITE_INIT            "db_init_sqlite.sql"
 #define APP_DB_SQLITE_PATH            "database/local"
 #define APP_DB_SQLITE_FILE            "database.db"
+#define APP_DB_SQLITE_ARCHIVE         "db_archive_sqlite.sql"
+#define APP_DB_SQLITE_ARCHIVE_FILE    "archive.db"
 
 // Keep this in sync with schema versions declared in SQL initialization code.
-#define APP_DB_SCHEMA_VERSION         "16"
+#define APP_DB_SCHEMA_VERSION         "24"
 #define APP_DB_UPDATE_FILE_PATTERN    "db_update_%1_%2_%3.sql"
 #define APP_DB_COMMENT_SPLIT          "-- !\n"
 #define APP_DB_NAME_PLACEHOLDER       "##"
 
+// Background vacuuming runs in small steps when no feeds are being updated.
+#define APP_DB_VACUUM_INTERVAL        120000
+#define APP_DB_VACUUM_SQLITE_PAGES    256
+#define APP_DB_VACUUM_MYSQL_MIN_FREE  16777216
+#define APP_DB_WRITER_COMMIT_DELAY    5
+#define APP_DB_WRITER_MAX_BATCH       256
+
+// Old messages are moved to archive in batches, batches follow each other until all are moved.
+#define APP_DB_ARCHIVE_INTERVAL       600000
+
 #define APP_CFG_PATH        "config"
 #define APP_CFG_FILE        "config.ini"
 
@@ -226,6 +247,7 @@
 #define CAT_DB_ICON_INDEX         5
 #define CAT_DB_ACCOUNT_ID_INDEX   6
 #define CAT_DB_CUSTOM_ID_INDEX    7
+#define CAT_DB_ICON_ID_INDEX      8
 
 // Indexes of columns as they are DEFINED IN THE TABLE for FEEDS.
 #define FDS_DB_ID_INDEX               0
@@ -244,6 +266,7 @@
 #define FDS_DB_TYPE_INDEX             13
 #define FDS_DB_ACCOUNT_ID_INDEX       14
 #define FDS_DB_CUSTOM_ID_INDEX        15
+#define FDS_DB_ICON_ID_INDEX          16
 
 // Indexes of columns for feed models.
 #define FDS_MODEL_TITLE_INDEX           0
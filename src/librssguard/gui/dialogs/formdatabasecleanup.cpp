@@ -5,6 +5,7 @@
 #include "gui/guiutilities.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databasequeries.h"
 #include "miscellaneous/iconfactory.h"
 
 #include <QCloseEvent>
@@ -116,6 +117,19 @@ void FormDatabaseCleanup::loadDatabaseInfo()
                             tr("unknown");
 
     m_ui->m_txtFileSize->setText(tr("file: %1, data: %2").arg(file_size_str, data_size_str));
+
+    bool contents_size_ok;
+    const QPair<qint64, qint64> contents_size = DatabaseQueries::getMessageContentsSize(
+        qApp->database()->connection(metaObject()->className()), &contents_size_ok);
+
+    if (contents_size_ok) {
+        m_ui->m_txtContentsSize->setText(tr("plain: %1 MB, compressed: %2 MB").arg(
+                                             QString::number(contents_size.first / 1000000.0),
+                                             QString::number(contents_size.second / 1000000.0)));
+    } else {
+        m_ui->m_txtContentsSize->setText(tr("unknown"));
+    }
+
     m_ui->m_txtDatabaseType->setText(qApp->database()->humanDriverName(
                                          qApp->database()->activeDatabaseDriver()));
     m_ui->m_checkShrink->setChecked(m_ui->m_checkShrink->isEnabled());
@@ -0,0 +1,122 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#include "gui/dialogs/formdatabaseprofile.h"
+
+#include "exceptions/ioexception.h"
+#include "gui/guiutilities.h"
+#include "gui/messagebox.h"
+#include "miscellaneous/application.h"
+#include "miscellaneous/databaseprofiler.h"
+#include "miscellaneous/iconfactory.h"
+#include "miscellaneous/iofactory.h"
+
+#include <QFileDialog>
+#include <QPushButton>
+
+FormDatabaseProfile::FormDatabaseProfile(QWidget *parent) : QDialog(parent), m_ui(new Ui::FormDatabaseProfile)
+{
+    m_ui->setupUi(this);
+
+    GuiUtilities::applyDialogProperties(*this, qApp->icons()->fromTheme(QSL("utilities-system-monitor")));
+
+    QPushButton *btn_refresh = m_ui->m_btnBox->addButton(tr("&Refresh"), QDialogButtonBox::ActionRole);
+    QPushButton *btn_reset = m_ui->m_btnBox->addButton(tr("Re&set"), QDialogButtonBox::ResetRole);
+    QPushButton *btn_export = m_ui->m_btnBox->addButton(tr("&Export to JSON"), QDialogButtonBox::ActionRole);
+    QStringList buckets;
+
+    for (int bucket : DatabaseProfiler::histogramBuckets()) {
+        buckets.append(tr("< %1 ms").arg(bucket));
+    }
+
+    buckets.append(tr("more"));
+    m_ui->m_treeStatistics->headerItem()->setToolTip(7, tr("Count of calls which took: %1.").arg(buckets.join(QSL(", "))));
+    m_ui->m_checkProfileQueries->setChecked(DatabaseProfiler::isEnabled());
+    m_ui->m_spinSlowQueryThreshold->setValue(DatabaseProfiler::slowQueryThreshold());
+
+    connect(btn_refresh, &QPushButton::clicked, this, &FormDatabaseProfile::loadProfile);
+    connect(btn_reset, &QPushButton::clicked, this, &FormDatabaseProfile::resetProfile);
+    connect(btn_export, &QPushButton::clicked, this, &FormDatabaseProfile::exportProfile);
+    connect(m_ui->m_checkProfileQueries, &QCheckBox::toggled, this, &FormDatabaseProfile::saveSettings);
+    connect(m_ui->m_spinSlowQueryThreshold, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this,
+            &FormDatabaseProfile::saveSettings);
+
+    loadProfile();
+}
+
+void FormDatabaseProfile::loadProfile()
+{
+    const QMap<QString, DatabaseProfiler::Statistics> statistics = DatabaseProfiler::statistics();
+    const QMap<QString, QString> plans = DatabaseProfiler::queryPlans();
+
+    m_ui->m_treeStatistics->clear();
+
+    for (auto i = statistics.constBegin(); i != statistics.constEnd(); ++i) {
+        const DatabaseProfiler::Statistics &stats = i.value();
+        auto *item = new QTreeWidgetItem(m_ui->m_treeStatistics);
+        QStringList histogram;
+
+        for (int calls : stats.m_histogram) {
+            histogram.append(QString::number(calls));
+        }
+
+        item->setText(0, i.key());
+        item->setToolTip(0, stats.m_sql);
+        item->setData(1, Qt::DisplayRole, stats.m_calls);
+        item->setData(2, Qt::DisplayRole, stats.m_failures);
+        item->setData(3, Qt::DisplayRole, stats.m_totalTime / 1000.0);
+        item->setData(4, Qt::DisplayRole, stats.m_totalTime / 1000.0 / qMax(stats.m_calls, 1));
+        item->setData(5, Qt::DisplayRole, stats.m_maxTime / 1000.0);
+        item->setData(6, Qt::DisplayRole, stats.m_rowsAffected);
+        item->setText(7, histogram.join(QSL(" / ")));
+    }
+
+    // Most expensive statements are at the top.
+    m_ui->m_treeStatistics->sortItems(3, Qt::DescendingOrder);
+
+    for (int i = 0; i < m_ui->m_treeStatistics->columnCount(); i++) {
+        m_ui->m_treeStatistics->resizeColumnToContents(i);
+    }
+
+    QStringList plan_texts;
+
+    for (auto i = plans.constBegin(); i != plans.constEnd(); ++i) {
+        plan_texts.append(QSL("%1\n%2").arg(i.key(), i.value()));
+    }
+
+    m_ui->m_txtQueryPlans->setPlainText(plan_texts.join(QSL("\n\n")));
+}
+
+void FormDatabaseProfile::resetProfile()
+{
+    DatabaseProfiler::reset();
+    loadProfile();
+}
+
+void FormDatabaseProfile::exportProfile()
+{
+    QString selected_file = QFileDialog::getSaveFileName(this, tr("Select file for profile export"),
+                                                         qApp->homeFolder(), tr("JSON files (*.json)"));
+
+    if (selected_file.isEmpty()) {
+        return;
+    }
+
+    if (!selected_file.endsWith(QL1S(".json"))) {
+        selected_file += QL1S(".json");
+    }
+
+    try {
+        IOFactory::writeFile(selected_file, DatabaseProfiler::toJson());
+    } catch (IOException &ex) {
+        MessageBox::show(this, QMessageBox::Critical, tr("Cannot export profile"), ex.message());
+    }
+}
+
+void FormDatabaseProfile::saveSettings()
+{
+    DatabaseProfiler::setEnabled(m_ui->m_checkProfileQueries->isChecked());
+    DatabaseProfiler::setSlowQueryThreshold(m_ui->m_spinSlowQueryThreshold->value());
+
+    qApp->settings()->setValue(GROUP(Database), Database::ProfileQueries, DatabaseProfiler::isEnabled());
+    qApp->settings()->setValue(GROUP(Database), Database::SlowQueryThreshold, DatabaseProfiler::slowQueryThreshold());
+}
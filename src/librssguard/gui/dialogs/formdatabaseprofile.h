@@ -0,0 +1,29 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#ifndef FORMDATABASEPROFILE_H
+#define FORMDATABASEPROFILE_H
+
+#include <QDialog>
+
+#include "ui_formdatabaseprofile.h"
+
+// Displays statistics collected by database profiler.
+class FormDatabaseProfile : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit FormDatabaseProfile(QWidget *parent = nullptr);
+    virtual ~FormDatabaseProfile() = default;
+
+private slots:
+    void loadProfile();
+    void resetProfile();
+    void exportProfile();
+    void saveSettings();
+
+private:
+    QScopedPointer<Ui::FormDatabaseProfile> m_ui;
+};
+
+#endif // FORMDATABASEPROFILE_H
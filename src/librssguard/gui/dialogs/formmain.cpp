@@ -7,6 +7,7 @@
 #include "gui/dialogs/formaddaccount.h"
 #include "gui/dialogs/formbackupdatabasesettings.h"
 #include "gui/dialogs/formdatabasecleanup.h"
+#include "gui/dialogs/formdatabaseprofile.h"
 #include "gui/dialogs/formrestoredatabasesettings.h"
 #include "gui/dialogs/formsettings.h"
 #include "gui/dialogs/formupdate.h"
@@ -128,6 +129,11 @@ void FormMain::showDbCleanupAssistant()
     }
 }
 
+void FormMain::showDatabaseProfile()
+{
+    FormDatabaseProfile(this).exec();
+}
+
 QList<QAction *> FormMain::allActions() const
 {
     QList<QAction *> actions;
@@ -166,6 +172,7 @@ QList<QAction *> FormMain::allActions() const
     actions << m_ui->m_actionShowOnlyUnreadItems;
     actions << m_ui->m_actionShowTreeBranches;
     actions << m_ui->m_actionShowOnlyUnreadMessages;
+    actions << m_ui->m_actionShowArchivedMessages;
     actions << m_ui->m_actionMarkSelectedMessagesAsRead;
     actions << m_ui->m_actionMarkSelectedMessagesAsUnread;
     actions << m_ui->m_actionSwitchImportanceOfSelectedMessages;
@@ -180,6 +187,7 @@ QList<QAction *> FormMain::allActions() const
     actions << m_ui->m_actionServiceEdit;
     actions << m_ui->m_actionServiceDelete;
     actions << m_ui->m_actionCleanupDatabase;
+    actions << m_ui->m_actionDatabaseProfile;
     actions << m_ui->m_actionAddFeedIntoSelectedAccount;
     actions << m_ui->m_actionAddCategoryIntoSelectedAccount;
     actions << m_ui->m_actionViewSelectedItemsNewspaperMode;
@@ -379,7 +387,7 @@ void FormMain::onFeedUpdatesFinished(const FeedDownloadResults &results)
 {
     Q_UNUSED(results)
     statusBar()->clearProgressFeeds();
-    tabWidget()->feedMessageViewer()->messagesView()->reloadSelections();
+    tabWidget()->feedMessageViewer()->messagesView()->refreshMessages();
 }
 
 void FormMain::onFeedUpdatesStarted()
@@ -493,6 +501,7 @@ void FormMain::setupIcons()
     m_ui->m_actionAboutGuard->setIcon(icon_theme_factory->fromTheme(QSL("help-about")));
     m_ui->m_actionCheckForUpdates->setIcon(icon_theme_factory->fromTheme(QSL("system-upgrade")));
     m_ui->m_actionCleanupDatabase->setIcon(icon_theme_factory->fromTheme(QSL("edit-clear")));
+    m_ui->m_actionDatabaseProfile->setIcon(icon_theme_factory->fromTheme(QSL("utilities-system-monitor")));
     m_ui->m_actionReportBug->setIcon(icon_theme_factory->fromTheme(QSL("call-start")));
     m_ui->m_actionBackupDatabaseSettings->setIcon(icon_theme_factory->fromTheme(
                 QSL("document-export")));
@@ -551,6 +560,7 @@ void FormMain::setupIcons()
     m_ui->m_actionShowOnlyUnreadItems->setIcon(icon_theme_factory->fromTheme(QSL("mail-mark-unread")));
     m_ui->m_actionShowOnlyUnreadMessages->setIcon(icon_theme_factory->fromTheme(
                 QSL("mail-mark-unread")));
+    m_ui->m_actionShowArchivedMessages->setIcon(icon_theme_factory->fromTheme(QSL("document-open-recent")));
     m_ui->m_actionExpandCollapseItem->setIcon(icon_theme_factory->fromTheme(QSL("format-indent-more")));
     m_ui->m_actionRestoreSelectedMessages->setIcon(icon_theme_factory->fromTheme(QSL("view-refresh")));
     m_ui->m_actionRestoreAllRecycleBins->setIcon(icon_theme_factory->fromTheme(QSL("view-refresh")));
@@ -633,6 +643,9 @@ void FormMain::loadSize()
             SETTING(Feeds::ShowTreeBranches)).toBool());
     m_ui->m_actionShowOnlyUnreadMessages->setChecked(settings->value(GROUP(Messages),
             SETTING(Messages::ShowOnlyUnreadMessages)).toBool());
+
+    // Archived messages can be shown only if there is some archive.
+    m_ui->m_actionShowArchivedMessages->setEnabled(qApp->database()->archiveAvailable());
 }
 
 void FormMain::saveSize()
@@ -702,6 +715,8 @@ void FormMain::createConnections()
             &TabWidget::showDownloadManager);
     connect(m_ui->m_actionCleanupDatabase, &QAction::triggered, this,
             &FormMain::showDbCleanupAssistant);
+    connect(m_ui->m_actionDatabaseProfile, &QAction::triggered, this,
+            &FormMain::showDatabaseProfile);
 
     // Menu "Help" connections.
     connect(m_ui->m_actionAboutGuard, &QAction::triggered, this, [this]() {
@@ -826,6 +841,8 @@ void FormMain::createConnections()
             tabWidget()->feedMessageViewer(), &FeedMessageViewer::toggleShowFeedTreeBranches);
     connect(m_ui->m_actionShowOnlyUnreadMessages, &QAction::toggled,
             tabWidget()->feedMessageViewer(), &FeedMessageViewer::toggleShowOnlyUnreadMessages);
+    connect(m_ui->m_actionShowArchivedMessages, &QAction::toggled,
+            tabWidget()->feedMessageViewer(), &FeedMessageViewer::toggleShowArchivedMessages);
     connect(m_ui->m_actionRestoreSelectedMessages, &QAction::triggered,
             tabWidget()->feedMessageViewer()->messagesView(), &MessagesView::restoreSelectedMessages);
     connect(m_ui->m_actionRestoreAllRecycleBins, &QAction::triggered,
@@ -71,6 +71,7 @@ private slots:
     void restoreDatabaseSettings();
     void showWiki();
     void showDbCleanupAssistant();
+    void showDatabaseProfile();
     void reportABug();
     void donate();
 
@@ -199,6 +199,13 @@ void FeedMessageViewer::toggleShowOnlyUnreadMessages()
     }
 }
 
+void FeedMessageViewer::toggleShowArchivedMessages()
+{
+    const QAction *origin = qobject_cast<QAction *>(sender());
+
+    m_messagesView->switchShowArchived(origin != nullptr && origin->isChecked());
+}
+
 void FeedMessageViewer::toggleShowOnlyUnreadFeeds()
 {
     const QAction *origin = qobject_cast<QAction *>(sender());
@@ -66,6 +66,7 @@ public slots:
     void switchFeedComponentVisibility();
 
     void toggleShowOnlyUnreadMessages();
+    void toggleShowArchivedMessages();
     void toggleShowOnlyUnreadFeeds();
     void toggleShowFeedTreeBranches();
 
@@ -6,6 +6,7 @@
 #include "gui/messagebox.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "network-web/webfactory.h"
 #include "services/abstract/serviceroot.h"
 
@@ -174,13 +175,17 @@ void MessagePreviewer::markMessageAsReadUnread(RootItem::ReadStatus read)
         if (m_root->getParentServiceRoot()->onBeforeSetMessagesRead(m_root.data(),
                 QList<Message>() << m_message,
                 read)) {
-            DatabaseQueries::markMessagesReadUnread(qApp->database()->connection(objectName(),
-                                                    DatabaseFactory::DesiredType::FromSettings),
-                                                    QStringList() << QString::number(m_message.m_id),
-                                                    read);
-            m_root->getParentServiceRoot()->onAfterSetMessagesRead(m_root.data(),
-                    QList<Message>() << m_message,
-                    read);
+            const QStringList message_ids = QStringList() << QString::number(m_message.m_id);
+            const QPointer<RootItem> root = m_root;
+            const Message message = m_message;
+
+            DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids, read](const QSqlDatabase &db) {
+                return DatabaseQueries::markMessagesReadUnread(db, message_ids, read);
+            }), this, [root, message, read]() {
+                if (!root.isNull()) {
+                    root->getParentServiceRoot()->onAfterSetMessagesRead(root.data(), QList<Message>() << message, read);
+                }
+            });
             m_message.m_isRead = read == RootItem::ReadStatus::Read;
             emit markMessageRead(m_message.m_id, read);
 
@@ -199,15 +204,20 @@ void MessagePreviewer::switchMessageImportance(bool checked)
                                     m_isImportant
                                     ? RootItem::Importance::NotImportant
                                     : RootItem::Importance::Important))) {
-            DatabaseQueries::switchMessagesImportance(qApp->database()->connection(objectName(),
-                    DatabaseFactory::DesiredType::FromSettings),
-                    QStringList() << QString::number(m_message.m_id));
-            m_root->getParentServiceRoot()->onAfterSwitchMessageImportance(m_root.data(),
-                    QList<ImportanceChange>()
-                    << ImportanceChange(m_message,
-                                        m_message.m_isImportant
-                                        ? RootItem::Importance::NotImportant
-                                        : RootItem::Importance::Important));
+            const QStringList message_ids = QStringList() << QString::number(m_message.m_id);
+            const QPointer<RootItem> root = m_root;
+            const ImportanceChange change(m_message, m_message.m_isImportant
+                                          ? RootItem::Importance::NotImportant
+                                          : RootItem::Importance::Important);
+
+            DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids](const QSqlDatabase &db) {
+                return DatabaseQueries::switchMessagesImportance(db, message_ids);
+            }), this, [root, change]() {
+                if (!root.isNull()) {
+                    root->getParentServiceRoot()->onAfterSwitchMessageImportance(root.data(),
+                            QList<ImportanceChange>() << change);
+                }
+            });
             emit markMessageImportant(m_message.m_id, checked
                                       ? RootItem::Importance::Important
                                       : RootItem::Importance::NotImportant);
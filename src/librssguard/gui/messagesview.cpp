@@ -25,7 +25,7 @@
 #include <QTimer>
 
 MessagesView::MessagesView(QWidget *parent) : QTreeView(parent), m_contextMenu(nullptr),
-    m_columnsAdjusted(false)
+    m_columnsAdjusted(false), m_reselectPending(false), m_reselectMessageId(0), m_selectNextUnreadPending(false)
 {
     m_sourceModel = qApp->feedReader()->messagesModel();
     m_proxyModel = qApp->feedReader()->messagesProxyModel();
@@ -80,6 +80,9 @@ void MessagesView::createConnections()
     // Adjust columns when layout gets changed.
     connect(header(), &QHeaderView::geometriesChanged, this, &MessagesView::adjustColumns);
     connect(header(), &QHeaderView::sortIndicatorChanged, this, &MessagesView::onSortIndicatorChanged);
+
+    connect(m_sourceModel, &MessagesModel::loadingStarted, this, &MessagesView::onLoadingStarted);
+    connect(m_sourceModel, &MessagesModel::loadingFinished, this, &MessagesView::onLoadingFinished);
 }
 
 void MessagesView::keyboardSearch(const QString &search)
@@ -93,53 +96,90 @@ void MessagesView::keyboardSearch(const QString &search)
 
 void MessagesView::reloadSelections()
 {
-    const QDateTime dt1 = QDateTime::currentDateTime();
-    QModelIndex current_index = selectionModel()->currentIndex();
-    const QModelIndex mapped_current_index = m_proxyModel->mapToSource(current_index);
-    const Message selected_message = m_sourceModel->messageAt(mapped_current_index.row());
+    if (!m_reselectPending) {
+        // Message is remembered only once, list shows the same
+        // messages until new ones are loaded.
+        const QModelIndex mapped_current_index = m_proxyModel->mapToSource(selectionModel()->currentIndex());
+
+        m_reselectMessageId = m_sourceModel->messageAt(mapped_current_index.row()).m_id;
+        m_reselectPending = true;
+        m_reselectTimer.start();
+    }
+
     const int col = header()->sortIndicatorSection();
     const Qt::SortOrder ord = header()->sortIndicatorOrder();
 
-    // Reload the model now.
+    // Reload the model now, previously focused message
+    // is selected again when messages are loaded.
     sort(col, ord, true, false, false);
+}
 
-    // Now, we must find the same previously focused message.
-    if (selected_message.m_id > 0) {
-        if (m_proxyModel->rowCount() == 0) {
-            current_index = QModelIndex();
-        } else {
-            for (int i = 0; i < m_proxyModel->rowCount(); i++) {
-                QModelIndex msg_idx = m_proxyModel->index(i, MSG_DB_TITLE_INDEX);
-                Message msg = m_sourceModel->messageAt(m_proxyModel->mapToSource(msg_idx).row());
+void MessagesView::refreshMessages()
+{
+    if (!m_reselectPending) {
+        // Message is selected again only if model
+        // had to be reset instead of refreshed.
+        const QModelIndex mapped_current_index = m_proxyModel->mapToSource(selectionModel()->currentIndex());
 
-                if (msg.m_id == selected_message.m_id) {
-                    current_index = msg_idx;
-                    break;
-                }
+        m_reselectMessageId = m_sourceModel->messageAt(mapped_current_index.row()).m_id;
+        m_reselectPending = true;
+        m_reselectTimer.start();
+    }
 
-                if (i == m_proxyModel->rowCount() - 1) {
-                    current_index = QModelIndex();
-                }
+    m_sourceModel->refreshMessages();
+}
+
+void MessagesView::onLoadingStarted()
+{
+    viewport()->setCursor(Qt::BusyCursor);
+}
+
+void MessagesView::onLoadingFinished()
+{
+    viewport()->unsetCursor();
+
+    const QModelIndex mapped_current_index = m_proxyModel->mapToSource(currentIndex());
+
+    if (m_reselectPending && mapped_current_index.isValid() &&
+        m_sourceModel->messageId(mapped_current_index.row()) == m_reselectMessageId) {
+        // Message list was refreshed and focused message stayed where it was.
+        m_reselectPending = false;
+    }
+
+    if (m_reselectPending) {
+        QModelIndex current_index;
+
+        m_reselectPending = false;
+
+        // Now, we must find the same previously focused message.
+        if (m_reselectMessageId > 0) {
+            const int source_row = m_sourceModel->rowForMessageId(m_reselectMessageId);
+
+            if (source_row >= 0) {
+                current_index = m_proxyModel->mapFromSource(m_sourceModel->index(source_row, MSG_DB_TITLE_INDEX));
             }
         }
-    }
 
-    if (current_index.isValid()) {
-        scrollTo(current_index);
-        setCurrentIndex(current_index);
-        reselectIndexes(QModelIndexList() << current_index);
-    } else {
-        // Messages were probably removed from the model, nothing can
-        // be selected and no message can be displayed.
-        emit currentMessageRemoved();
-    }
+        if (current_index.isValid()) {
+            scrollTo(current_index);
+            setCurrentIndex(current_index);
+            reselectIndexes(QModelIndexList() << current_index);
+        } else {
+            // Messages were probably removed from the model, nothing can
+            // be selected and no message can be displayed.
+            emit currentMessageRemoved();
+        }
 
-    const QDateTime dt2 = QDateTime::currentDateTime();
+        qDebugNN << LOGSEC_GUI
+                 << "Reloading of msg selections took "
+                 << m_reselectTimer.elapsed()
+                 << " miliseconds.";
+    }
 
-    qDebugNN << LOGSEC_GUI
-             << "Reloading of msg selections took "
-             << dt1.msecsTo(dt2)
-             << " miliseconds.";
+    if (m_selectNextUnreadPending) {
+        m_selectNextUnreadPending = false;
+        selectNextUnreadItem();
+    }
 }
 
 void MessagesView::setupAppearance()
@@ -276,7 +316,7 @@ void MessagesView::mousePressEvent(QMouseEvent *event)
 
                 if (mapped_index.column() == MSG_DB_IMPORTANT_INDEX) {
                     if (m_sourceModel->switchMessageImportance(mapped_index.row())) {
-                        emit currentMessageChanged(m_sourceModel->messageAt(mapped_index.row()),
+                        emit currentMessageChanged(m_sourceModel->messageWithBodyAt(mapped_index.row()),
                                                    m_sourceModel->loadedItem());
                     }
                 }
@@ -325,7 +365,7 @@ void MessagesView::selectionChanged(const QItemSelection &selected,
              << mapped_current_index << "'.";
 
     if (mapped_current_index.isValid() && selected_rows.count() > 0) {
-        Message message = m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row());
+        Message message = m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row());
 
         // Set this message as read only if current item
         // wasn't changed by "mark selected messages unread" action.
@@ -349,6 +389,10 @@ void MessagesView::loadItem(RootItem *item)
     const int col = header()->sortIndicatorSection();
     const Qt::SortOrder ord = header()->sortIndicatorOrder();
 
+    // Messages of other item are loaded, nothing will be reselected.
+    m_reselectPending = false;
+    m_selectNextUnreadPending = false;
+
     scrollToTop();
     sort(col, ord, false, true, false);
     m_sourceModel->loadMessages(item);
@@ -367,6 +411,12 @@ void MessagesView::switchShowUnreadOnly(bool set_new_value, bool show_unread_onl
     reloadSelections();
 }
 
+void MessagesView::switchShowArchived(bool show_archived)
+{
+    m_sourceModel->setShowArchived(show_archived);
+    reloadSelections();
+}
+
 void MessagesView::openSelectedSourceMessagesExternally()
 {
     for (const QModelIndex &index : selectionModel()->selectedRows()) {
@@ -393,7 +443,7 @@ void MessagesView::openSelectedMessagesInternally()
     QList<Message> messages;
 
     for (const QModelIndex &index : selectionModel()->selectedRows()) {
-        messages << m_sourceModel->messageAt(m_proxyModel->mapToSource(index).row());
+        messages << m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(index).row());
     }
 
     if (!messages.isEmpty()) {
@@ -404,7 +454,7 @@ void MessagesView::openSelectedMessagesInternally()
 void MessagesView::sendSelectedMessageViaEmail()
 {
     if (selectionModel()->selectedRows().size() == 1) {
-        const Message message = m_sourceModel->messageAt(m_proxyModel->mapToSource(
+        const Message message = m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(
                                     selectionModel()->selectedRows().at(0)).row());
 
         if (!qApp->web()->sendMessageViaEmail(message)) {
@@ -439,7 +489,7 @@ void MessagesView::setSelectedMessagesReadStatus(RootItem::ReadStatus read)
     current_index = m_proxyModel->index(current_index.row(), current_index.column());
 
     if (current_index.isValid()) {
-        emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()),
+        emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()),
                                    m_sourceModel->loadedItem());
     } else {
         emit currentMessageRemoved();
@@ -463,7 +513,7 @@ void MessagesView::deleteSelectedMessages()
     if (current_index.isValid()) {
         setCurrentIndex(current_index);
 
-        emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()),
+        emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()),
                                    m_sourceModel->loadedItem());
     } else {
         emit currentMessageRemoved();
@@ -485,7 +535,7 @@ void MessagesView::restoreSelectedMessages()
     current_index = m_proxyModel->index(current_index.row(), current_index.column());
 
     if (current_index.isValid()) {
-        emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()),
+        emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()),
                                    m_sourceModel->loadedItem());
     } else {
         emit currentMessageRemoved();
@@ -507,7 +557,7 @@ void MessagesView::switchSelectedMessagesImportance()
     current_index = m_proxyModel->index(current_index.row(), current_index.column());
 
     if (current_index.isValid()) {
-        emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()),
+        emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()),
                                    m_sourceModel->loadedItem());
     } else {
         // Messages were probably removed from the model, nothing can
@@ -554,6 +604,12 @@ void MessagesView::selectPreviousItem()
 
 void MessagesView::selectNextUnreadItem()
 {
+    if (m_sourceModel->isLoading()) {
+        // Messages of newly selected item are not loaded yet.
+        m_selectNextUnreadPending = true;
+        return;
+    }
+
     const QModelIndexList selected_rows = selectionModel()->selectedRows();
     int active_row;
 
@@ -577,14 +633,10 @@ void MessagesView::selectNextUnreadItem()
 
 void MessagesView::searchMessages(const QString &pattern)
 {
-    m_proxyModel->setFilterRegExp(pattern);
-
-    if (selectionModel()->selectedRows().isEmpty()) {
-        emit currentMessageRemoved();
-    } else {
-        // Scroll to selected message, it could become scrolled out due to filter change.
-        scrollTo(selectionModel()->selectedRows().at(0));
-    }
+    // Messages are searched by database, so that all messages
+    // are searched, not only those which are loaded in the list.
+    m_sourceModel->setSearchPhrase(pattern);
+    reloadSelections();
 }
 
 void MessagesView::filterMessages(MessagesModel::MessageHighlighter filter)
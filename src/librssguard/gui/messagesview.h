@@ -7,6 +7,7 @@
 
 #include "services/abstract/rootitem.h"
 
+#include <QElapsedTimer>
 #include <QHeaderView>
 #include <QTreeView>
 
@@ -32,6 +33,10 @@ public slots:
     // and it needs to be reloaded to the view.
     void reloadSelections();
 
+    // Called after new messages were added, only changes of
+    // messages are loaded and selections are kept.
+    void refreshMessages();
+
     // Loads un-deleted messages from selected feeds.
     void loadItem(RootItem *item);
 
@@ -57,10 +62,17 @@ public slots:
     void filterMessages(MessagesModel::MessageHighlighter filter);
 
     void switchShowUnreadOnly(bool set_new_value = false, bool show_unread_only = false);
+    void switchShowArchived(bool show_archived);
 
 private slots:
     void openSelectedMessagesWithExternalTool();
 
+    // Shows that message list is being loaded.
+    void onLoadingStarted();
+
+    // Finishes actions which were waiting for messages to load.
+    void onLoadingFinished();
+
     // Marks given indexes as selected.
     void reselectIndexes(const QModelIndexList &indexes);
 
@@ -104,6 +116,12 @@ private:
     MessagesProxyModel *m_proxyModel;
     MessagesModel *m_sourceModel;
     bool m_columnsAdjusted;
+
+    // Actions which are postponed until messages are loaded.
+    bool m_reselectPending;
+    int m_reselectMessageId;
+    QElapsedTimer m_reselectTimer;
+    bool m_selectNextUnreadPending;
 };
 
 inline MessagesProxyModel *MessagesView::model() const
@@ -6,6 +6,7 @@
 #include "gui/guiutilities.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasefactory.h"
+#include "miscellaneous/feedreader.h"
 
 SettingsDatabase::SettingsDatabase(Settings *settings, QWidget *parent)
     : SettingsPanel(settings, parent), m_ui(new Ui::SettingsDatabase)
@@ -27,6 +28,14 @@ SettingsDatabase::SettingsDatabase(Settings *settings, QWidget *parent)
             &SettingsDatabase::dirtifySettings);
     connect(m_ui->m_checkUseTransactions, &QCheckBox::toggled, this,
             &SettingsDatabase::dirtifySettings);
+    connect(m_ui->m_checkCompressContents, &QCheckBox::toggled, this,
+            &SettingsDatabase::dirtifySettings);
+    connect(m_ui->m_checkArchiveMessages, &QCheckBox::toggled, this,
+            &SettingsDatabase::dirtifySettings);
+    connect(m_ui->m_checkArchiveMessages, &QCheckBox::toggled, m_ui->m_spinArchiveAfterDays,
+            &QSpinBox::setEnabled);
+    connect(m_ui->m_spinArchiveAfterDays, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this,
+            &SettingsDatabase::dirtifySettings);
     connect(m_ui->m_txtMysqlUsername->lineEdit(), &QLineEdit::textChanged, this,
             &SettingsDatabase::dirtifySettings);
     connect(m_ui->m_spinMysqlPort, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this,
@@ -157,6 +166,18 @@ void SettingsDatabase::loadSettings()
     onBeginLoadSettings();
     m_ui->m_checkUseTransactions->setChecked(qApp->settings()->value(GROUP(Database),
             SETTING(Database::UseTransactions)).toBool());
+    m_ui->m_checkCompressContents->setChecked(qApp->settings()->value(GROUP(Database),
+            SETTING(Database::CompressContents)).toBool());
+
+    const int archive_after_days = qApp->settings()->value(GROUP(Database),
+                                   SETTING(Database::ArchiveAfterDays)).toInt();
+
+    m_ui->m_checkArchiveMessages->setChecked(archive_after_days > 0);
+
+    if (archive_after_days > 0) {
+        m_ui->m_spinArchiveAfterDays->setValue(archive_after_days);
+    }
+
     m_ui->m_lblMysqlTestResult->setStatus(WidgetWithStatus::StatusType::Information,
                                           tr("No connection test triggered so far."),
                                           tr("You did not executed any connection test yet."));
@@ -220,6 +241,31 @@ void SettingsDatabase::saveSettings()
     qApp->settings()->setValue(GROUP(Database), Database::UseTransactions,
                                m_ui->m_checkUseTransactions->isChecked());
 
+    // Messages stored while compression was off need to be compressed now.
+    const bool original_compress = settings()->value(GROUP(Database),
+                                   SETTING(Database::CompressContents)).toBool();
+    const bool new_compress = m_ui->m_checkCompressContents->isChecked();
+
+    qApp->settings()->setValue(GROUP(Database), Database::CompressContents, new_compress);
+
+    if (new_compress && !original_compress) {
+        qApp->settings()->setValue(GROUP(Database), Database::CompressContentsMigrated, false);
+        qApp->feedReader()->compressStoredMessageContents();
+    }
+
+    // Archive database is created/attached when application starts.
+    const int original_archive_after_days = settings()->value(GROUP(Database),
+                                            SETTING(Database::ArchiveAfterDays)).toInt();
+    const int new_archive_after_days = m_ui->m_checkArchiveMessages->isChecked()
+                                       ? m_ui->m_spinArchiveAfterDays->value()
+                                       : 0;
+
+    qApp->settings()->setValue(GROUP(Database), Database::ArchiveAfterDays, new_archive_after_days);
+
+    if ((original_archive_after_days > 0) != (new_archive_after_days > 0)) {
+        requireRestart();
+    }
+
     // Save data storage settings.
     QString original_db_driver = settings()->value(GROUP(Database),
                                  SETTING(Database::ActiveDriver)).toString();
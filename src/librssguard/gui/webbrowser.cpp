@@ -9,6 +9,7 @@
 #include "gui/webviewer.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "network-web/networkfactory.h"
 #include "network-web/webfactory.h"
 #include "services/abstract/serviceroot.h"
@@ -292,12 +293,19 @@ void WebBrowser::markMessageAsRead(int id, bool read)
                 read
                 ? RootItem::ReadStatus::Read
                 : RootItem::ReadStatus::Unread)) {
-            DatabaseQueries::markMessagesReadUnread(qApp->database()->connection(objectName()),
-                                                    QStringList() << QString::number(msg->m_id),
-                                                    read ? RootItem::ReadStatus::Read : RootItem::ReadStatus::Unread);
-            m_root->getParentServiceRoot()->onAfterSetMessagesRead(m_root.data(),
-                    QList<Message>() << *msg,
-                    read ? RootItem::ReadStatus::Read : RootItem::ReadStatus::Unread);
+            const QStringList message_ids = QStringList() << QString::number(msg->m_id);
+            const RootItem::ReadStatus status = read ? RootItem::ReadStatus::Read : RootItem::ReadStatus::Unread;
+            const QPointer<RootItem> root = m_root;
+            const Message message = *msg;
+
+            DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids,
+                                          status](const QSqlDatabase &db) {
+                return DatabaseQueries::markMessagesReadUnread(db, message_ids, status);
+            }), this, [root, message, status]() {
+                if (!root.isNull()) {
+                    root->getParentServiceRoot()->onAfterSetMessagesRead(root.data(), QList<Message>() << message, status);
+                }
+            });
             emit markMessageRead(msg->m_id, read ? RootItem::ReadStatus::Read : RootItem::ReadStatus::Unread);
 
             msg->m_isRead = read;
@@ -317,14 +325,20 @@ void WebBrowser::switchMessageImportance(int id, bool checked)
                                             msg->m_isImportant
                                             ? RootItem::Importance::NotImportant
                                             : RootItem::Importance::Important))) {
-            DatabaseQueries::switchMessagesImportance(qApp->database()->connection(objectName()),
-                    QStringList() << QString::number(msg->m_id));
-            m_root->getParentServiceRoot()->onAfterSwitchMessageImportance(m_root.data(),
-                    QList<ImportanceChange>()
-                    << ImportanceChange(*msg,
-                                        msg->m_isImportant ?
-                                        RootItem::Importance::NotImportant :
-                                        RootItem::Importance::Important));
+            const QStringList message_ids = QStringList() << QString::number(msg->m_id);
+            const QPointer<RootItem> root = m_root;
+            const ImportanceChange change(*msg, msg->m_isImportant
+                                          ? RootItem::Importance::NotImportant
+                                          : RootItem::Importance::Important);
+
+            DatabaseWriter::whenCommitted(qApp->database()->writer()->enqueue([message_ids](const QSqlDatabase &db) {
+                return DatabaseQueries::switchMessagesImportance(db, message_ids);
+            }), this, [root, change]() {
+                if (!root.isNull()) {
+                    root->getParentServiceRoot()->onAfterSwitchMessageImportance(root.data(),
+                            QList<ImportanceChange>() << change);
+                }
+            });
             emit markMessageImportant(msg->m_id, msg->m_isImportant
                                       ? RootItem::Importance::NotImportant
                                       : RootItem::Importance::Important);
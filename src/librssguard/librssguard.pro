@@ -38,6 +38,7 @@ HEADERS += core/feeddownloader.h \
            core/messagesmodelcache.h \
            core/messagesmodelsqllayer.h \
            core/messagesproxymodel.h \
+           core/retentionpolicy.h \
            definitions/definitions.h \
            dynamic-shortcuts/dynamicshortcuts.h \
            dynamic-shortcuts/dynamicshortcutswidget.h \
@@ -52,6 +53,7 @@ HEADERS += core/feeddownloader.h \
            gui/dialogs/formaddaccount.h \
            gui/dialogs/formbackupdatabasesettings.h \
            gui/dialogs/formdatabasecleanup.h \
+           gui/dialogs/formdatabaseprofile.h \
            gui/dialogs/formmain.h \
            gui/dialogs/formmessagefiltersmanager.h \
            gui/dialogs/formrestoredatabasesettings.h \
@@ -93,7 +95,9 @@ HEADERS += core/feeddownloader.h \
            miscellaneous/autosaver.h \
            miscellaneous/databasecleaner.h \
            miscellaneous/databasefactory.h \
+           miscellaneous/databaseprofiler.h \
            miscellaneous/databasequeries.h \
+           miscellaneous/databasewriter.h \
            miscellaneous/externaltool.h \
            miscellaneous/feedreader.h \
            miscellaneous/iconfactory.h \
@@ -196,6 +200,7 @@ SOURCES += core/feeddownloader.cpp \
            gui/dialogs/formaddaccount.cpp \
            gui/dialogs/formbackupdatabasesettings.cpp \
            gui/dialogs/formdatabasecleanup.cpp \
+           gui/dialogs/formdatabaseprofile.cpp \
            gui/dialogs/formmain.cpp \
            gui/dialogs/formmessagefiltersmanager.cpp \
            gui/dialogs/formrestoredatabasesettings.cpp \
@@ -237,7 +242,9 @@ SOURCES += core/feeddownloader.cpp \
            miscellaneous/autosaver.cpp \
            miscellaneous/databasecleaner.cpp \
            miscellaneous/databasefactory.cpp \
+           miscellaneous/databaseprofiler.cpp \
            miscellaneous/databasequeries.cpp \
+           miscellaneous/databasewriter.cpp \
            miscellaneous/externaltool.cpp \
            miscellaneous/feedreader.cpp \
            miscellaneous/iconfactory.cpp \
@@ -320,6 +327,7 @@ FORMS += gui/dialogs/formabout.ui \
          gui/dialogs/formaddaccount.ui \
          gui/dialogs/formbackupdatabasesettings.ui \
          gui/dialogs/formdatabasecleanup.ui \
+         gui/dialogs/formdatabaseprofile.ui \
          gui/dialogs/formmain.ui \
          gui/dialogs/formmessagefiltersmanager.ui \
          gui/dialogs/formrestoredatabasesettings.ui \
@@ -10,6 +10,7 @@
 #include "gui/feedsview.h"
 #include "gui/messagebox.h"
 #include "gui/statusbar.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/feedreader.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/iofactory.h"
@@ -518,6 +519,7 @@ void Application::onAboutToQuit()
     }
 
     qApp->feedReader()->quit();
+    database()->writer()->stop();
     database()->saveDatabase();
 
     if (mainForm() != nullptr) {
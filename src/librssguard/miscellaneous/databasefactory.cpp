@@ -4,10 +4,14 @@
 
 #include "gui/messagebox.h"
 #include "miscellaneous/application.h"
+#include "miscellaneous/databaseprofiler.h"
+#include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/iofactory.h"
 #include "miscellaneous/textfactory.h"
 
 #include <QDir>
+#include <QMutexLocker>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QVariant>
@@ -15,11 +19,15 @@
 DatabaseFactory::DatabaseFactory(QObject *parent)
     : QObject(parent),
       m_activeDatabaseDriver(UsedDriver::SQLITE),
+      m_archiveAvailable(false),
+      m_writer(new DatabaseWriter(this)),
       m_mysqlDatabaseInitialized(false),
       m_sqliteFileBasedDatabaseInitialized(false),
-      m_sqliteInMemoryDatabaseInitialized(false)
+      m_sqliteInMemoryDatabaseInitialized(false),
+      m_sqliteArchiveInitialized(false)
 {
     setObjectName(QSL("DatabaseFactory"));
+    DatabaseProfiler::loadSettings();
     determineDriver();
 }
 
@@ -42,14 +50,14 @@ qint64 DatabaseFactory::getDatabaseDataSize() const
         qint64 result = 1;
         QSqlQuery query(database);
 
-        if (query.exec(QSL("PRAGMA page_count;"))) {
+        if (DB_EXEC_SQL(query, QSL("PRAGMA page_count;"))) {
             query.next();
             result *= query.value(0).value<qint64>();
         } else {
             return 0;
         }
 
-        if (query.exec(QSL("PRAGMA page_size;"))) {
+        if (DB_EXEC_SQL(query, QSL("PRAGMA page_size;"))) {
             query.next();
             result *= query.value(0).value<qint64>();
         } else {
@@ -68,7 +76,7 @@ qint64 DatabaseFactory::getDatabaseDataSize() const
                       "GROUP BY table_schema;");
         query.bindValue(QSL(":db"), database.databaseName());
 
-        if (query.exec() && query.next()) {
+        if (DB_EXEC(query) && query.next()) {
             return query.value(0).value<qint64>();
         } else {
             return 0;
@@ -196,6 +204,10 @@ void DatabaseFactory::sqliteAssemblyDatabaseFilePath()
 
 QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase()
 {
+    if (QSqlDatabase::contains()) {
+        removeConnection(QLatin1String(QSqlDatabase::defaultConnection));
+    }
+
     QSqlDatabase database = QSqlDatabase::addDatabase(APP_DB_SQLITE_DRIVER);
 
     database.setConnectOptions(QSL("QSQLITE_OPEN_URI;QSQLITE_ENABLE_SHARED_CACHE"));
@@ -208,16 +220,16 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase()
         QSqlQuery query_db(database);
 
         query_db.setForwardOnly(true);
-        query_db.exec(QSL("PRAGMA encoding = \"UTF-8\""));
-        query_db.exec(QSL("PRAGMA synchronous = OFF"));
-        query_db.exec(QSL("PRAGMA journal_mode = MEMORY"));
-        query_db.exec(QSL("PRAGMA page_size = 4096"));
-        query_db.exec(QSL("PRAGMA cache_size = 16384"));
-        query_db.exec(QSL("PRAGMA count_changes = OFF"));
-        query_db.exec(QSL("PRAGMA temp_store = MEMORY"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA encoding = \"UTF-8\""));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA synchronous = OFF"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA journal_mode = MEMORY"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA page_size = 4096"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA cache_size = 16384"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA count_changes = OFF"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA temp_store = MEMORY"));
 
         // Sample query which checks for existence of tables.
-        query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"));
+        DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"));
 
         if (query_db.lastError().isValid()) {
             qWarningNN << LOGSEC_DB <<
@@ -241,7 +253,7 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase()
             database.transaction();
 
             for (const QString &statement : statements) {
-                query_db.exec(statement);
+                DB_EXEC_SQL(query_db, statement);
 
                 if (query_db.lastError().isValid()) {
                     qFatal("In-memory SQLite database initialization failed. Initialization script '%s' is not correct.",
@@ -264,12 +276,12 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase()
         QSqlQuery copy_contents(database);
 
         // Attach database.
-        copy_contents.exec(QString("ATTACH DATABASE '%1' AS 'storage';").arg(file_database.databaseName()));
+        DB_EXEC_SQL(copy_contents, QString("ATTACH DATABASE '%1' AS 'storage';").arg(file_database.databaseName()));
 
         // Copy all stuff.
         QStringList tables;
 
-        if (copy_contents.exec(QSL("SELECT name FROM storage.sqlite_master WHERE type='table';"))) {
+        if (DB_EXEC_SQL(copy_contents, QSL("SELECT name FROM storage.sqlite_master WHERE type='table';"))) {
             while (copy_contents.next()) {
                 tables.append(copy_contents.value(0).toString());
             }
@@ -278,15 +290,31 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase()
         }
 
         for (const QString &table : tables) {
-            copy_contents.exec(QString("INSERT INTO main.%1 SELECT * FROM storage.%1;").arg(table));
+            if (table == QL1S("FeedCounters") || table.startsWith(QL1S("MessagesFts"))) {
+                // Counters and full-text index are rebuilt by triggers while messages are copied.
+                continue;
+            }
+
+            DB_EXEC_SQL(copy_contents, QString("INSERT INTO main.%1 SELECT * FROM storage.%1;").arg(table));
         }
 
+        // Messages are copied before their bodies, so triggers index them without
+        // compressed contents, which must be decompressed and indexed now.
+        DatabaseQueries::changeFulltextEntries(database, DatabaseQueries::compressedContentsCondition(),
+                                               QMap<QString, QVariant>(),
+                                               DatabaseQueries::FulltextEntry::Headers,
+                                               DatabaseQueries::FulltextEntry::Whole);
+
         qDebugNN << LOGSEC_DB << "Copying data from file-based database into working in-memory database.";
 
         // Detach database and finish.
-        copy_contents.exec(QSL("DETACH 'storage'"));
+        DB_EXEC_SQL(copy_contents, QSL("DETACH 'storage'"));
         copy_contents.finish();
         query_db.finish();
+
+        // From now on, remember what is changed so that it can be saved.
+        sqliteTrackMemoryDatabaseChanges(database, tables);
+        sqliteAttachArchiveDatabase(database);
     }
 
     // Everything is initialized now.
@@ -313,9 +341,14 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
         }
     }
 
-    // Folders are created. Create new QSQLDatabase object.
+    // Folders are created. Create new QSQLDatabase object, previous
+    // connection with the same name is replaced.
     QSqlDatabase database;
 
+    if (QSqlDatabase::contains(connection_name)) {
+        removeConnection(connection_name);
+    }
+
     database = QSqlDatabase::addDatabase(APP_DB_SQLITE_DRIVER, connection_name);
     database.setDatabaseName(db_file.fileName());
 
@@ -324,18 +357,22 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
                qPrintable(database.lastError().text()));
     } else {
         QSqlQuery query_db(database);
+        bool rebuild_fulltext_index = false;
 
         query_db.setForwardOnly(true);
-        query_db.exec(QSL("PRAGMA encoding = \"UTF-8\""));
-        query_db.exec(QSL("PRAGMA synchronous = OFF"));
-        query_db.exec(QSL("PRAGMA journal_mode = MEMORY"));
-        query_db.exec(QSL("PRAGMA page_size = 4096"));
-        query_db.exec(QSL("PRAGMA cache_size = 16384"));
-        query_db.exec(QSL("PRAGMA count_changes = OFF"));
-        query_db.exec(QSL("PRAGMA temp_store = MEMORY"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA encoding = \"UTF-8\""));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA synchronous = OFF"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA journal_mode = MEMORY"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA page_size = 4096"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA cache_size = 16384"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA count_changes = OFF"));
+        DB_EXEC_SQL(query_db, QSL("PRAGMA temp_store = MEMORY"));
+
+        // Only applies to new database file, existing files are converted below.
+        DB_EXEC_SQL(query_db, QSL("PRAGMA auto_vacuum = INCREMENTAL"));
 
         // Sample query which checks for existence of tables.
-        if (!query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
+        if (!DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
             qWarningNN << LOGSEC_DB <<
                        "Error occurred. File-based SQLite database is not initialized. Initializing now.";
             QFile file_init(APP_SQL_PATH + QDir::separator() + APP_DB_SQLITE_INIT);
@@ -357,7 +394,7 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
             database.transaction();
 
             for (const QString &statement : statements) {
-                query_db.exec(statement);
+                DB_EXEC_SQL(query_db, statement);
 
                 if (query_db.lastError().isValid()) {
                     qFatal("File-based SQLite database initialization failed. Initialization script '%s' is not correct.",
@@ -382,6 +419,10 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
                              << "' to '"
                              << APP_DB_SCHEMA_VERSION
                              << "' successully or it is already up to date.";
+
+                    // Older schemas indexed compressed contents as empty, which
+                    // can not be fixed by update scripts.
+                    rebuild_fulltext_index = installed_db_schema.toInt() < 24;
                 } else {
                     qFatal("Database schema was not updated from '%s' to '%s' successully.",
                            qPrintable(installed_db_schema),
@@ -389,6 +430,22 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
                 }
             }
 
+            // Database files created without incremental auto-vacuum must be rebuilt once,
+            // then their unused pages can be freed in background without full "VACUUM".
+            if (DB_EXEC_SQL(query_db, QSL("PRAGMA auto_vacuum")) && query_db.next() && query_db.value(0).toInt() != 2) {
+                query_db.finish();
+                qDebugNN << LOGSEC_DB << "Converting SQLite database to incremental auto-vacuum.";
+
+                if (!DB_EXEC_SQL(query_db, QSL("VACUUM"))) {
+                    qWarningNN << LOGSEC_DB
+                               << "Conversion to incremental auto-vacuum failed: '"
+                               << query_db.lastError().text()
+                               << "'.";
+                }
+            }
+
+            query_db.finish();
+
             qDebugNN << LOGSEC_DB
                      << "File-based SQLite database connection '"
                      << connection_name
@@ -400,6 +457,19 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
                      << installed_db_schema
                      << "'.";
         }
+
+        sqliteAttachArchiveDatabase(database);
+
+        if (rebuild_fulltext_index) {
+            database.transaction();
+
+            if (DatabaseQueries::rebuildFulltextIndex(database) &&
+                    (!m_sqliteArchiveInitialized || DatabaseQueries::rebuildFulltextIndex(database, QSL("archive.")))) {
+                database.commit();
+            } else {
+                database.rollback();
+            }
+        }
     }
 
     // Everything is initialized now.
@@ -412,6 +482,34 @@ QString DatabaseFactory::sqliteDatabaseFilePath() const
     return m_sqliteDatabaseFilePath + QDir::separator() + APP_DB_SQLITE_FILE;
 }
 
+QString DatabaseFactory::sqliteArchiveFilePath() const
+{
+    return m_sqliteDatabaseFilePath + QDir::separator() + APP_DB_SQLITE_ARCHIVE_FILE;
+}
+
+void DatabaseFactory::sqliteAttachArchiveDatabase(const QSqlDatabase &database)
+{
+    if (!m_archiveAvailable) {
+        return;
+    }
+
+    QSqlQuery query_db(database);
+
+    query_db.setForwardOnly(true);
+
+    if (!DB_EXEC_SQL(query_db, QSL("ATTACH DATABASE '%1' AS 'archive';").arg(sqliteArchiveFilePath()))) {
+        qWarningNN << LOGSEC_DB
+                   << "Archive database was not attached: '"
+                   << query_db.lastError().text()
+                   << "'.";
+        return;
+    }
+
+    if (!m_sqliteArchiveInitialized) {
+        m_sqliteArchiveInitialized = initializeArchive(database, QSL(APP_DB_SQLITE_ARCHIVE));
+    }
+}
+
 bool DatabaseFactory::sqliteUpdateDatabaseSchema(const QSqlDatabase &database,
         const QString &source_db_schema_version)
 {
@@ -566,9 +664,62 @@ QString DatabaseFactory::humanDriverName(const QString &driver_code) const
 void DatabaseFactory::removeConnection(const QString &connection_name)
 {
     qDebugNN << LOGSEC_DB << "Removing database connection '" << connection_name << "'.";
+
+    {
+        // Cached statements must be destroyed before their connection.
+        QMutexLocker locker(&m_preparedQueriesMutex);
+
+        m_preparedQueries.remove(connection_name);
+    }
+
     QSqlDatabase::removeDatabase(connection_name);
 }
 
+QSqlQuery DatabaseFactory::preparedQuery(const QSqlDatabase &db, const QString &statement_id,
+        const QString &sql, bool *ok)
+{
+    QMutexLocker locker(&m_preparedQueriesMutex);
+    QHash<QString, QSqlQuery> &queries = m_preparedQueries[db.connectionName()];
+
+    if (queries.contains(statement_id)) {
+        QSqlQuery query = queries.value(statement_id);
+
+        // Reset possible leftovers of previous execution.
+        query.finish();
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+
+        return query;
+    }
+
+    QSqlQuery query(db);
+
+    query.setForwardOnly(true);
+
+    if (query.prepare(sql)) {
+        queries.insert(statement_id, query);
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Preparation of cached statement '"
+                   << statement_id
+                   << "' failed: '"
+                   << query.lastError().text()
+                   << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    return query;
+}
+
 QString DatabaseFactory::obtainBeginTransactionSql() const
 {
     if (m_activeDatabaseDriver == UsedDriver::SQLITE
@@ -579,6 +730,11 @@ QString DatabaseFactory::obtainBeginTransactionSql() const
     }
 }
 
+DatabaseWriter *DatabaseFactory::writer() const
+{
+    return m_writer;
+}
+
 void DatabaseFactory::sqliteSaveMemoryDatabase()
 {
     qDebugNN << LOGSEC_DB << "Saving in-memory working database back to persistent file-based storage.";
@@ -588,22 +744,62 @@ void DatabaseFactory::sqliteSaveMemoryDatabase()
     QSqlQuery copy_contents(database);
 
     // Attach database.
-    copy_contents.exec(QString(QSL("ATTACH DATABASE '%1' AS 'storage';")).arg(
+    DB_EXEC_SQL(copy_contents, QString(QSL("ATTACH DATABASE '%1' AS 'storage';")).arg(
                            file_database.databaseName()));
 
-    // Copy all stuff.
+    // Copy changed messages. Their old versions are removed first, storage
+    // then keeps counters and full-text index in sync by its own triggers,
+    // except for index entries of compressed contents, which are changed here.
+    database.transaction();
+
+    const QString compressed_changed = QSL("Messages.id IN (SELECT id FROM main.ChangedMessages) AND %1")
+                                       .arg(DatabaseQueries::compressedContentsCondition());
+    const QStringList message_statements = {
+        QSL("DELETE FROM storage.Messages WHERE id IN (SELECT id FROM main.ChangedMessages);"),
+        QSL("DELETE FROM storage.MessageBodies WHERE message_id IN (SELECT id FROM main.ChangedMessages);"),
+        QSL("INSERT INTO storage.Messages SELECT * FROM main.Messages "
+            "WHERE id IN (SELECT id FROM main.ChangedMessages);"),
+        QSL("INSERT INTO storage.MessageBodies SELECT * FROM main.MessageBodies "
+            "WHERE message_id IN (SELECT id FROM main.ChangedMessages);")
+    };
+
+    DatabaseQueries::changeFulltextEntries(database, compressed_changed, QMap<QString, QVariant>(),
+                                           DatabaseQueries::FulltextEntry::Whole,
+                                           DatabaseQueries::FulltextEntry::None,
+                                           QSL("storage."));
+
+    for (const QString &statement : message_statements) {
+        if (!DB_EXEC_SQL(copy_contents, statement)) {
+            qCriticalNN << LOGSEC_DB
+                        << "Failed to save changed messages, error: '"
+                        << copy_contents.lastError().text()
+                        << "'.";
+        }
+    }
+
+    // Messages were copied before their bodies, so they are indexed without compressed contents.
+    DatabaseQueries::changeFulltextEntries(database, compressed_changed, QMap<QString, QVariant>(),
+                                           DatabaseQueries::FulltextEntry::Headers,
+                                           DatabaseQueries::FulltextEntry::Whole,
+                                           QSL("storage."));
+    DB_EXEC_SQL(copy_contents, QSL("DELETE FROM main.ChangedMessages;"));
+
+    // Other tables are small, changed ones are copied whole.
     QStringList tables;
 
-    if (copy_contents.exec(QSL("SELECT name FROM storage.sqlite_master WHERE type='table';"))) {
+    if (DB_EXEC_SQL(copy_contents, QSL("SELECT name FROM main.ChangedTables;"))) {
         while (copy_contents.next()) {
             tables.append(copy_contents.value(0).toString());
         }
     } else {
-        qFatal("Cannot obtain list of table names from file-base SQLite database.");
+        qCriticalNN << LOGSEC_DB
+                    << "Cannot obtain list of changed tables, error: '"
+                    << copy_contents.lastError().text()
+                    << "'.";
     }
 
     for (const QString &table : tables) {
-        if (copy_contents.exec(QString(QSL("DELETE FROM storage.%1;")).arg(table))) {
+        if (DB_EXEC_SQL(copy_contents, QString(QSL("DELETE FROM storage.%1;")).arg(table))) {
             qDebugNN << LOGSEC_DB << "Cleaning old data from 'storage." << table << "'.";
         } else {
             qCriticalNN << LOGSEC_DB << "Failed to clean old data from 'storage."
@@ -611,7 +807,7 @@ void DatabaseFactory::sqliteSaveMemoryDatabase()
                         << copy_contents.lastError().text() << "'.";
         }
 
-        if (copy_contents.exec(QString(QSL("INSERT INTO storage.%1 SELECT * FROM main.%1;")).arg(table))) {
+        if (DB_EXEC_SQL(copy_contents, QString(QSL("INSERT INTO storage.%1 SELECT * FROM main.%1;")).arg(table))) {
             qDebugNN << LOGSEC_DB << "Copying new data into 'main."
                      << table << "'.";
         } else {
@@ -624,8 +820,19 @@ void DatabaseFactory::sqliteSaveMemoryDatabase()
         }
     }
 
+    DB_EXEC_SQL(copy_contents, QSL("DELETE FROM main.ChangedTables;"));
+    copy_contents.finish();
+
+    if (!database.commit()) {
+        qCriticalNN << LOGSEC_DB
+                    << "Failed to commit saved data, error: '"
+                    << database.lastError().text()
+                    << "'.";
+        database.rollback();
+    }
+
     // Detach database and finish.
-    if (copy_contents.exec(QSL("DETACH 'storage'"))) {
+    if (DB_EXEC_SQL(copy_contents, QSL("DETACH 'storage'"))) {
         qDebugNN << LOGSEC_DB << "Detaching persistent SQLite file.";
     } else {
         qCriticalNN << LOGSEC_DB
@@ -637,6 +844,45 @@ void DatabaseFactory::sqliteSaveMemoryDatabase()
     copy_contents.finish();
 }
 
+void DatabaseFactory::sqliteTrackMemoryDatabaseChanges(const QSqlDatabase &database, const QStringList &tables)
+{
+    QSqlQuery query(database);
+    QStringList statements = {
+        QSL("CREATE TABLE IF NOT EXISTS ChangedMessages (id INTEGER PRIMARY KEY);"),
+        QSL("CREATE TABLE IF NOT EXISTS ChangedTables (name TEXT PRIMARY KEY);")
+    };
+
+    // Messages are tracked row by row, because they are too many
+    // to be copied whole on each save.
+    for (const QString &event : { QSL("INSERT"), QSL("UPDATE"), QSL("DELETE") }) {
+        const QString row = event == QL1S("DELETE") ? QSL("OLD") : QSL("NEW");
+
+        statements << QSL("CREATE TRIGGER IF NOT EXISTS TrackMessages%1 AFTER %1 ON Messages "
+                          "BEGIN INSERT OR IGNORE INTO ChangedMessages VALUES (%2.id); END;").arg(event, row)
+                   << QSL("CREATE TRIGGER IF NOT EXISTS TrackMessageBodies%1 AFTER %1 ON MessageBodies "
+                          "BEGIN INSERT OR IGNORE INTO ChangedMessages VALUES (%2.message_id); END;").arg(event, row);
+
+        for (const QString &table : tables) {
+            if (table == QL1S("Messages") || table == QL1S("MessageBodies") ||
+                    table == QL1S("FeedCounters") || table.startsWith(QL1S("MessagesFts"))) {
+                continue;
+            }
+
+            statements << QSL("CREATE TRIGGER IF NOT EXISTS Track%1%2 AFTER %2 ON %1 "
+                              "BEGIN INSERT OR IGNORE INTO ChangedTables VALUES ('%1'); END;").arg(table, event);
+        }
+    }
+
+    query.setForwardOnly(true);
+
+    for (const QString &statement : statements) {
+        if (!DB_EXEC_SQL(query, statement)) {
+            qFatal("Cannot track changes of in-memory SQLite database: '%s'.",
+                   qPrintable(query.lastError().text()));
+        }
+    }
+}
+
 void DatabaseFactory::determineDriver()
 {
     const QString db_driver = qApp->settings()->value(GROUP(Database),
@@ -644,7 +890,9 @@ void DatabaseFactory::determineDriver()
 
     if (db_driver == APP_DB_MYSQL_DRIVER && QSqlDatabase::isDriverAvailable(APP_DB_SQLITE_DRIVER)) {
         // User wants to use MySQL and MySQL is actually available. Use it.
+        // Archive availability is checked when database is initialized.
         m_activeDatabaseDriver = UsedDriver::MYSQL;
+        m_archiveAvailable = false;
         qDebugNN << LOGSEC_DB << "Working database source was as MySQL database.";
     } else {
         // User wants to use SQLite, which is always available. Check if file-based
@@ -660,6 +908,9 @@ void DatabaseFactory::determineDriver()
         }
 
         sqliteAssemblyDatabaseFilePath();
+        m_archiveAvailable = qApp->settings()->value(GROUP(Database),
+                                                     SETTING(Database::ArchiveAfterDays)).toInt() > 0 ||
+                             QFile::exists(sqliteArchiveFilePath());
     }
 }
 
@@ -668,6 +919,47 @@ DatabaseFactory::UsedDriver DatabaseFactory::activeDatabaseDriver() const
     return m_activeDatabaseDriver;
 }
 
+bool DatabaseFactory::archiveAvailable() const
+{
+    return m_archiveAvailable;
+}
+
+bool DatabaseFactory::initializeArchive(const QSqlDatabase &database, const QString &script_file)
+{
+    QFile file_archive(APP_SQL_PATH + QDir::separator() + script_file);
+
+    if (!file_archive.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCriticalNN << LOGSEC_DB
+                    << "Archive initialization file '"
+                    << script_file
+                    << "' was not found.";
+        return false;
+    }
+
+    const QStringList statements = QString(file_archive.readAll()).split(APP_DB_COMMENT_SPLIT,
+#if QT_VERSION >= 0x050F00 // Qt >= 5.15.0
+                                   Qt::SplitBehaviorFlags::SkipEmptyParts);
+#else
+                                   QString::SkipEmptyParts);
+#endif
+    QSqlQuery query_db(database);
+
+    query_db.setForwardOnly(true);
+
+    for (const QString &statement : statements) {
+        if (!DB_EXEC_SQL(query_db, statement)) {
+            qCriticalNN << LOGSEC_DB
+                        << "Archive initialization failed: '"
+                        << query_db.lastError().text()
+                        << "'.";
+            return false;
+        }
+    }
+
+    qDebugNN << LOGSEC_DB << "Archive of old messages is ready.";
+    return true;
+}
+
 QSqlDatabase DatabaseFactory::mysqlConnection(const QString &connection_name)
 {
     if (!m_mysqlDatabaseInitialized) {
@@ -718,6 +1010,11 @@ QSqlDatabase DatabaseFactory::mysqlConnection(const QString &connection_name)
 
 QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_name)
 {
+    // Previous connection with the same name is replaced.
+    if (QSqlDatabase::contains(connection_name)) {
+        removeConnection(connection_name);
+    }
+
     // Folders are created. Create new QSQLDatabase object.
     QSqlDatabase database = QSqlDatabase::addDatabase(APP_DB_MYSQL_DRIVER, connection_name);
     const QString database_name = qApp->settings()->value(GROUP(Database),
@@ -750,8 +1047,8 @@ QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_
 
         query_db.setForwardOnly(true);
 
-        if (!query_db.exec(QString("USE %1").arg(database_name))
-                || !query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
+        if (!DB_EXEC_SQL(query_db, QString("USE %1").arg(database_name))
+                || !DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
             // If no "rssguard" database exists or schema version is wrong, then initialize it.
             qWarningNN << LOGSEC_DB << "Error occurred. MySQL database is not initialized. Initializing now.";
             QFile file_init(APP_SQL_PATH + QDir::separator() + APP_DB_MYSQL_INIT);
@@ -774,7 +1071,7 @@ QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_
 
             for (QString statement : statements) {
                 // Assign real database name and run the query.
-                query_db.exec(statement.replace(APP_DB_NAME_PLACEHOLDER, database_name));
+                DB_EXEC_SQL(query_db, statement.replace(APP_DB_NAME_PLACEHOLDER, database_name));
 
                 if (query_db.lastError().isValid()) {
                     qFatal("MySQL database initialization failed. Initialization script '%s' is not correct. Error : '%s'.",
@@ -806,6 +1103,7 @@ QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_
         }
 
         query_db.finish();
+        mysqlInitializeArchive(database);
     }
 
     // Everything is initialized now.
@@ -818,8 +1116,56 @@ bool DatabaseFactory::mysqlVacuumDatabase()
     QSqlDatabase database = mysqlConnection(objectName());
     QSqlQuery query_vacuum(database);
 
-    return query_vacuum.exec(QSL("OPTIMIZE TABLE Feeds;"))
-           && query_vacuum.exec(QSL("OPTIMIZE TABLE Messages;"));
+    return DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE Feeds;"))
+           && DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE Messages;"))
+           && DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE MessageBodies;"))
+           && (!m_archiveAvailable || DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE ArchivedMessages, ArchivedMessageBodies;")));
+}
+
+void DatabaseFactory::mysqlInitializeArchive(const QSqlDatabase &database)
+{
+    if (qApp->settings()->value(GROUP(Database), SETTING(Database::ArchiveAfterDays)).toInt() > 0) {
+        initializeArchive(database, QSL(APP_DB_MYSQL_ARCHIVE));
+    }
+
+    QSqlQuery query_db(database);
+
+    query_db.setForwardOnly(true);
+    m_archiveAvailable = DB_EXEC_SQL(query_db, QSL("SHOW TABLES LIKE 'ArchivedMessages';")) && query_db.next();
+}
+
+qint64 DatabaseFactory::mysqlIncrementalVacuumDatabase(const QString &connection_name)
+{
+    QSqlDatabase database = mysqlConnection(connection_name);
+    QSqlQuery query_vacuum(database);
+
+    query_vacuum.setForwardOnly(true);
+    query_vacuum.prepare(QSL("SELECT table_name, data_free FROM information_schema.tables "
+                             "WHERE table_schema = :db AND data_free >= :min_free AND data_free * 10 >= data_length "
+                             "ORDER BY data_free DESC LIMIT 1;"));
+    query_vacuum.bindValue(QSL(":db"), database.databaseName());
+    query_vacuum.bindValue(QSL(":min_free"), APP_DB_VACUUM_MYSQL_MIN_FREE);
+
+    if (!DB_EXEC(query_vacuum) || !query_vacuum.next()) {
+        return 0;
+    }
+
+    const QString table = query_vacuum.value(0).toString();
+    const qint64 data_free = query_vacuum.value(1).value<qint64>();
+
+    query_vacuum.finish();
+
+    if (DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE %1;").arg(table))) {
+        qDebugNN << LOGSEC_DB
+                 << "Table '" << table << "' was optimized, about "
+                 << data_free << " bytes were reclaimed.";
+        return data_free;
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Table '" << table << "' was not optimized: '"
+                   << query_vacuum.lastError().text() << "'.";
+        return 0;
+    }
 }
 
 QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name,
@@ -851,7 +1197,9 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name,
                 database.setDatabaseName(QSL("file::memory:"));
             }
 
-            if (!database.isOpen() && !database.open()) {
+            const bool was_open = database.isOpen();
+
+            if (!was_open && !database.open()) {
                 qFatal("In-memory SQLite database was NOT opened. Delivered error message: '%s'.",
                        qPrintable(database.lastError().text()));
             } else {
@@ -859,6 +1207,10 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name,
                          << "In-memory SQLite database connection '"
                          << connection_name
                          << "' seems to be established.";
+
+                if (!was_open) {
+                    sqliteAttachArchiveDatabase(database);
+                }
             }
 
             return database;
@@ -891,7 +1243,9 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name,
                 database.setDatabaseName(db_file.fileName());
             }
 
-            if (!database.isOpen() && !database.open()) {
+            const bool was_open = database.isOpen();
+
+            if (!was_open && !database.open()) {
                 qFatal("File-based SQLite database was NOT opened. Delivered error message: '%s'.",
                        qPrintable(database.lastError().text()));
             } else {
@@ -901,6 +1255,10 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name,
                          << "' to file '"
                          << QDir::toNativeSeparators(database.databaseName())
                          << "' seems to be established.";
+
+                if (!was_open) {
+                    sqliteAttachArchiveDatabase(database);
+                }
             }
 
             return database;
@@ -923,11 +1281,75 @@ bool DatabaseFactory::sqliteVacuumDatabase()
 
     QSqlQuery query_vacuum(database);
 
-    return query_vacuum.exec(QSL("VACUUM"));
+    return DB_EXEC_SQL(query_vacuum, QSL("VACUUM"))
+           && (!m_archiveAvailable || DB_EXEC_SQL(query_vacuum, QSL("VACUUM archive")));
+}
+
+qint64 DatabaseFactory::sqliteIncrementalVacuumDatabase(const QString &connection_name, int max_pages)
+{
+    if (m_activeDatabaseDriver != UsedDriver::SQLITE) {
+        // In-memory database does not have any file to shrink.
+        return 0;
+    }
+
+    QSqlDatabase database = sqliteConnection(connection_name, DesiredType::StrictlyFileBased);
+    QSqlQuery query_vacuum(database);
+    qint64 page_size = 0;
+    qint64 free_pages = 0;
+
+    query_vacuum.setForwardOnly(true);
+
+    if (DB_EXEC_SQL(query_vacuum, QSL("PRAGMA page_size")) && query_vacuum.next()) {
+        page_size = query_vacuum.value(0).value<qint64>();
+    }
+
+    if (DB_EXEC_SQL(query_vacuum, QSL("PRAGMA freelist_count")) && query_vacuum.next()) {
+        free_pages = query_vacuum.value(0).value<qint64>();
+    }
+
+    query_vacuum.finish();
+
+    if (free_pages <= 0) {
+        return 0;
+    }
+
+    // SQLite frees one page per each step of the statement, but Qt steps
+    // statements without result columns only once, so run it repeatedly.
+    query_vacuum.prepare(QSL("PRAGMA incremental_vacuum"));
+    database.transaction();
+
+    for (qint64 i = 0; i < qMin(free_pages, qint64(max_pages)); i++) {
+        if (!DB_EXEC(query_vacuum)) {
+            qWarningNN << LOGSEC_DB
+                       << "Incremental vacuum failed: '"
+                       << query_vacuum.lastError().text() << "'.";
+            break;
+        }
+    }
+
+    query_vacuum.finish();
+    database.commit();
+
+    qint64 reclaimed_pages = free_pages;
+
+    if (DB_EXEC_SQL(query_vacuum, QSL("PRAGMA freelist_count")) && query_vacuum.next()) {
+        reclaimed_pages = free_pages - query_vacuum.value(0).value<qint64>();
+    }
+
+    query_vacuum.finish();
+
+    qDebugNN << LOGSEC_DB
+             << "Incremental vacuum reclaimed " << reclaimed_pages
+             << " of " << free_pages << " unused pages.";
+
+    return reclaimed_pages * page_size;
 }
 
 void DatabaseFactory::saveDatabase()
 {
+    // Pending writes must be in database before it is saved.
+    m_writer->flush();
+
     switch (m_activeDatabaseDriver) {
         case UsedDriver::SQLITE_MEMORY:
             sqliteSaveMemoryDatabase();
@@ -938,6 +1360,21 @@ void DatabaseFactory::saveDatabase()
     }
 }
 
+qint64 DatabaseFactory::incrementalVacuumDatabase(const QString &connection_name)
+{
+    switch (m_activeDatabaseDriver) {
+        case UsedDriver::SQLITE_MEMORY:
+        case UsedDriver::SQLITE:
+            return sqliteIncrementalVacuumDatabase(connection_name, APP_DB_VACUUM_SQLITE_PAGES);
+
+        case UsedDriver::MYSQL:
+            return mysqlIncrementalVacuumDatabase(connection_name);
+
+        default:
+            return 0;
+    }
+}
+
 bool DatabaseFactory::vacuumDatabase()
 {
     switch (m_activeDatabaseDriver) {
@@ -4,7 +4,13 @@
 #define DATABASEFACTORY_H
 
 #include <QObject>
+
+#include <QHash>
+#include <QMutex>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+
+class DatabaseWriter;
 
 class DatabaseFactory : public QObject
 {
@@ -63,10 +69,23 @@ public:
     QString humanDriverName(const QString &driver_code) const;
 
     // Removes connection.
+    // NOTE: All prepared statements cached for this connection are dropped too.
     void removeConnection(const QString &connection_name = QString());
 
+    // Returns query prepared with given SQL for given connection. Query is
+    // prepared only once per connection and then reused for all subsequent
+    // calls with the same statement ID, so callers only rebind values.
+    // NOTE: Returned query shares its prepared statement with the cache,
+    // it is "finished" and ready to be bound and executed.
+    QSqlQuery preparedQuery(const QSqlDatabase &db, const QString &statement_id,
+                            const QString &sql, bool *ok = nullptr);
+
     QString obtainBeginTransactionSql() const;
 
+    // Returns service which performs all writes which do not
+    // need their results immediately in its own thread.
+    DatabaseWriter *writer() const;
+
     // Performs any needed database-related operation to be done
     // to gracefully exit the application.
     void saveDatabase();
@@ -74,9 +93,22 @@ public:
     // Performs cleanup of the database.
     bool vacuumDatabase();
 
+    // Performs one small step of database cleanup which can run in background,
+    // returns count of reclaimed bytes.
+    // NOTE: SQLite frees limited count of unused pages, MySQL optimizes
+    // single table with most unused space.
+    qint64 incrementalVacuumDatabase(const QString &connection_name);
+
     // Returns identification of currently active database driver.
     UsedDriver activeDatabaseDriver() const;
 
+    // Returns true if archive of old messages is available. SQLite keeps
+    // archive in separate file which is attached to each connection as "archive",
+    // MySQL keeps it in "Archived" tables of working database.
+    // NOTE: Archive is created once archiving is enabled and it stays
+    // available even if archiving is disabled later.
+    bool archiveAvailable() const;
+
     // Copies selected backup database (file) to active database path.
     bool initiateRestoration(const QString &database_backup_file_path);
 
@@ -87,6 +119,7 @@ public:
     // SQLITE stuff.
     //
     QString sqliteDatabaseFilePath() const;
+    QString sqliteArchiveFilePath() const;
 
     //
     // MySQL stuff.
@@ -114,6 +147,17 @@ private:
     // Holds the type of currently activated database backend.
     UsedDriver m_activeDatabaseDriver;
 
+    // Creates archive tables with given script.
+    bool initializeArchive(const QSqlDatabase &database, const QString &script_file);
+
+    bool m_archiveAvailable;
+
+    // Prepared statements, grouped by connection name and then by statement ID.
+    QHash<QString, QHash<QString, QSqlQuery>> m_preparedQueries;
+    QMutex m_preparedQueriesMutex;
+
+    DatabaseWriter *m_writer;
+
     //
     // MYSQL stuff.
     //
@@ -131,6 +175,12 @@ private:
     // Runs "VACUUM" on the database.
     bool mysqlVacuumDatabase();
 
+    // Runs "OPTIMIZE TABLE" on table with most unused space.
+    qint64 mysqlIncrementalVacuumDatabase(const QString &connection_name);
+
+    // Creates archive tables if archiving is enabled.
+    void mysqlInitializeArchive(const QSqlDatabase &database);
+
     // True if MySQL database is fully initialized for use,
     // otherwise false.
     bool m_mysqlDatabaseInitialized;
@@ -144,13 +194,25 @@ private:
     // Runs "VACUUM" on the database.
     bool sqliteVacuumDatabase();
 
+    // Runs "PRAGMA incremental_vacuum" on the database.
+    qint64 sqliteIncrementalVacuumDatabase(const QString &connection_name, int max_pages);
+
     // Performs saving of items from in-memory database
     // to file-based database.
+    // NOTE: Only messages and tables changed since last save are written.
     void sqliteSaveMemoryDatabase();
 
+    // Creates triggers which record which messages and tables
+    // of in-memory database were changed since last save.
+    void sqliteTrackMemoryDatabaseChanges(const QSqlDatabase &database, const QStringList &tables);
+
     // Assemblies database file path.
     void sqliteAssemblyDatabaseFilePath();
 
+    // Attaches archive database file to given connection,
+    // archive is created with first connection.
+    void sqliteAttachArchiveDatabase(const QSqlDatabase &database);
+
     // Updates database schema.
     bool sqliteUpdateDatabaseSchema(const QSqlDatabase &database,
                                     const QString &source_db_schema_version);
@@ -166,6 +228,7 @@ private:
     // Is database file initialized?
     bool m_sqliteFileBasedDatabaseInitialized;
     bool m_sqliteInMemoryDatabaseInitialized;
+    bool m_sqliteArchiveInitialized;
 };
 
 #endif // DATABASEFACTORY_H
@@ -0,0 +1,253 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#include "miscellaneous/databaseprofiler.h"
+
+#include "miscellaneous/application.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QSqlRecord>
+
+#include <atomic>
+
+namespace {
+
+std::atomic_bool s_enabled{false};
+std::atomic_int s_slowQueryThreshold{0};
+
+QMutex s_mutex;
+QMap<QString, DatabaseProfiler::Statistics> s_statistics;
+QMap<QString, QString> s_queryPlanSql;
+QMap<QString, QString> s_queryPlans;
+
+QString statementId(const char *function, int line)
+{
+    return QSL("%1:%2").arg(QL1S(function), QString::number(line));
+}
+
+}
+
+bool DatabaseProfiler::isEnabled()
+{
+    return s_enabled;
+}
+
+void DatabaseProfiler::setEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+int DatabaseProfiler::slowQueryThreshold()
+{
+    return s_slowQueryThreshold;
+}
+
+void DatabaseProfiler::setSlowQueryThreshold(int msecs)
+{
+    s_slowQueryThreshold = msecs;
+}
+
+void DatabaseProfiler::loadSettings()
+{
+    setEnabled(qApp->settings()->value(GROUP(Database), SETTING(Database::ProfileQueries)).toBool());
+    setSlowQueryThreshold(qApp->settings()->value(GROUP(Database), SETTING(Database::SlowQueryThreshold)).toInt());
+}
+
+bool DatabaseProfiler::exec(QSqlQuery &query, const char *function, int line)
+{
+    if (!s_enabled) {
+        return query.exec();
+    }
+
+    QElapsedTimer timer;
+
+    timer.start();
+
+    const bool ok = query.exec();
+    const qint64 usecs = timer.nsecsElapsed() / 1000;
+
+    record(statementId(function, line), query.lastQuery(), usecs,
+           query.isSelect() ? 0 : query.numRowsAffected(), ok);
+    return ok;
+}
+
+bool DatabaseProfiler::exec(QSqlQuery &query, const QString &sql, const char *function, int line)
+{
+    if (!s_enabled) {
+        return query.exec(sql);
+    }
+
+    QElapsedTimer timer;
+
+    timer.start();
+
+    const bool ok = query.exec(sql);
+    const qint64 usecs = timer.nsecsElapsed() / 1000;
+
+    record(statementId(function, line), sql, usecs,
+           query.isSelect() ? 0 : query.numRowsAffected(), ok);
+    return ok;
+}
+
+void DatabaseProfiler::record(const QString &statement_id, const QString &sql, qint64 usecs, int rows_affected, bool ok)
+{
+    const int threshold = s_slowQueryThreshold;
+
+    if (threshold > 0 && usecs >= threshold * 1000LL) {
+        qWarningNN << LOGSEC_DB
+                   << "Slow query '" << statement_id << "' took "
+                   << usecs / 1000 << " ms: '" << sql.simplified() << "'.";
+    }
+
+    const QVector<int> buckets = histogramBuckets();
+    int bucket = 0;
+
+    while (bucket < buckets.size() && usecs >= buckets.at(bucket) * 1000LL) {
+        bucket++;
+    }
+
+    QMutexLocker locker(&s_mutex);
+    Statistics &stats = s_statistics[statement_id];
+
+    if (stats.m_histogram.isEmpty()) {
+        stats.m_histogram.fill(0, buckets.size() + 1);
+    }
+
+    stats.m_sql = sql;
+    stats.m_calls++;
+    stats.m_totalTime += usecs;
+    stats.m_maxTime = qMax(stats.m_maxTime, usecs);
+    stats.m_rowsAffected += qMax(rows_affected, 0);
+    stats.m_histogram[bucket]++;
+
+    if (!ok) {
+        stats.m_failures++;
+    }
+}
+
+void DatabaseProfiler::explain(const QSqlDatabase &db, const QString &statement_id, const QString &sql)
+{
+    if (!s_enabled) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&s_mutex);
+
+        if (s_queryPlanSql.value(statement_id) == sql) {
+            return;
+        }
+
+        s_queryPlanSql[statement_id] = sql;
+    }
+
+    const bool is_sqlite = db.driverName() == QSL(APP_DB_SQLITE_DRIVER);
+    QSqlQuery q(db);
+    QStringList plan;
+
+    q.setForwardOnly(true);
+
+    if (q.exec((is_sqlite ? QSL("EXPLAIN QUERY PLAN ") : QSL("EXPLAIN ")) + sql)) {
+        while (q.next()) {
+            if (is_sqlite) {
+                // Last column contains human-readable description of plan step.
+                plan.append(q.value(q.record().count() - 1).toString());
+            } else {
+                const QSqlRecord record = q.record();
+                QStringList fields;
+
+                for (int i = 0; i < record.count(); i++) {
+                    fields.append(QSL("%1: %2").arg(record.fieldName(i), record.value(i).toString()));
+                }
+
+                plan.append(fields.join(QSL(", ")));
+            }
+        }
+    } else {
+        plan.append(q.lastError().text());
+    }
+
+    qDebugNN << LOGSEC_DB
+             << "Query plan of '" << statement_id << "':\n"
+             << plan.join(QL1C('\n'));
+
+    QMutexLocker locker(&s_mutex);
+
+    s_queryPlans[statement_id] = sql + QSL("\n\n") + plan.join(QL1C('\n'));
+}
+
+QMap<QString, DatabaseProfiler::Statistics> DatabaseProfiler::statistics()
+{
+    QMutexLocker locker(&s_mutex);
+
+    return s_statistics;
+}
+
+QMap<QString, QString> DatabaseProfiler::queryPlans()
+{
+    QMutexLocker locker(&s_mutex);
+
+    return s_queryPlans;
+}
+
+void DatabaseProfiler::reset()
+{
+    QMutexLocker locker(&s_mutex);
+
+    s_statistics.clear();
+    s_queryPlanSql.clear();
+    s_queryPlans.clear();
+}
+
+QVector<int> DatabaseProfiler::histogramBuckets()
+{
+    return QVector<int>() << 1 << 5 << 25 << 100 << 500;
+}
+
+QByteArray DatabaseProfiler::toJson()
+{
+    const QMap<QString, Statistics> stats = statistics();
+    const QMap<QString, QString> plans = queryPlans();
+    QJsonArray json_buckets, json_statements;
+    QJsonObject json_plans;
+
+    for (int bucket : histogramBuckets()) {
+        json_buckets.append(bucket);
+    }
+
+    for (auto i = stats.constBegin(); i != stats.constEnd(); ++i) {
+        QJsonObject json_statement;
+        QJsonArray json_histogram;
+
+        for (int calls : i.value().m_histogram) {
+            json_histogram.append(calls);
+        }
+
+        json_statement[QSL("id")] = i.key();
+        json_statement[QSL("sql")] = i.value().m_sql;
+        json_statement[QSL("calls")] = i.value().m_calls;
+        json_statement[QSL("failures")] = i.value().m_failures;
+        json_statement[QSL("total_usecs")] = double(i.value().m_totalTime);
+        json_statement[QSL("max_usecs")] = double(i.value().m_maxTime);
+        json_statement[QSL("rows_affected")] = double(i.value().m_rowsAffected);
+        json_statement[QSL("histogram")] = json_histogram;
+        json_statements.append(json_statement);
+    }
+
+    for (auto i = plans.constBegin(); i != plans.constEnd(); ++i) {
+        json_plans[i.key()] = i.value();
+    }
+
+    QJsonObject json;
+
+    json[QSL("histogram_buckets_msecs")] = json_buckets;
+    json[QSL("statements")] = json_statements;
+    json[QSL("query_plans")] = json_plans;
+
+    return QJsonDocument(json).toJson(QJsonDocument::Indented);
+}
@@ -0,0 +1,72 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#ifndef DATABASEPROFILER_H
+#define DATABASEPROFILER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVector>
+
+// Executes query, its timing is recorded under name of calling
+// function and line when profiling of queries is enabled.
+#define DB_EXEC(query) DatabaseProfiler::exec(query, __func__, __LINE__)
+#define DB_EXEC_SQL(query, sql) DatabaseProfiler::exec(query, sql, __func__, __LINE__)
+
+// Opt-in instrumentation of database queries. Collects call counts,
+// latencies and affected rows per statement, logs slow statements
+// and remembers query plans of selected statements.
+class DatabaseProfiler
+{
+public:
+    struct Statistics {
+        QString m_sql;
+        int m_calls = 0;
+        int m_failures = 0;
+
+        // Times are in microseconds.
+        qint64 m_totalTime = 0;
+        qint64 m_maxTime = 0;
+        qint64 m_rowsAffected = 0;
+
+        // Count of calls in each of latency buckets.
+        QVector<int> m_histogram;
+    };
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    // Statements running longer than this are logged, 0 disables logging.
+    static int slowQueryThreshold();
+    static void setSlowQueryThreshold(int msecs);
+
+    // Loads state of profiler from settings.
+    static void loadSettings();
+
+    // Executes prepared query.
+    static bool exec(QSqlQuery &query, const char *function, int line);
+
+    // Executes given SQL.
+    static bool exec(QSqlQuery &query, const QString &sql, const char *function, int line);
+
+    // Records single execution of statement which was not executed via "exec".
+    static void record(const QString &statement_id, const QString &sql, qint64 usecs, int rows_affected, bool ok);
+
+    // Remembers query plan of given SELECT statement.
+    // NOTE: Plan is obtained only if profiling is enabled and the statement changed.
+    static void explain(const QSqlDatabase &db, const QString &statement_id, const QString &sql);
+
+    static QMap<QString, Statistics> statistics();
+    static QMap<QString, QString> queryPlans();
+    static void reset();
+
+    // Upper limits of latency buckets in milliseconds, last bucket is unlimited.
+    static QVector<int> histogramBuckets();
+
+    // Exports all statistics and query plans.
+    static QByteArray toJson();
+};
+
+#endif // DATABASEPROFILER_H
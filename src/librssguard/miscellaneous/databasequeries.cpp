@@ -4,6 +4,8 @@
 
 #include "exceptions/applicationexception.h"
 #include "miscellaneous/application.h"
+#include "miscellaneous/databaseprofiler.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/textfactory.h"
 #include "network-web/oauth2service.h"
@@ -27,7 +29,9 @@
 #include "services/tt-rss/ttrssfeed.h"
 #include "services/tt-rss/ttrssserviceroot.h"
 
+#include <QCryptographicHash>
 #include <QSqlDriver>
+#include <QSqlField>
 #include <QUrl>
 #include <QVariant>
 
@@ -41,27 +45,36 @@ bool DatabaseQueries::markImportantMessagesReadUnread(const QSqlDatabase &db, in
               "WHERE is_important = 1 AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":read"), read == RootItem::ReadStatus::Read ? 1 : 0);
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markMessagesReadUnread(const QSqlDatabase &db, const QStringList &ids,
         RootItem::ReadStatus read)
 {
-    QSqlQuery q(db);
+    if (ids.size() == 1) {
+        // Single message is by far the most common case (user reads messages
+        // one by one), so use cached statement for it.
+        QSqlQuery q = qApp->database()->preparedQuery(db, QSL("markMessageReadUnread"),
+                      QSL("UPDATE Messages SET is_read = :read WHERE id = :id;"));
 
-    q.setForwardOnly(true);
-    return q.exec(QString(QSL("UPDATE Messages SET is_read = %2 WHERE id IN (%1);"))
-                  .arg(ids.join(QSL(", ")), read == RootItem::ReadStatus::Read ? QSL("1") : QSL("0")));
+        q.bindValue(QSL(":read"), read == RootItem::ReadStatus::Read ? 1 : 0);
+        q.bindValue(QSL(":id"), ids.first().toInt());
+        return DB_EXEC(q);
+    }
+
+    return updateMessagesInBulk(db, ids, QSL("UPDATE Messages SET is_read = %2 WHERE id IN %1;")
+                                .arg(QSL("%1"), read == RootItem::ReadStatus::Read ? QSL("1") : QSL("0")));
 }
 
 bool DatabaseQueries::markMessageImportant(const QSqlDatabase &db, int id,
         RootItem::Importance importance)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    bool prepared;
+    QSqlQuery q = qApp->database()->preparedQuery(db, QSL("markMessageImportant"),
+                  QSL("UPDATE Messages SET is_important = :important WHERE id = :id;"),
+                  &prepared);
 
-    if (!q.prepare(QSL("UPDATE Messages SET is_important = :important WHERE id = :id;"))) {
+    if (!prepared) {
         qWarningNN << LOGSEC_DB
                    << "Query preparation failed for message importance switch.";
         return false;
@@ -71,7 +84,7 @@ bool DatabaseQueries::markMessageImportant(const QSqlDatabase &db, int id,
     q.bindValue(QSL(":important"), (int) importance);
 
     // Commit changes.
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markFeedsReadUnread(const QSqlDatabase &db, const QStringList &ids,
@@ -85,7 +98,7 @@ bool DatabaseQueries::markFeedsReadUnread(const QSqlDatabase &db, const QStringL
                   ids.join(QSL(", "))));
     q.bindValue(QSL(":read"), read == RootItem::ReadStatus::Read ? 1 : 0);
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markBinReadUnread(const QSqlDatabase &db, int account_id,
@@ -98,7 +111,7 @@ bool DatabaseQueries::markBinReadUnread(const QSqlDatabase &db, int account_id,
               "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":read"), read == RootItem::ReadStatus::Read ? 1 : 0);
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markAccountReadUnread(const QSqlDatabase &db, int account_id,
@@ -111,39 +124,109 @@ bool DatabaseQueries::markAccountReadUnread(const QSqlDatabase &db, int account_
         QSL("UPDATE Messages SET is_read = :read WHERE is_pdeleted = 0 AND account_id = :account_id;"));
     q.bindValue(QSL(":account_id"), account_id);
     q.bindValue(QSL(":read"), read == RootItem::ReadStatus::Read ? 1 : 0);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::switchMessagesImportance(const QSqlDatabase &db, const QStringList &ids)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
-    return q.exec(QString(
-                      QSL("UPDATE Messages SET is_important = NOT is_important WHERE id IN (%1);")).arg(ids.join(
-                                  QSL(", "))));
+    return updateMessagesInBulk(db, ids, QSL("UPDATE Messages SET is_important = NOT is_important WHERE id IN %1;"));
 }
 
 bool DatabaseQueries::permanentlyDeleteMessages(const QSqlDatabase &db, const QStringList &ids)
+{
+    return updateMessagesInBulk(db, ids, QSL("UPDATE Messages SET is_pdeleted = 1 WHERE id IN %1;"));
+}
+
+bool DatabaseQueries::deleteOrRestoreMessagesToFromBin(const QSqlDatabase &db,
+        const QStringList &ids, bool deleted)
+{
+    return updateMessagesInBulk(db, ids, QSL("UPDATE Messages SET is_deleted = %2, is_pdeleted = 0 WHERE id IN %1;")
+                                .arg(QSL("%1"), QString::number(deleted ? 1 : 0)));
+}
+
+bool DatabaseQueries::storeMessageIds(const QSqlDatabase &db, const QString &table,
+                                      const QStringList &ids, QSqlError *error)
 {
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    return q.exec(QString(QSL("UPDATE Messages SET is_pdeleted = 1 WHERE id IN (%1);")).arg(ids.join(
-                      QSL(", "))));
+
+    bool result = DB_EXEC_SQL(q, QSL("CREATE TEMPORARY TABLE IF NOT EXISTS %1 (id INTEGER NOT NULL);").arg(table)) &&
+                  DB_EXEC_SQL(q, QSL("DELETE FROM %1;").arg(table));
+
+    if (!result && error != nullptr) {
+        *error = q.lastError();
+    }
+
+    for (int i = 0; result && i < ids.size(); i += MSG_BULK_CHUNK_SIZE) {
+        const QStringList chunk = ids.mid(i, MSG_BULK_CHUNK_SIZE);
+        const QString insert_sql = QSL("INSERT INTO %1 (id) VALUES (?)%2;")
+                                   .arg(table, QSL(", (?)").repeated(chunk.size() - 1));
+
+        // Full chunks are the same every time, so they are prepared only once.
+        QSqlQuery q_insert = chunk.size() == MSG_BULK_CHUNK_SIZE
+                             ? qApp->database()->preparedQuery(db, QSL("storeMessageIds") + table, insert_sql)
+                             : QSqlQuery(db);
+
+        if (chunk.size() != MSG_BULK_CHUNK_SIZE) {
+            q_insert.prepare(insert_sql);
+        }
+
+        for (int j = 0; j < chunk.size(); j++) {
+            q_insert.bindValue(j, chunk.at(j).toInt());
+        }
+
+        result = DB_EXEC(q_insert);
+
+        if (!result && error != nullptr) {
+            *error = q_insert.lastError();
+        }
+
+        q_insert.finish();
+    }
+
+    return result;
 }
 
-bool DatabaseQueries::deleteOrRestoreMessagesToFromBin(const QSqlDatabase &db,
-        const QStringList &ids, bool deleted)
+bool DatabaseQueries::updateMessagesInBulk(const QSqlDatabase &db, const QStringList &ids, const QString &statement)
 {
+    QSqlDatabase database = db;
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    return q.exec(QString(
-                      QSL("UPDATE Messages SET is_deleted = %2, is_pdeleted = %3 WHERE id IN (%1);")).arg(ids.join(
-                                  QSL(", ")),
-                              QString::number(deleted ? 1 : 0),
-                              QString::number(0)));
+
+    QSqlError error;
+    bool own_transaction;
+    bool result = beginTransaction(database, &own_transaction);
+
+    if (result) {
+        result = storeMessageIds(db, QSL("BulkMessageIds"), ids, &error);
+    } else {
+        error = database.lastError();
+    }
+
+    if (result) {
+        result = DB_EXEC_SQL(q, statement.arg(QSL("(SELECT id FROM BulkMessageIds)")));
+        error = q.lastError();
+    }
+
+    if (!result) {
+        qWarningNN << LOGSEC_DB
+                   << "Bulk update of " << ids.size() << " messages failed: '"
+                   << error.text() << "'.";
+    }
+
+    DB_EXEC_SQL(q, QSL("DELETE FROM BulkMessageIds;"));
+
+    if (own_transaction) {
+        if (result) {
+            result = database.commit();
+        } else {
+            database.rollback();
+        }
+    }
+
+    return result;
 }
 
 bool DatabaseQueries::restoreBin(const QSqlDatabase &db, int account_id)
@@ -154,63 +237,155 @@ bool DatabaseQueries::restoreBin(const QSqlDatabase &db, int account_id)
     q.prepare("UPDATE Messages SET is_deleted = 0 "
               "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::purgeImportantMessages(const QSqlDatabase &db)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
-    q.prepare(QSL("DELETE FROM Messages WHERE is_important = 1;"));
-    return q.exec();
+    return deleteMessages(db, QSL("is_important = 1"));
 }
 
 bool DatabaseQueries::purgeReadMessages(const QSqlDatabase &db)
 {
-    QSqlQuery q(db);
+    QMap<QString, QVariant> values;
 
-    q.setForwardOnly(true);
-    q.prepare(
-        QSL("DELETE FROM Messages WHERE is_important = :is_important AND is_deleted = :is_deleted AND is_read = :is_read;"));
-    q.bindValue(QSL(":is_read"), 1);
+    values.insert(QSL(":is_read"), 1);
 
     // Remove only messages which are NOT in recycle bin.
-    q.bindValue(QSL(":is_deleted"), 0);
+    values.insert(QSL(":is_deleted"), 0);
 
     // Remove only messages which are NOT starred.
-    q.bindValue(QSL(":is_important"), 0);
-    return q.exec();
+    values.insert(QSL(":is_important"), 0);
+    return deleteMessages(db, QSL("is_important = :is_important AND is_deleted = :is_deleted AND is_read = :is_read"),
+                          values);
 }
 
 bool DatabaseQueries::purgeOldMessages(const QSqlDatabase &db, int older_than_days)
 {
-    QSqlQuery q(db);
+    QMap<QString, QVariant> values;
     const qint64 since_epoch = QDateTime::currentDateTimeUtc().addDays(
                                    -older_than_days).toMSecsSinceEpoch();
 
-    q.setForwardOnly(true);
-    q.prepare(
-        QSL("DELETE FROM Messages WHERE is_important = :is_important AND date_created < :date_created;"));
-    q.bindValue(QSL(":date_created"), since_epoch);
+    values.insert(QSL(":date_created"), since_epoch);
 
     // Remove only messages which are NOT starred.
-    q.bindValue(QSL(":is_important"), 0);
-    return q.exec();
+    values.insert(QSL(":is_important"), 0);
+    return deleteMessages(db, QSL("is_important = :is_important AND date_created < :date_created"), values);
 }
 
 bool DatabaseQueries::purgeRecycleBin(const QSqlDatabase &db)
+{
+    QMap<QString, QVariant> values;
+
+    values.insert(QSL(":is_deleted"), 1);
+
+    // Remove only messages which are NOT starred.
+    values.insert(QSL(":is_important"), 0);
+    return deleteMessages(db, QSL("is_important = :is_important AND is_deleted = :is_deleted"), values);
+}
+
+int DatabaseQueries::compressMessageContents(QSqlDatabase db, int *last_id, int batch_size, bool *ok)
 {
     QSqlQuery q(db);
+    QList<QPair<int, QString>> batch;
 
     q.setForwardOnly(true);
-    q.prepare(
-        QSL("DELETE FROM Messages WHERE is_important = :is_important AND is_deleted = :is_deleted;"));
-    q.bindValue(QSL(":is_deleted"), 1);
+    q.prepare(QSL("SELECT message_id, contents FROM MessageBodies "
+                  "WHERE message_id > :id AND length(contents) >= :min_length "
+                  "ORDER BY message_id LIMIT :batch_size;"));
+    q.bindValue(QSL(":id"), *last_id);
+    q.bindValue(QSL(":min_length"), MSG_COMPRESSED_CONTENTS_MIN_LENGTH);
+    q.bindValue(QSL(":batch_size"), batch_size);
+
+    if (!DB_EXEC(q)) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to select messages for contents compression: '"
+                   << q.lastError().text() << "'.";
 
-    // Remove only messages which are NOT starred.
-    q.bindValue(QSL(":is_important"), 0);
-    return q.exec();
+        if (ok != nullptr) {
+            *ok = false;
+        }
+
+        return 0;
+    }
+
+    while (q.next()) {
+        batch.append(QPair<int, QString>(q.value(0).toInt(), q.value(1).toString()));
+    }
+
+    q.finish();
+
+    if (batch.isEmpty()) {
+        if (ok != nullptr) {
+            *ok = true;
+        }
+
+        return 0;
+    }
+
+    bool result = db.transaction();
+
+    q.prepare(QSL("UPDATE MessageBodies SET contents = :contents WHERE message_id = :id;"));
+
+    for (const auto &message : batch) {
+        if (Message::isCompressedContents(message.second)) {
+            continue;
+        }
+
+        const QString compressed = Message::compressContents(message.second);
+
+        if (!Message::isCompressedContents(compressed)) {
+            // Contents did not shrink, keep it as it is.
+            continue;
+        }
+
+        q.bindValue(QSL(":contents"), compressed);
+        q.bindValue(QSL(":id"), message.first);
+        result &= DB_EXEC(q);
+    }
+
+    if (result && db.commit()) {
+        *last_id = batch.last().first;
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to store compressed message contents: '"
+                   << q.lastError().text() << "'.";
+        db.rollback();
+        result = false;
+    }
+
+    if (ok != nullptr) {
+        *ok = result;
+    }
+
+    return batch.size();
+}
+
+QPair<qint64, qint64> DatabaseQueries::getMessageContentsSize(const QSqlDatabase &db, bool *ok)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+    q.prepare(QSL("SELECT "
+                  "sum(CASE WHEN contents LIKE :marker_plain THEN 0 ELSE length(contents) END), "
+                  "sum(CASE WHEN contents LIKE :marker_compressed THEN length(contents) ELSE 0 END) "
+                  "FROM MessageBodies;"));
+    q.bindValue(QSL(":marker_plain"), QL1S(MSG_COMPRESSED_CONTENTS_MARKER) + QL1C('%'));
+    q.bindValue(QSL(":marker_compressed"), QL1S(MSG_COMPRESSED_CONTENTS_MARKER) + QL1C('%'));
+
+    if (DB_EXEC(q) && q.next()) {
+        if (ok != nullptr) {
+            *ok = true;
+        }
+
+        return QPair<qint64, qint64>(q.value(0).value<qint64>(), q.value(1).value<qint64>());
+    } else {
+        if (ok != nullptr) {
+            *ok = false;
+        }
+
+        return QPair<qint64, qint64>(0, 0);
+    }
 }
 
 QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForCategory(const QSqlDatabase &db,
@@ -220,24 +395,22 @@ QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForCategory(cons
                             bool *ok)
 {
     QMap<QString, QPair<int, int>> counts;
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    QSqlQuery q;
 
     if (only_total_counts) {
-        q.prepare("SELECT feed, sum((is_read + 1) % 2), count(*) FROM Messages "
-                  "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-                  "GROUP BY feed;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForCategoryTotal"),
+                                            QSL("SELECT feed, unread_count, total_count FROM FeedCounters "
+                                                "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND account_id = :account_id;"));
     } else {
-        q.prepare("SELECT feed, sum((is_read + 1) % 2) FROM Messages "
-                  "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-                  "GROUP BY feed;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForCategoryUnread"),
+                                            QSL("SELECT feed, unread_count FROM FeedCounters "
+                                                "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND account_id = :account_id;"));
     }
 
     q.bindValue(QSL(":category"), custom_id);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             QString feed_custom_id = q.value(0).toString();
             int unread_count = q.value(1).toInt();
@@ -251,6 +424,8 @@ QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForCategory(cons
             }
         }
 
+        q.finish();
+
         if (ok != nullptr) {
             *ok = true;
         }
@@ -268,23 +443,21 @@ QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForAccount(const
                             bool only_total_counts, bool *ok)
 {
     QMap<QString, QPair<int, int>> counts;
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    QSqlQuery q;
 
     if (only_total_counts) {
-        q.prepare("SELECT feed, sum((is_read + 1) % 2), count(*) FROM Messages "
-                  "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-                  "GROUP BY feed;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForAccountTotal"),
+                                            QSL("SELECT feed, unread_count, total_count FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     } else {
-        q.prepare("SELECT feed, sum((is_read + 1) % 2) FROM Messages "
-                  "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-                  "GROUP BY feed;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForAccountUnread"),
+                                            QSL("SELECT feed, unread_count FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     }
 
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             QString feed_id = q.value(0).toString();
             int unread_count = q.value(1).toInt();
@@ -298,6 +471,8 @@ QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForAccount(const
             }
         }
 
+        q.finish();
+
         if (ok != nullptr) {
             *ok = true;
         }
@@ -313,27 +488,31 @@ QMap<QString, QPair<int, int>> DatabaseQueries::getMessageCountsForAccount(const
 int DatabaseQueries::getMessageCountsForFeed(const QSqlDatabase &db, const QString &feed_custom_id,
         int account_id, bool only_total_counts, bool *ok)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    QSqlQuery q;
 
     if (only_total_counts) {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE feed = :feed AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForFeedTotal"),
+                                            QSL("SELECT total_count FROM FeedCounters "
+                                                "WHERE feed = :feed AND account_id = :account_id;"));
     } else {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE feed = :feed AND is_deleted = 0 AND is_pdeleted = 0 AND is_read = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForFeedUnread"),
+                                            QSL("SELECT unread_count FROM FeedCounters "
+                                                "WHERE feed = :feed AND account_id = :account_id;"));
     }
 
     q.bindValue(QSL(":feed"), feed_custom_id);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec() && q.next()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
 
-        return q.value(0).toInt();
+        // Feed without any message does not have its counters row yet.
+        const int count = q.next() ? q.value(0).toInt() : 0;
+
+        q.finish();
+        return count;
     } else {
         if (ok != nullptr) {
             *ok = false;
@@ -346,26 +525,29 @@ int DatabaseQueries::getMessageCountsForFeed(const QSqlDatabase &db, const QStri
 int DatabaseQueries::getImportantMessageCounts(const QSqlDatabase &db, int account_id,
         bool only_total_counts, bool *ok)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    QSqlQuery q;
 
     if (only_total_counts) {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE is_important = 1 AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getImportantMessageCountsTotal"),
+                                            QSL("SELECT coalesce(sum(important_total_count), 0) FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     } else {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE is_read = 0 AND is_important = 1 AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getImportantMessageCountsUnread"),
+                                            QSL("SELECT coalesce(sum(important_unread_count), 0) FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     }
 
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec() && q.next()) {
+    if (DB_EXEC(q) && q.next()) {
         if (ok != nullptr) {
             *ok = true;
         }
 
-        return q.value(0).toInt();
+        const int count = q.value(0).toInt();
+
+        q.finish();
+        return count;
     } else {
         if (ok != nullptr) {
             *ok = false;
@@ -378,26 +560,29 @@ int DatabaseQueries::getImportantMessageCounts(const QSqlDatabase &db, int accou
 int DatabaseQueries::getMessageCountsForBin(const QSqlDatabase &db, int account_id,
         bool including_total_counts, bool *ok)
 {
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
+    QSqlQuery q;
 
     if (including_total_counts) {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForBinTotal"),
+                                            QSL("SELECT coalesce(sum(bin_total_count), 0) FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     } else {
-        q.prepare("SELECT count(*) FROM Messages "
-                  "WHERE is_read = 0 AND is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
+        q = qApp->database()->preparedQuery(db, QSL("getMessageCountsForBinUnread"),
+                                            QSL("SELECT coalesce(sum(bin_unread_count), 0) FROM FeedCounters "
+                                                "WHERE account_id = :account_id;"));
     }
 
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec() && q.next()) {
+    if (DB_EXEC(q) && q.next()) {
         if (ok != nullptr) {
             *ok = true;
         }
 
-        return q.value(0).toInt();
+        const int count = q.value(0).toInt();
+
+        q.finish();
+        return count;
     } else {
         if (ok != nullptr) {
             *ok = false;
@@ -407,6 +592,401 @@ int DatabaseQueries::getMessageCountsForBin(const QSqlDatabase &db, int account_
     }
 }
 
+QHash<int, QHash<QString, MessageCounts>> DatabaseQueries::getMessageCountsForAllAccounts(const QSqlDatabase &db,
+                                                                                        bool *ok)
+{
+    QHash<int, QHash<QString, MessageCounts>> counts;
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    // Counters are already maintained per (account_id, feed), so
+    // no further grouping is needed.
+    if (DB_EXEC_SQL(q, QSL("SELECT account_id, feed, unread_count, total_count, bin_unread_count, bin_total_count, "
+                           "important_unread_count, important_total_count "
+                           "FROM FeedCounters;"))) {
+        while (q.next()) {
+            MessageCounts feed_counts;
+
+            feed_counts.m_unread = q.value(2).toInt();
+            feed_counts.m_total = q.value(3).toInt();
+            feed_counts.m_binUnread = q.value(4).toInt();
+            feed_counts.m_binTotal = q.value(5).toInt();
+            feed_counts.m_importantUnread = q.value(6).toInt();
+            feed_counts.m_importantTotal = q.value(7).toInt();
+
+            counts[q.value(0).toInt()].insert(q.value(1).toString(), feed_counts);
+        }
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to load counts of messages: '"
+                   << q.lastError().text()
+                   << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    return counts;
+}
+
+qint64 DatabaseQueries::nextMessageId(const QSqlDatabase &db, bool include_archive)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    const QString sql = include_archive
+                        ? QSL("SELECT MAX(max_id) FROM "
+                              "(SELECT MAX(id) AS max_id FROM Messages UNION ALL SELECT MAX(id) AS max_id FROM %1) ids;")
+                        .arg(archivedTable(db, QSL("Messages")))
+                        : QSL("SELECT MAX(id) FROM Messages;");
+
+    if (DB_EXEC_SQL(q, sql) && q.next()) {
+        return q.value(0).toLongLong() + 1;
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to obtain ID for new message: '"
+                   << q.lastError().text()
+                   << "'.";
+        return 0;
+    }
+}
+
+QString DatabaseQueries::archivedTable(const QSqlDatabase &db, const QString &table)
+{
+    if (db.driverName() == QSL(APP_DB_MYSQL_DRIVER)) {
+        return QSL("Archived") + table;
+    } else {
+        return QSL("archive.") + table;
+    }
+}
+
+int DatabaseQueries::archiveMessages(const QSqlDatabase &db, int older_than_days, int batch_size, bool *ok)
+{
+    const QString columns = QSL("id, is_read, is_deleted, is_important, feed, title, url, author, date_created, "
+                                "is_pdeleted, account_id, custom_id, custom_hash, has_enclosures");
+    const qint64 threshold = QDateTime::currentDateTimeUtc().addDays(-older_than_days).toMSecsSinceEpoch();
+    QSqlQuery q(db);
+    int archived = 0;
+
+    q.setForwardOnly(true);
+
+    // IDs of the batch are remembered first, so that all following
+    // statements work with exactly the same messages.
+    //
+    // NOTE: New messages get IDs above IDs of archived messages, see nextMessageId().
+    bool result = DB_EXEC_SQL(q, QSL("CREATE TEMPORARY TABLE IF NOT EXISTS ArchivedMessageIds (id INTEGER NOT NULL PRIMARY KEY);")) &&
+                  DB_EXEC_SQL(q, QSL("DELETE FROM ArchivedMessageIds;")) &&
+                  q.prepare(QSL("INSERT INTO ArchivedMessageIds (id) SELECT id FROM Messages "
+                                "WHERE date_created < :threshold AND is_important = 0 AND is_deleted = 0 AND is_pdeleted = 0 "
+                                "LIMIT :batch_size;"));
+
+    if (result) {
+        q.bindValue(QSL(":threshold"), threshold);
+        q.bindValue(QSL(":batch_size"), batch_size);
+        result = DB_EXEC(q);
+        archived = result ? q.numRowsAffected() : 0;
+    }
+
+    // Bodies go first, so that archived messages are indexed with their contents.
+    // Compressed contents are not indexed by triggers, they are moved to archive index here.
+    if (result && archived > 0) {
+        const QString compressed_archived = QSL("Messages.id IN (SELECT id FROM ArchivedMessageIds) AND %1")
+                                            .arg(compressedContentsCondition());
+
+        result = DB_EXEC_SQL(q, QSL("INSERT INTO %1 (message_id, enclosures, contents) "
+                            "SELECT message_id, enclosures, contents FROM MessageBodies "
+                            "WHERE message_id IN (SELECT id FROM ArchivedMessageIds);")
+                        .arg(archivedTable(db, QSL("MessageBodies")))) &&
+                 DB_EXEC_SQL(q, QSL("INSERT INTO %1 (%2) SELECT %2 FROM Messages "
+                            "WHERE id IN (SELECT id FROM ArchivedMessageIds);")
+                        .arg(archivedTable(db, QSL("Messages")), columns)) &&
+                 changeFulltextEntries(db, compressed_archived, QMap<QString, QVariant>(),
+                                       FulltextEntry::None, FulltextEntry::Whole, QSL("archive.")) &&
+                 changeFulltextEntries(db, compressed_archived, QMap<QString, QVariant>(),
+                                       FulltextEntry::Whole, FulltextEntry::None) &&
+                 DB_EXEC_SQL(q, QSL("DELETE FROM Messages WHERE id IN (SELECT id FROM ArchivedMessageIds);"));
+    }
+
+    if (!result) {
+        qWarningNN << LOGSEC_DB
+                   << "Archiving of old messages failed: '"
+                   << q.lastError().text() << "'.";
+        archived = 0;
+    } else if (archived > 0) {
+        qDebugNN << LOGSEC_DB << "Moved " << archived << " old messages to archive.";
+    }
+
+    DB_EXEC_SQL(q, QSL("DELETE FROM ArchivedMessageIds;"));
+
+    if (ok != nullptr) {
+        *ok = result;
+    }
+
+    return archived;
+}
+
+QList<int> DatabaseQueries::searchMessages(const QSqlDatabase &db, const QString &phrase,
+                                           int account_id, const QStringList &feed_custom_ids,
+                                           int limit, int offset, bool include_archive, bool *ok)
+{
+    QList<int> ids;
+    const bool is_mysql = db.driverName() == QSL(APP_DB_MYSQL_DRIVER);
+    const QString match = is_mysql ? phrase.simplified() : ftsMatchExpression(phrase);
+
+    if (match.isEmpty()) {
+        if (ok != nullptr) {
+            *ok = true;
+        }
+
+        return ids;
+    }
+
+    // Working and archived messages are searched with the same query, only
+    // tables and names of bound values differ.
+    auto search_part = [&](const QString &messages_table, const QString &index_table, const QString &prefix) {
+        QString scope;
+        QStringList feed_placeholders;
+
+        if (account_id > 0) {
+            scope += QSL(" AND Messages.account_id = :%1account_id").arg(prefix);
+        }
+
+        for (int i = 0; i < feed_custom_ids.size(); i++) {
+            feed_placeholders.append(QSL(":%1feed%2").arg(prefix).arg(i));
+        }
+
+        if (!feed_placeholders.isEmpty()) {
+            scope += QSL(" AND Messages.feed IN (%1)").arg(feed_placeholders.join(QSL(", ")));
+        }
+
+        if (is_mysql) {
+            // Headers and bodies have separate full-text indexes, so
+            // both are matched and their scores are summed.
+            return QSL("SELECT Messages.id AS id, "
+                       "MATCH (Messages.title, Messages.author) AGAINST (:%4phrase_rank IN NATURAL LANGUAGE MODE) + "
+                       "MATCH (MessageBodies.contents) AGAINST (:%4phrase_body_rank IN NATURAL LANGUAGE MODE) AS score "
+                       "FROM %1 AS Messages "
+                       "LEFT JOIN %2 AS MessageBodies ON MessageBodies.message_id = Messages.id "
+                       "WHERE (MATCH (Messages.title, Messages.author) AGAINST (:%4phrase IN NATURAL LANGUAGE MODE) "
+                       "OR MATCH (MessageBodies.contents) AGAINST (:%4phrase_body IN NATURAL LANGUAGE MODE)) "
+                       "AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0%3")
+                   .arg(messages_table, index_table, scope, prefix);
+        } else {
+            // Matches in title weigh more than matches in author, which weigh
+            // more than matches in message contents.
+            return QSL("SELECT Messages.id AS id, bm25(MessagesFts, 10.0, 5.0, 1.0) AS score "
+                       "FROM %2 AS MessagesFts "
+                       "INNER JOIN %1 AS Messages ON Messages.id = MessagesFts.rowid "
+                       "WHERE MessagesFts MATCH :%4phrase "
+                       "AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0%3")
+                   .arg(messages_table, index_table, scope, prefix);
+        }
+    };
+    auto bind_part = [&](QSqlQuery &q, const QString &prefix) {
+        q.bindValue(QSL(":%1phrase").arg(prefix), match);
+
+        if (is_mysql) {
+            q.bindValue(QSL(":%1phrase_body").arg(prefix), match);
+            q.bindValue(QSL(":%1phrase_rank").arg(prefix), match);
+            q.bindValue(QSL(":%1phrase_body_rank").arg(prefix), match);
+        }
+
+        if (account_id > 0) {
+            q.bindValue(QSL(":%1account_id").arg(prefix), account_id);
+        }
+
+        for (int i = 0; i < feed_custom_ids.size(); i++) {
+            q.bindValue(QSL(":%1feed%2").arg(prefix).arg(i), feed_custom_ids.at(i));
+        }
+    };
+
+    include_archive = include_archive && qApp->database()->archiveAvailable();
+
+    QString parts = search_part(QSL("Messages"), is_mysql ? QSL("MessageBodies") : QSL("MessagesFts"), QString());
+
+    if (include_archive) {
+        parts += QSL(" UNION ALL ") +
+                 search_part(archivedTable(db, QSL("Messages")),
+                             archivedTable(db, is_mysql ? QSL("MessageBodies") : QSL("MessagesFts")),
+                             QSL("archive_"));
+    }
+
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+    q.prepare(QSL("SELECT id FROM (%1) AS Results ORDER BY score %2 LIMIT :limit OFFSET :offset;")
+              .arg(parts, is_mysql ? QSL("DESC") : QSL("ASC")));
+    bind_part(q, QString());
+
+    if (include_archive) {
+        bind_part(q, QSL("archive_"));
+    }
+
+    q.bindValue(QSL(":limit"), limit);
+    q.bindValue(QSL(":offset"), offset);
+
+    if (DB_EXEC(q)) {
+        while (q.next()) {
+            ids.append(q.value(0).toInt());
+        }
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Full-text search for '" << phrase << "' failed: '"
+                   << q.lastError().text() << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    return ids;
+}
+
+QString DatabaseQueries::searchCondition(const QSqlDatabase &db, const QString &phrase, bool include_archive)
+{
+    const bool is_mysql = db.driverName() == QSL(APP_DB_MYSQL_DRIVER);
+    QSqlField match(QString(), QVariant::String);
+
+    match.setValue(is_mysql ? phrase.simplified() : ftsMatchExpression(phrase));
+
+    if (match.value().toString().isEmpty()) {
+        return QString();
+    }
+
+    // Condition becomes part of statements which are not prepared,
+    // so phrase is inserted as literal escaped by database driver.
+    const QString literal = db.driver()->formatValue(match);
+    auto search_part = [&](const QString &messages_table, const QString &index_table) {
+        if (is_mysql) {
+            return QSL("Messages.id IN (SELECT id FROM %1 WHERE MATCH (title, author) AGAINST (%3 IN NATURAL LANGUAGE MODE)) OR "
+                       "Messages.id IN (SELECT message_id FROM %2 WHERE MATCH (contents) AGAINST (%3 IN NATURAL LANGUAGE MODE))")
+                   .arg(messages_table, index_table, literal);
+        } else {
+            return QSL("Messages.id IN (SELECT rowid FROM %1 AS MessagesFts WHERE MessagesFts MATCH %2)")
+                   .arg(index_table, literal);
+        }
+    };
+
+    QString condition = search_part(QSL("Messages"), is_mysql ? QSL("MessageBodies") : QSL("MessagesFts"));
+
+    if (include_archive && qApp->database()->archiveAvailable()) {
+        // Archived messages have IDs different from IDs of working ones.
+        condition += QSL(" OR ") + search_part(archivedTable(db, QSL("Messages")),
+                                               archivedTable(db, is_mysql ? QSL("MessageBodies") : QSL("MessagesFts")));
+    }
+
+    return QSL("(%1)").arg(condition);
+}
+
+bool DatabaseQueries::changeFulltextEntries(const QSqlDatabase &db, const QString &condition,
+                                            const QMap<QString, QVariant> &values, FulltextEntry from,
+                                            FulltextEntry to, const QString &schema)
+{
+    if (db.driverName() != QSL(APP_DB_SQLITE_DRIVER) || from == to) {
+        return true;
+    }
+
+    QSqlQuery q(db);
+    QSqlQuery q_remove(db);
+    QSqlQuery q_add(db);
+
+    q.setForwardOnly(true);
+    q.prepare(QSL("SELECT Messages.id, Messages.title, Messages.author, MessageBodies.contents "
+                  "FROM %1Messages AS Messages "
+                  "LEFT JOIN %1MessageBodies AS MessageBodies ON MessageBodies.message_id = Messages.id "
+                  "WHERE %2;").arg(schema, condition));
+
+    for (auto i = values.constBegin(); i != values.constEnd(); ++i) {
+        q.bindValue(i.key(), i.value());
+    }
+
+    // Contentless index removes entry only when it gets exactly the same values which were indexed.
+    q_remove.prepare(QSL("INSERT INTO %1MessagesFts (MessagesFts, rowid, title, author, contents) "
+                         "VALUES ('delete', :id, :title, :author, :contents);").arg(schema));
+    q_add.prepare(QSL("INSERT INTO %1MessagesFts (rowid, title, author, contents) "
+                      "VALUES (:id, :title, :author, :contents);").arg(schema));
+
+    bool result = DB_EXEC(q);
+    QSqlError error = q.lastError();
+    auto change_entry = [&](QSqlQuery &change, FulltextEntry entry, const QString &contents) {
+        if (entry == FulltextEntry::None) {
+            return true;
+        }
+
+        change.bindValue(QSL(":id"), q.value(0));
+        change.bindValue(QSL(":title"), q.value(1));
+        change.bindValue(QSL(":author"), q.value(2));
+        change.bindValue(QSL(":contents"), entry == FulltextEntry::Whole ? unnulifyString(contents) : QSL(""));
+
+        if (!DB_EXEC(change)) {
+            error = change.lastError();
+            return false;
+        }
+
+        return true;
+    };
+
+    while (result && q.next()) {
+        const QString contents = from == FulltextEntry::Whole || to == FulltextEntry::Whole
+                                 ? Message::decompressContents(q.value(3).toString())
+                                 : QString();
+
+        result = change_entry(q_remove, from, contents) && change_entry(q_add, to, contents);
+    }
+
+    if (!result) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to change entries of full-text index: '"
+                   << error.text() << "'.";
+    }
+
+    return result;
+}
+
+QString DatabaseQueries::compressedContentsCondition()
+{
+    // See MSG_COMPRESSED_CONTENTS_MARKER.
+    return QSL("substr(MessageBodies.contents, 1, 6) = char(1) || 'zlib:'");
+}
+
+bool DatabaseQueries::rebuildFulltextIndex(const QSqlDatabase &db, const QString &schema)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    // Plain contents are indexed at once, compressed contents must be decompressed first.
+    const bool result = DB_EXEC_SQL(q, QSL("INSERT INTO %1MessagesFts (MessagesFts) VALUES ('delete-all');").arg(schema)) &&
+                        DB_EXEC_SQL(q, QSL("INSERT INTO %1MessagesFts (rowid, title, author, contents) "
+                                           "SELECT Messages.id, Messages.title, Messages.author, coalesce(MessageBodies.contents, '') "
+                                           "FROM %1Messages AS Messages "
+                                           "LEFT JOIN %1MessageBodies AS MessageBodies ON MessageBodies.message_id = Messages.id "
+                                           "WHERE NOT coalesce(%2, 0);").arg(schema, compressedContentsCondition())) &&
+                        changeFulltextEntries(db, compressedContentsCondition(), QMap<QString, QVariant>(),
+                                              FulltextEntry::None, FulltextEntry::Whole, schema);
+
+    if (result) {
+        qDebugNN << LOGSEC_DB << "Full-text index '" << schema << "MessagesFts' was rebuilt.";
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Rebuilding of full-text index '" << schema << "MessagesFts' failed: '"
+                   << q.lastError().text() << "'.";
+    }
+
+    return result;
+}
+
 QList<Message> DatabaseQueries::getUndeletedImportantMessages(const QSqlDatabase &db,
         int account_id, bool *ok)
 {
@@ -414,12 +994,12 @@ QList<Message> DatabaseQueries::getUndeletedImportantMessages(const QSqlDatabase
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    q.prepare("SELECT id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, contents, is_pdeleted, enclosures, account_id, custom_id, custom_hash, feed, CASE WHEN length(Messages.enclosures) > 10 THEN 'true' ELSE 'false' END AS has_enclosures "
-              "FROM Messages "
+    q.prepare("SELECT Messages.id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, MessageBodies.contents, is_pdeleted, MessageBodies.enclosures, account_id, custom_id, custom_hash, feed, has_enclosures "
+              "FROM Messages LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id "
               "WHERE is_important = 1 AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             bool decoded;
             Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -449,13 +1029,13 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForFeed(const QSqlDatabase &
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    q.prepare("SELECT id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, contents, is_pdeleted, enclosures, account_id, custom_id, custom_hash, feed, CASE WHEN length(Messages.enclosures) > 10 THEN 'true' ELSE 'false' END AS has_enclosures "
-              "FROM Messages "
+    q.prepare("SELECT Messages.id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, MessageBodies.contents, is_pdeleted, MessageBodies.enclosures, account_id, custom_id, custom_hash, feed, has_enclosures "
+              "FROM Messages LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id "
               "WHERE is_deleted = 0 AND is_pdeleted = 0 AND feed = :feed AND account_id = :account_id;");
     q.bindValue(QSL(":feed"), feed_custom_id);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             bool decoded;
             Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -484,12 +1064,12 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForBin(const QSqlDatabase &d
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    q.prepare("SELECT id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, contents, is_pdeleted, enclosures, account_id, custom_id, custom_hash, feed, CASE WHEN length(Messages.enclosures) > 10 THEN 'true' ELSE 'false' END AS has_enclosures "
-              "FROM Messages "
+    q.prepare("SELECT Messages.id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, MessageBodies.contents, is_pdeleted, MessageBodies.enclosures, account_id, custom_id, custom_hash, feed, has_enclosures "
+              "FROM Messages LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id "
               "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             bool decoded;
             Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -518,12 +1098,12 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForAccount(const QSqlDatabas
     QSqlQuery q(db);
 
     q.setForwardOnly(true);
-    q.prepare("SELECT id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, contents, is_pdeleted, enclosures, account_id, custom_id, custom_hash, feed, CASE WHEN length(Messages.enclosures) > 10 THEN 'true' ELSE 'false' END AS has_enclosures "
-              "FROM Messages "
+    q.prepare("SELECT Messages.id, is_read, is_deleted, is_important, custom_id, title, url, author, date_created, MessageBodies.contents, is_pdeleted, MessageBodies.enclosures, account_id, custom_id, custom_hash, feed, has_enclosures "
+              "FROM Messages LEFT JOIN MessageBodies ON MessageBodies.message_id = Messages.id "
               "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             bool decoded;
             Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -545,6 +1125,47 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForAccount(const QSqlDatabas
     return messages;
 }
 
+void DatabaseQueries::fillMessageBody(const QSqlDatabase &db, Message *message, bool *ok)
+{
+    QSqlQuery q = qApp->database()->preparedQuery(db, QSL("fillMessageBody"),
+                  QSL("SELECT contents, enclosures FROM MessageBodies WHERE message_id = :message_id;"));
+
+    q.bindValue(QSL(":message_id"), message->m_id);
+
+    bool found = DB_EXEC(q) && q.next();
+
+    if (!found && !q.lastError().isValid() && qApp->database()->archiveAvailable()) {
+        // Message is not in working database, so it may be archived.
+        q.finish();
+        q = qApp->database()->preparedQuery(db, QSL("fillArchivedMessageBody"),
+                                            QSL("SELECT contents, enclosures FROM %1 WHERE message_id = :message_id;")
+                                            .arg(archivedTable(db, QSL("MessageBodies"))));
+        q.bindValue(QSL(":message_id"), message->m_id);
+        found = DB_EXEC(q) && q.next();
+    }
+
+    if (!q.lastError().isValid()) {
+        if (found) {
+            message->m_contents = Message::decompressContents(q.value(0).toString());
+            message->m_enclosures = Enclosures::decodeEnclosuresFromString(q.value(1).toString());
+        }
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to load body of message '" << message->m_id << "': '"
+                   << q.lastError().text() << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    q.finish();
+}
+
 int DatabaseQueries::updateMessages(QSqlDatabase db,
                                     const QList<Message> &messages,
                                     const QString &feed_custom_id,
@@ -559,15 +1180,19 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
         return 0;
     }
 
+    // Database writer already wraps all its jobs in a transaction.
     bool use_transactions = qApp->settings()->value(GROUP(Database),
-                            SETTING(Database::UseTransactions)).toBool();
+                            SETTING(Database::UseTransactions)).toBool() &&
+                            !qApp->database()->writer()->isWriterThread();
+    // MySQL full-text indexes can not search compressed contents.
+    const bool is_sqlite = db.driverName() == QSL(APP_DB_SQLITE_DRIVER);
+    bool compress_contents = is_sqlite && qApp->settings()->value(GROUP(Database),
+                                                                  SETTING(Database::CompressContents)).toBool();
     int updated_messages = 0;
 
-    // Prepare queries.
-    QSqlQuery query_select_with_url(db);
-    QSqlQuery query_select_with_id(db);
-    QSqlQuery query_update(db);
-    QSqlQuery query_insert(db);
+    // Prepare queries. They are cached per connection because
+    // this method is called for each feed in each feed update.
+    DatabaseFactory *factory = qApp->database();
     QSqlQuery query_begin_transaction(db);
 
     // Here we have query which will check for existence of the "same" message in given feed.
@@ -576,30 +1201,116 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
     //   2) they have same URL AND,
     //   3) they have same AUTHOR AND,
     //   4) they have same TITLE.
-    query_select_with_url.setForwardOnly(true);
-    query_select_with_url.prepare("SELECT id, date_created, is_read, is_important, contents, feed FROM Messages "
-                                  "WHERE feed = :feed AND title = :title AND url = :url AND author = :author AND account_id = :account_id;");
+    QSqlQuery query_select_with_url = factory->preparedQuery(db, QSL("updateMessagesSelectWithUrl"),
+                                      QSL("SELECT id, date_created, is_read, is_important, feed, is_pdeleted FROM Messages "
+                                          "WHERE feed = :feed AND title = :title AND url = :url AND author = :author AND account_id = :account_id;"));
 
     // When we have custom ID of the message, we can check directly for existence
     // of that particular message.
-    query_select_with_id.setForwardOnly(true);
-    query_select_with_id.prepare("SELECT id, date_created, is_read, is_important, contents, feed FROM Messages "
-                                 "WHERE custom_id = :custom_id AND account_id = :account_id;");
+    QSqlQuery query_select_with_id = factory->preparedQuery(db, QSL("updateMessagesSelectWithId"),
+                                     QSL("SELECT id, date_created, is_read, is_important, feed, is_pdeleted FROM Messages "
+                                         "WHERE custom_id = :custom_id AND account_id = :account_id;"));
+
+    // Contents of existing message are only needed when its date changes.
+    QSqlQuery query_select_contents = factory->preparedQuery(db, QSL("updateMessagesSelectContents"),
+                                      QSL("SELECT contents FROM MessageBodies WHERE message_id = :message_id;"));
+
+    // Full-text index entries of messages with compressed contents are changed here, not by triggers.
+    QSqlQuery query_select_compressed;
+
+    if (is_sqlite) {
+        query_select_compressed = factory->preparedQuery(db, QSL("updateMessagesSelectCompressed"),
+                                  QSL("SELECT %1 FROM MessageBodies WHERE message_id = :message_id;")
+                                  .arg(compressedContentsCondition()));
+    }
 
     // Used to insert new messages.
-    query_insert.setForwardOnly(true);
-    query_insert.prepare("INSERT INTO Messages "
-                         "(feed, title, is_read, is_important, url, author, date_created, contents, enclosures, custom_id, custom_hash, account_id) "
-                         "VALUES (:feed, :title, :is_read, :is_important, :url, :author, :date_created, :contents, :enclosures, :custom_id, :custom_hash, :account_id);");
+    QSqlQuery query_insert = factory->preparedQuery(db, QSL("updateMessagesInsert"),
+                             QSL("INSERT INTO Messages "
+                                 "(id, feed, title, is_read, is_important, url, author, date_created, custom_id, custom_hash, account_id, has_enclosures) "
+                                 "VALUES (:id, :feed, :title, :is_read, :is_important, :url, :author, :date_created, :custom_id, :custom_hash, :account_id, :has_enclosures);"));
+    QSqlQuery query_insert_body = factory->preparedQuery(db, QSL("updateMessagesInsertBody"),
+                                  QSL("INSERT INTO MessageBodies (message_id, enclosures, contents) "
+                                      "VALUES (:message_id, :enclosures, :contents);"));
 
     // Used to update existing messages.
-    query_update.setForwardOnly(true);
-    query_update.prepare("UPDATE Messages "
-                         "SET title = :title, is_read = :is_read, is_important = :is_important, url = :url, author = :author, date_created = :date_created, contents = :contents, enclosures = :enclosures, feed = :feed "
-                         "WHERE id = :id;");
+    QSqlQuery query_update = factory->preparedQuery(db, QSL("updateMessagesUpdate"),
+                             QSL("UPDATE Messages "
+                                 "SET title = :title, is_read = :is_read, is_important = :is_important, url = :url, author = :author, date_created = :date_created, feed = :feed, has_enclosures = :has_enclosures "
+                                 "WHERE id = :id;"));
+    QSqlQuery query_update_body = factory->preparedQuery(db, QSL("updateMessagesUpdateBody"),
+                                  QSL("UPDATE MessageBodies SET enclosures = :enclosures, contents = :contents "
+                                      "WHERE message_id = :message_id;"));
+
+    // Archived messages are not downloaded again.
+    const bool archive_available = factory->archiveAvailable();
+    QSqlQuery query_select_archived_with_url, query_select_archived_with_id;
+
+    if (archive_available) {
+        query_select_archived_with_url = factory->preparedQuery(db, QSL("updateMessagesSelectArchivedWithUrl"),
+                                         QSL("SELECT id FROM %1 "
+                                             "WHERE feed = :feed AND title = :title AND url = :url AND author = :author AND account_id = :account_id;")
+                                         .arg(archivedTable(db, QSL("Messages"))));
+        query_select_archived_with_id = factory->preparedQuery(db, QSL("updateMessagesSelectArchivedWithId"),
+                                        QSL("SELECT id FROM %1 WHERE custom_id = :custom_id AND account_id = :account_id;")
+                                        .arg(archivedTable(db, QSL("Messages"))));
+    }
+
+    // ID for next new message, it is obtained once first new message is found.
+    qint64 next_message_id = 0;
+
+    auto is_archived_message = [&](const Message &message) {
+        QSqlQuery &query = message.m_customId.isEmpty() ? query_select_archived_with_url : query_select_archived_with_id;
+
+        if (message.m_customId.isEmpty()) {
+            query.bindValue(QSL(":feed"), unnulifyString(feed_custom_id));
+            query.bindValue(QSL(":title"), unnulifyString(message.m_title));
+            query.bindValue(QSL(":url"), unnulifyString(message.m_url));
+            query.bindValue(QSL(":author"), unnulifyString(message.m_author));
+        } else {
+            query.bindValue(QSL(":custom_id"), unnulifyString(message.m_customId));
+        }
+
+        query.bindValue(QSL(":account_id"), account_id);
+
+        const bool archived = DB_EXEC(query) && query.next();
+
+        query.finish();
+        return archived;
+    };
+
+    // Returns true if message has body, its contents are checked for compression.
+    auto has_body = [&query_select_compressed, is_sqlite](int message_id, bool *compressed) {
+        *compressed = false;
+
+        if (!is_sqlite) {
+            return false;
+        }
+
+        query_select_compressed.bindValue(QSL(":message_id"), message_id);
+
+        const bool found = DB_EXEC(query_select_compressed) && query_select_compressed.next();
+
+        *compressed = found && query_select_compressed.value(0).toBool();
+        query_select_compressed.finish();
+        return found;
+    };
+
+    auto contents_of_existing_message = [&query_select_contents](int message_id) {
+        QString contents;
+
+        query_select_contents.bindValue(QSL(":message_id"), message_id);
+
+        if (DB_EXEC(query_select_contents) && query_select_contents.next()) {
+            contents = Message::decompressContents(query_select_contents.value(0).toString());
+        }
+
+        query_select_contents.finish();
+        return contents;
+    };
 
     if (use_transactions
-            && !query_begin_transaction.exec(qApp->database()->obtainBeginTransactionSql())) {
+            && !DB_EXEC_SQL(query_begin_transaction, qApp->database()->obtainBeginTransactionSql())) {
         qCriticalNN << LOGSEC_DB
                     << "Transaction start for message downloader failed: '"
                     << query_begin_transaction.lastError().text() << "'.";
@@ -625,8 +1336,8 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
         qint64 date_existing_message;
         bool is_read_existing_message;
         bool is_important_existing_message;
-        QString contents_existing_message;
         QString feed_id_existing_message;
+        bool is_pdeleted_existing_message = false;
 
         if (message.m_customId.isEmpty()) {
             // We need to recognize existing messages according URL & AUTHOR & TITLE.
@@ -646,13 +1357,13 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
                      << message.m_author
                      << "' is present in DB.";
 
-            if (query_select_with_url.exec() && query_select_with_url.next()) {
+            if (DB_EXEC(query_select_with_url) && query_select_with_url.next()) {
                 id_existing_message = query_select_with_url.value(0).toInt();
                 date_existing_message = query_select_with_url.value(1).value<qint64>();
                 is_read_existing_message = query_select_with_url.value(2).toBool();
                 is_important_existing_message = query_select_with_url.value(3).toBool();
-                contents_existing_message = query_select_with_url.value(4).toString();
-                feed_id_existing_message = query_select_with_url.value(5).toString();
+                feed_id_existing_message = query_select_with_url.value(4).toString();
+                is_pdeleted_existing_message = query_select_with_url.value(5).toBool();
 
                 qDebugNN << LOGSEC_DB
                          << "Message with these attributes is already present in DB and has DB ID '"
@@ -677,13 +1388,13 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
                      << message.m_customId
                      << "' is present in DB.";
 
-            if (query_select_with_id.exec() && query_select_with_id.next()) {
+            if (DB_EXEC(query_select_with_id) && query_select_with_id.next()) {
                 id_existing_message = query_select_with_id.value(0).toInt();
                 date_existing_message = query_select_with_id.value(1).value<qint64>();
                 is_read_existing_message = query_select_with_id.value(2).toBool();
                 is_important_existing_message = query_select_with_id.value(3).toBool();
-                contents_existing_message = query_select_with_id.value(4).toString();
-                feed_id_existing_message = query_select_with_id.value(5).toString();
+                feed_id_existing_message = query_select_with_id.value(4).toString();
+                is_pdeleted_existing_message = query_select_with_id.value(5).toBool();
 
                 qDebugNN << LOGSEC_DB
                          << "Message with custom ID %s is already present in DB and has DB ID '"
@@ -700,7 +1411,14 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
         }
 
         // Now, check if this message is already in the DB.
-        if (id_existing_message >= 0) {
+        if (id_existing_message >= 0 && is_pdeleted_existing_message) {
+            // Message was purged, either by user or by retention policy,
+            // and it is not shown anymore, so it is kept as it is.
+            qDebugNN << LOGSEC_DB
+                     << "Message with DB ID '"
+                     << id_existing_message
+                     << "' is purged, skipping it.";
+        } else if (id_existing_message >= 0) {
             // Message is already in the DB.
             //
             // Now, we update it if at least one of next conditions is true:
@@ -713,7 +1431,7 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
                              message.m_feedId != feed_id_existing_message)) ||
 
                         /* 2 */ (message.m_createdFromFeed && message.m_created.toMSecsSinceEpoch() != date_existing_message
-                                 && message.m_contents != contents_existing_message)) {
+                                 && message.m_contents != contents_of_existing_message(id_existing_message))) {
                 // Message exists, it is changed, update it.
                 query_update.bindValue(QSL(":title"), unnulifyString(message.m_title));
                 query_update.bindValue(QSL(":is_read"), (int) message.m_isRead);
@@ -721,14 +1439,41 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
                 query_update.bindValue(QSL(":url"), unnulifyString(message.m_url));
                 query_update.bindValue(QSL(":author"), unnulifyString(message.m_author));
                 query_update.bindValue(QSL(":date_created"), message.m_created.toMSecsSinceEpoch());
-                query_update.bindValue(QSL(":contents"), unnulifyString(message.m_contents));
-                query_update.bindValue(QSL(":enclosures"),
-                                       Enclosures::encodeEnclosuresToString(message.m_enclosures));
                 query_update.bindValue(QSL(":feed"), unnulifyString(feed_id_existing_message));
+                query_update.bindValue(QSL(":has_enclosures"), int(!message.m_enclosures.isEmpty()));
                 query_update.bindValue(QSL(":id"), id_existing_message);
+                const QString contents = compress_contents
+                                         ? Message::compressContents(unnulifyString(message.m_contents))
+                                         : unnulifyString(message.m_contents);
+
+                query_update_body.bindValue(QSL(":contents"), contents);
+                query_update_body.bindValue(QSL(":enclosures"),
+                                            Enclosures::encodeEnclosuresToString(message.m_enclosures));
+                query_update_body.bindValue(QSL(":message_id"), id_existing_message);
                 *any_message_changed = true;
 
-                if (query_update.exec()) {
+                // Triggers do not change index entry of message while its contents are compressed, so
+                // entry is replaced here and message is updated only while compressed contents are stored.
+                const QMap<QString, QVariant> message_values = { { QSL(":id"), id_existing_message } };
+                const bool compressed_after = Message::isCompressedContents(contents);
+                bool compressed_before;
+                const bool reindex = has_body(id_existing_message, &compressed_before) &&
+                                     (compressed_before || compressed_after);
+                bool updated = !reindex || changeFulltextEntries(db, QSL("Messages.id = :id"), message_values,
+                                                                 FulltextEntry::Whole, FulltextEntry::None);
+
+                if (compressed_after) {
+                    updated = updated && DB_EXEC(query_update_body) && DB_EXEC(query_update);
+                } else {
+                    updated = updated && DB_EXEC(query_update) && DB_EXEC(query_update_body);
+                }
+
+                if (updated && reindex) {
+                    updated = changeFulltextEntries(db, QSL("Messages.id = :id"), message_values,
+                                                    FulltextEntry::None, FulltextEntry::Whole);
+                }
+
+                if (updated) {
                     qDebugNN << LOGSEC_DB
                              << "Updating message with title '"
                              << message.m_title
@@ -742,12 +1487,27 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
                 } else if (query_update.lastError().isValid()) {
                     qWarningNN << LOGSEC_DB
                                << "Failed to update message in DB: '" << query_update.lastError().text() << "'.";
+                } else if (query_update_body.lastError().isValid()) {
+                    qWarningNN << LOGSEC_DB
+                               << "Failed to update message body in DB: '" << query_update_body.lastError().text() << "'.";
                 }
 
                 query_update.finish();
+                query_update_body.finish();
             }
+        } else if (archive_available && is_archived_message(message)) {
+            qDebugNN << LOGSEC_DB
+                     << "Message with title '"
+                     << message.m_title
+                     << "' is already archived, skipping it.";
         } else {
             // Message with this URL is not fetched in this feed yet.
+            if (next_message_id <= 0) {
+                next_message_id = nextMessageId(db, archive_available);
+            }
+
+            // If ID is not known, database assigns it by itself.
+            query_insert.bindValue(QSL(":id"), next_message_id > 0 ? QVariant(next_message_id) : QVariant());
             query_insert.bindValue(QSL(":feed"), unnulifyString(feed_custom_id));
             query_insert.bindValue(QSL(":title"), unnulifyString(message.m_title));
             query_insert.bindValue(QSL(":is_read"), (int) message.m_isRead);
@@ -755,16 +1515,41 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
             query_insert.bindValue(QSL(":url"), unnulifyString( message.m_url));
             query_insert.bindValue(QSL(":author"), unnulifyString(message.m_author));
             query_insert.bindValue(QSL(":date_created"), message.m_created.toMSecsSinceEpoch());
-            query_insert.bindValue(QSL(":contents"), unnulifyString(message.m_contents));
-            query_insert.bindValue(QSL(":enclosures"),
-                                   Enclosures::encodeEnclosuresToString(message.m_enclosures));
             query_insert.bindValue(QSL(":custom_id"), unnulifyString(message.m_customId));
             query_insert.bindValue(QSL(":custom_hash"), unnulifyString(message.m_customHash));
             query_insert.bindValue(QSL(":account_id"), account_id);
+            query_insert.bindValue(QSL(":has_enclosures"), int(!message.m_enclosures.isEmpty()));
 
-            if (query_insert.exec() && query_insert.numRowsAffected() == 1) {
+            if (DB_EXEC(query_insert) && query_insert.numRowsAffected() == 1) {
                 updated_messages++;
 
+                if (next_message_id > 0) {
+                    next_message_id++;
+                }
+
+                const QVariant message_id = query_insert.lastInsertId();
+                const QString contents = compress_contents
+                                         ? Message::compressContents(unnulifyString(message.m_contents))
+                                         : unnulifyString(message.m_contents);
+
+                query_insert_body.bindValue(QSL(":message_id"), message_id);
+                query_insert_body.bindValue(QSL(":contents"), contents);
+                query_insert_body.bindValue(QSL(":enclosures"),
+                                            Enclosures::encodeEnclosuresToString(message.m_enclosures));
+
+                if (!DB_EXEC(query_insert_body)) {
+                    qWarningNN << LOGSEC_DB
+                               << "Failed to insert message body to DB: '"
+                               << query_insert_body.lastError().text()
+                               << "'.";
+                } else if (Message::isCompressedContents(contents)) {
+                    // Message was indexed without contents, because it had no body yet.
+                    changeFulltextEntries(db, QSL("Messages.id = :id"), { { QSL(":id"), message_id } },
+                                          FulltextEntry::Headers, FulltextEntry::Whole);
+                }
+
+                query_insert_body.finish();
+
                 qDebugNN << LOGSEC_DB
                          << "Adding new message with title '"
                          << message.m_title
@@ -831,7 +1616,7 @@ bool DatabaseQueries::purgeMessagesFromBin(const QSqlDatabase &db, bool clear_on
     }
 
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::deleteAccount(const QSqlDatabase &db, int account_id)
@@ -841,8 +1626,12 @@ bool DatabaseQueries::deleteAccount(const QSqlDatabase &db, int account_id)
     query.setForwardOnly(true);
     QStringList queries;
 
-    queries << QSL("DELETE FROM Messages WHERE account_id = :account_id;")
-            << QSL("DELETE FROM Feeds WHERE account_id = :account_id;")
+    if (!deleteMessages(db, QSL("account_id = :account_id"), { { QSL(":account_id"), account_id } })) {
+        qCriticalNN << LOGSEC_DB << "Removing of account messages from DB failed, this is critical.";
+        return false;
+    }
+
+    queries << QSL("DELETE FROM Feeds WHERE account_id = :account_id;")
             << QSL("DELETE FROM Categories WHERE account_id = :account_id;")
             << QSL("DELETE FROM MessageFiltersInFeeds WHERE account_id = :account_id;")
             << QSL("DELETE FROM Accounts WHERE id = :account_id;");
@@ -851,7 +1640,7 @@ bool DatabaseQueries::deleteAccount(const QSqlDatabase &db, int account_id)
         query.prepare(q);
         query.bindValue(QSL(":account_id"), account_id);
 
-        if (!query.exec()) {
+        if (!DB_EXEC(query)) {
             qCriticalNN << LOGSEC_DB
                         << "Removing of account from DB failed, this is critical: '"
                         << query.lastError().text()
@@ -874,18 +1663,16 @@ bool DatabaseQueries::deleteAccountData(const QSqlDatabase &db, int account_id,
     q.setForwardOnly(true);
 
     if (delete_messages_too) {
-        q.prepare(QSL("DELETE FROM Messages WHERE account_id = :account_id;"));
-        q.bindValue(QSL(":account_id"), account_id);
-        result &= q.exec();
+        result &= deleteMessages(db, QSL("account_id = :account_id"), { { QSL(":account_id"), account_id } });
     }
 
     q.prepare(QSL("DELETE FROM Feeds WHERE account_id = :account_id;"));
     q.bindValue(QSL(":account_id"), account_id);
-    result &= q.exec();
+    result &= DB_EXEC(q);
 
     q.prepare(QSL("DELETE FROM Categories WHERE account_id = :account_id;"));
     q.bindValue(QSL(":account_id"), account_id);
-    result &= q.exec();
+    result &= DB_EXEC(q);
 
     return result;
 }
@@ -908,7 +1695,7 @@ bool DatabaseQueries::cleanImportantMessages(const QSqlDatabase &db, bool clean_
     q.bindValue(QSL(":deleted"), 1);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
         qWarningNN << LOGSEC_DB
                    << "Cleaning of important messages failed: '"
                    << q.lastError().text()
@@ -939,7 +1726,7 @@ bool DatabaseQueries::cleanFeeds(const QSqlDatabase &db, const QStringList &ids,
     q.bindValue(QSL(":deleted"), 1);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
         qWarningNN << LOGSEC_DB
                    << "Cleaning of feeds failed: '"
                    << q.lastError().text()
@@ -957,33 +1744,13 @@ bool DatabaseQueries::purgeLeftoverMessageFilterAssignments(const QSqlDatabase &
     q.setForwardOnly(true);
     q.prepare(
         QSL("DELETE FROM MessageFiltersInFeeds "
-            "WHERE account_id = :account_id AND "
-            "feed_custom_id NOT IN (SELECT custom_id FROM Feeds WHERE account_id = :account_id);"));
-    q.bindValue(QSL(":account_id"), account_id);
-
-    if (!q.exec()) {
-        qWarningNN << LOGSEC_DB
-                   << "Removing of leftover message filter assignments failed: '"
-                   << q.lastError().text()
-                   << "'.";
-        return false;
-    } else {
-        return true;
-    }
-}
-
-bool DatabaseQueries::purgeLeftoverMessages(const QSqlDatabase &db, int account_id)
-{
-    QSqlQuery q(db);
-
-    q.setForwardOnly(true);
-    q.prepare(
-        QSL("DELETE FROM Messages WHERE account_id = :account_id AND feed NOT IN (SELECT custom_id FROM Feeds WHERE account_id = :account_id);"));
+            "WHERE account_id = :account_id AND "
+            "feed_custom_id NOT IN (SELECT custom_id FROM Feeds WHERE account_id = :account_id);"));
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
         qWarningNN << LOGSEC_DB
-                   << "Removing of leftover messages failed: '"
+                   << "Removing of leftover message filter assignments failed: '"
                    << q.lastError().text()
                    << "'.";
         return false;
@@ -992,36 +1759,57 @@ bool DatabaseQueries::purgeLeftoverMessages(const QSqlDatabase &db, int account_
     }
 }
 
-bool DatabaseQueries::storeAccountTree(const QSqlDatabase &db, RootItem *tree_root, int account_id)
+bool DatabaseQueries::purgeLeftoverMessages(const QSqlDatabase &db, int account_id)
+{
+    return deleteMessages(db,
+                          QSL("account_id = :account_id AND feed NOT IN (SELECT custom_id FROM Feeds WHERE account_id = :account_id)"),
+                          { { QSL(":account_id"), account_id } });
+}
+
+bool DatabaseQueries::storeAccountTree(const QSqlDatabase &db, RootItem *tree_root, int account_id,
+                                       const StoreProgress &progress)
 {
+    QSqlDatabase database = db;
     QSqlQuery query_category(db);
     QSqlQuery query_feed(db);
+    const QList<RootItem *> items = tree_root->getSubTree();
+    int stored = 0;
 
     query_category.setForwardOnly(true);
     query_feed.setForwardOnly(true);
     query_category.prepare("INSERT INTO Categories (parent_id, title, account_id, custom_id) "
                            "VALUES (:parent_id, :title, :account_id, :custom_id);");
-    query_feed.prepare("INSERT INTO Feeds (title, icon, category, protected, update_type, update_interval, account_id, custom_id) "
-                       "VALUES (:title, :icon, :category, :protected, :update_type, :update_interval, :account_id, :custom_id);");
+    query_feed.prepare("INSERT INTO Feeds (title, icon_id, category, protected, update_type, update_interval, account_id, custom_id) "
+                       "VALUES (:title, :icon_id, :category, :protected, :update_type, :update_interval, :account_id, :custom_id);");
+
+    // Whole tree is stored at once.
+    bool own_transaction;
+
+    if (!beginTransaction(database, &own_transaction)) {
+        return false;
+    }
+
+    bool result = true;
 
     // Iterate all children.
-    for (RootItem *child : tree_root->getSubTree()) {
+    for (RootItem *child : items) {
         if (child->kind() == RootItem::Kind::Category) {
             query_category.bindValue(QSL(":parent_id"), child->parent()->id());
             query_category.bindValue(QSL(":title"), child->title());
             query_category.bindValue(QSL(":account_id"), account_id);
             query_category.bindValue(QSL(":custom_id"), child->customId());
 
-            if (query_category.exec()) {
+            if (DB_EXEC(query_category)) {
                 child->setId(query_category.lastInsertId().toInt());
             } else {
-                return false;
+                result = false;
+                break;
             }
         } else if (child->kind() == RootItem::Kind::Feed) {
             Feed *feed = child->toFeed();
 
             query_feed.bindValue(QSL(":title"), feed->title());
-            query_feed.bindValue(QSL(":icon"), qApp->icons()->toByteArray(feed->icon()));
+            query_feed.bindValue(QSL(":icon_id"), storeIcon(db, feed->icon()));
             query_feed.bindValue(QSL(":category"), feed->parent()->id());
             query_feed.bindValue(QSL(":protected"), 0);
             query_feed.bindValue(QSL(":update_type"), (int) feed->autoUpdateType());
@@ -1029,15 +1817,143 @@ bool DatabaseQueries::storeAccountTree(const QSqlDatabase &db, RootItem *tree_ro
             query_feed.bindValue(QSL(":account_id"), account_id);
             query_feed.bindValue(QSL(":custom_id"), feed->customId());
 
-            if (query_feed.exec()) {
+            if (DB_EXEC(query_feed)) {
                 feed->setId(query_feed.lastInsertId().toInt());
             } else {
-                return false;
+                result = false;
+                break;
             }
         }
+
+        if (progress != nullptr && !progress(++stored, items.size())) {
+            qWarningNN << LOGSEC_DB << "Storing of tree of account '" << account_id << "' was cancelled.";
+            result = false;
+            break;
+        }
     }
 
-    return true;
+    if (own_transaction) {
+        if (result) {
+            result = database.commit();
+        } else {
+            database.rollback();
+        }
+    }
+
+    return result;
+}
+
+QVariant DatabaseQueries::storeIcon(const QSqlDatabase &db, const QIcon &icon)
+{
+    const QByteArray data = IconFactory::toPng(icon);
+
+    if (data.isEmpty()) {
+        return QVariant(QVariant::Int);
+    }
+
+    const QString hash = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+    QSqlQuery q = qApp->database()->preparedQuery(db, QSL("storeIconSelect"),
+                                                  QSL("SELECT id FROM Icons WHERE hash = :hash;"));
+
+    q.bindValue(QSL(":hash"), hash);
+
+    if (DB_EXEC(q) && q.next()) {
+        return q.value(0).toInt();
+    }
+
+    q = qApp->database()->preparedQuery(db, QSL("storeIconInsert"),
+                                        QSL("INSERT INTO Icons (hash, data) VALUES (:hash, :data);"));
+    q.bindValue(QSL(":hash"), hash);
+    q.bindValue(QSL(":data"), data);
+
+    if (DB_EXEC(q)) {
+        const int icon_id = q.lastInsertId().toInt();
+
+        qApp->icons()->addStoredIcon(icon_id, data);
+        return icon_id;
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to store icon: '"
+                   << q.lastError().text() << "'.";
+        return QVariant(QVariant::Int);
+    }
+}
+
+QHash<int, QByteArray> DatabaseQueries::getIcons(const QSqlDatabase &db, bool *ok)
+{
+    QHash<int, QByteArray> icons;
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    if (DB_EXEC_SQL(q, QSL("SELECT id, data FROM Icons;"))) {
+        while (q.next()) {
+            icons.insert(q.value(0).toInt(), q.value(1).toByteArray());
+        }
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to load icons: '"
+                   << q.lastError().text() << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    return icons;
+}
+
+bool DatabaseQueries::migrateLegacyIcons(const QSqlDatabase &db)
+{
+    QSqlQuery q_select(db);
+    QSqlQuery q_update(db);
+    bool result = true;
+
+    q_select.setForwardOnly(true);
+    q_update.setForwardOnly(true);
+
+    for (const QString &table : QStringList { QSL("Categories"), QSL("Feeds") }) {
+        QList<QPair<int, QByteArray>> migrated;
+
+        if (!DB_EXEC_SQL(q_select, QSL("SELECT id, icon FROM %1 WHERE icon IS NOT NULL;").arg(table))) {
+            result = false;
+            continue;
+        }
+
+        while (q_select.next()) {
+            migrated.append({ q_select.value(0).toInt(), q_select.value(1).toByteArray() });
+        }
+
+        q_select.finish();
+        q_update.prepare(QSL("UPDATE %1 SET icon = NULL, icon_id = :icon_id WHERE id = :id;").arg(table));
+
+        for (const auto &item : migrated) {
+            q_update.bindValue(QSL(":icon_id"), storeIcon(db, IconFactory::fromByteArray(item.second)));
+            q_update.bindValue(QSL(":id"), item.first);
+            result &= DB_EXEC(q_update);
+        }
+
+        if (!migrated.isEmpty()) {
+            qDebugNN << LOGSEC_DB
+                     << "Moved " << migrated.size() << " icons of '" << table << "' to icon store.";
+        }
+    }
+
+    return result;
+}
+
+bool DatabaseQueries::purgeUnusedIcons(const QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+    return DB_EXEC_SQL(q, QSL("DELETE FROM Icons WHERE "
+                              "id NOT IN (SELECT icon_id FROM Feeds WHERE icon_id IS NOT NULL) AND "
+                              "id NOT IN (SELECT icon_id FROM Categories WHERE icon_id IS NOT NULL);"));
 }
 
 QStringList DatabaseQueries::customIdsOfMessagesFromAccount(const QSqlDatabase &db, int account_id,
@@ -1052,9 +1968,9 @@ QStringList DatabaseQueries::customIdsOfMessagesFromAccount(const QSqlDatabase &
     q.bindValue(QSL(":account_id"), account_id);
 
     if (ok != nullptr) {
-        *ok = q.exec();
+        *ok = DB_EXEC(q);
     } else {
-        q.exec();
+        DB_EXEC(q);
     }
 
     while (q.next()) {
@@ -1076,9 +1992,9 @@ QStringList DatabaseQueries::customIdsOfImportantMessages(const QSqlDatabase &db
     q.bindValue(QSL(":account_id"), account_id);
 
     if (ok != nullptr) {
-        *ok = q.exec();
+        *ok = DB_EXEC(q);
     } else {
-        q.exec();
+        DB_EXEC(q);
     }
 
     while (q.next()) {
@@ -1100,9 +2016,9 @@ QStringList DatabaseQueries::customIdsOfMessagesFromBin(const QSqlDatabase &db,
     q.bindValue(QSL(":account_id"), account_id);
 
     if (ok != nullptr) {
-        *ok = q.exec();
+        *ok = DB_EXEC(q);
     } else {
-        q.exec();
+        DB_EXEC(q);
     }
 
     while (q.next()) {
@@ -1125,9 +2041,9 @@ QStringList DatabaseQueries::customIdsOfMessagesFromFeed(const QSqlDatabase &db,
     q.bindValue(QSL(":feed"), feed_custom_id);
 
     if (ok != nullptr) {
-        *ok = q.exec();
+        *ok = DB_EXEC(q);
     } else {
-        q.exec();
+        DB_EXEC(q);
     }
 
     while (q.next()) {
@@ -1137,12 +2053,54 @@ QStringList DatabaseQueries::customIdsOfMessagesFromFeed(const QSqlDatabase &db,
     return ids;
 }
 
+QStringList DatabaseQueries::customIdsOfMessages(const QSqlDatabase &db, const QStringList &ids, bool *ok)
+{
+    QStringList custom_ids;
+    bool executed = true;
+
+    // IDs are bound in chunks, so that batches of any size
+    // do not produce huge statements.
+    for (int i = 0; executed && i < ids.size(); i += MSG_BULK_CHUNK_SIZE) {
+        const QStringList chunk = ids.mid(i, MSG_BULK_CHUNK_SIZE);
+        const QString select_sql = QSL("SELECT custom_id FROM Messages WHERE id IN (?%1);")
+                                   .arg(QSL(", ?").repeated(chunk.size() - 1));
+
+        // Full chunks are the same every time, so they are prepared only once.
+        QSqlQuery q = chunk.size() == MSG_BULK_CHUNK_SIZE
+                      ? qApp->database()->preparedQuery(db, QSL("customIdsOfMessages"), select_sql)
+                      : QSqlQuery(db);
+
+        if (chunk.size() != MSG_BULK_CHUNK_SIZE) {
+            q.setForwardOnly(true);
+            q.prepare(select_sql);
+        }
+
+        for (int j = 0; j < chunk.size(); j++) {
+            q.bindValue(j, chunk.at(j).toInt());
+        }
+
+        executed = DB_EXEC(q);
+
+        while (q.next()) {
+            custom_ids.append(q.value(0).toString());
+        }
+
+        q.finish();
+    }
+
+    if (ok != nullptr) {
+        *ok = executed;
+    }
+
+    return custom_ids;
+}
+
 QList<ServiceRoot *> DatabaseQueries::getOwnCloudAccounts(const QSqlDatabase &db, bool *ok)
 {
     QSqlQuery query(db);
     QList<ServiceRoot *> roots;
 
-    if (query.exec("SELECT * FROM OwnCloudAccounts;")) {
+    if (DB_EXEC_SQL(query, "SELECT * FROM OwnCloudAccounts;")) {
         while (query.next()) {
             auto *root = new OwnCloudServiceRoot();
 
@@ -1181,7 +2139,7 @@ QList<ServiceRoot *> DatabaseQueries::getTtRssAccounts(const QSqlDatabase &db, b
     QSqlQuery query(db);
     QList<ServiceRoot *> roots;
 
-    if (query.exec("SELECT * FROM TtRssAccounts;")) {
+    if (DB_EXEC_SQL(query, "SELECT * FROM TtRssAccounts;")) {
         while (query.next()) {
             auto *root = new TtRssServiceRoot();
 
@@ -1224,7 +2182,7 @@ bool DatabaseQueries::deleteOwnCloudAccount(const QSqlDatabase &db, int account_
     q.setForwardOnly(true);
     q.prepare(QSL("DELETE FROM OwnCloudAccounts WHERE id = :id;"));
     q.bindValue(QSL(":id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::overwriteOwnCloudAccount(const QSqlDatabase &db, const QString &username,
@@ -1246,7 +2204,7 @@ bool DatabaseQueries::overwriteOwnCloudAccount(const QSqlDatabase &db, const QSt
     query.bindValue(QSL(":msg_limit"), batch_size <= 0 ? OWNCLOUD_UNLIMITED_BATCH_SIZE : batch_size);
     query.bindValue(QSL(":update_only_unread"), download_only_unread_messages ? 1 : 0);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         return true;
     } else {
         qWarningNN << LOGSEC_NEXTCLOUD
@@ -1275,7 +2233,7 @@ bool DatabaseQueries::createOwnCloudAccount(const QSqlDatabase &db, int id_to_as
     q.bindValue(QSL(":msg_limit"), batch_size <= 0 ? OWNCLOUD_UNLIMITED_BATCH_SIZE : batch_size);
     q.bindValue(QSL(":update_only_unread"), download_only_unread_messages ? 1 : 0);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         return true;
     } else {
         qWarningNN << LOGSEC_NEXTCLOUD
@@ -1291,7 +2249,7 @@ int DatabaseQueries::createAccount(const QSqlDatabase &db, const QString &code,
     QSqlQuery q(db);
 
     // First obtain the ID, which can be assigned to this new account.
-    if (!q.exec("SELECT max(id) FROM Accounts;") || !q.next()) {
+    if (!DB_EXEC_SQL(q, "SELECT max(id) FROM Accounts;") || !q.next()) {
         qWarning("Getting max ID from Accounts table failed: '%s'.", qPrintable(q.lastError().text()));
 
         if (ok != nullptr) {
@@ -1307,7 +2265,7 @@ int DatabaseQueries::createAccount(const QSqlDatabase &db, const QString &code,
     q.bindValue(QSL(":id"), id_to_assign);
     q.bindValue(QSL(":type"), code);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1326,6 +2284,175 @@ int DatabaseQueries::createAccount(const QSqlDatabase &db, const QString &code,
     }
 }
 
+RetentionPolicy DatabaseQueries::getRetentionPolicy(const QSqlDatabase &db, RootItem::Kind item_kind,
+                                                    const QString &custom_id, int account_id, bool *ok)
+{
+    RetentionPolicy policy;
+    QSqlQuery q = qApp->database()->preparedQuery(db, QSL("getRetentionPolicy"),
+                  QSL("SELECT max_age, max_count, keep_important FROM RetentionPolicies "
+                      "WHERE account_id = :account_id AND item_kind = :item_kind AND custom_id = :custom_id;"));
+
+    q.bindValue(QSL(":account_id"), account_id);
+    q.bindValue(QSL(":item_kind"), int(item_kind));
+    q.bindValue(QSL(":custom_id"), custom_id);
+
+    if (DB_EXEC(q)) {
+        if (q.next()) {
+            policy.m_maxAge = q.value(0).toInt();
+            policy.m_maxCount = q.value(1).toInt();
+            policy.m_keepImportant = q.value(2).toBool();
+        }
+
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+
+    q.finish();
+    return policy;
+}
+
+void DatabaseQueries::storeRetentionPolicy(const QSqlDatabase &db, RootItem::Kind item_kind,
+                                           const QString &custom_id, int account_id,
+                                           const RetentionPolicy &policy, bool *ok)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    if (policy.isEmpty()) {
+        q.prepare(QSL("DELETE FROM RetentionPolicies "
+                      "WHERE account_id = :account_id AND item_kind = :item_kind AND custom_id = :custom_id;"));
+    } else {
+        q.prepare(QSL("REPLACE INTO RetentionPolicies (account_id, item_kind, custom_id, max_age, max_count, keep_important) "
+                      "VALUES (:account_id, :item_kind, :custom_id, :max_age, :max_count, :keep_important);"));
+        q.bindValue(QSL(":max_age"), qMax(policy.m_maxAge, 0));
+        q.bindValue(QSL(":max_count"), qMax(policy.m_maxCount, 0));
+        q.bindValue(QSL(":keep_important"), policy.m_keepImportant ? 1 : 0);
+    }
+
+    q.bindValue(QSL(":account_id"), account_id);
+    q.bindValue(QSL(":item_kind"), int(item_kind));
+    q.bindValue(QSL(":custom_id"), custom_id);
+
+    if (DB_EXEC(q)) {
+        if (ok != nullptr) {
+            *ok = true;
+        }
+    } else {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to store retention policy of item '" << custom_id << "': '"
+                   << q.lastError().text() << "'.";
+
+        if (ok != nullptr) {
+            *ok = false;
+        }
+    }
+}
+
+int DatabaseQueries::applyRetentionPolicy(const QSqlDatabase &db, const QString &feed_custom_id, int account_id,
+                                          const RetentionPolicy &policy, bool *ok)
+{
+    // All queries only touch rows of single feed and go
+    // through (account_id, feed, date_created) index.
+    const QString keep_important = policy.m_keepImportant ? QSL(" AND is_important = 0") : QString();
+    QSqlQuery q(db);
+    int removed = 0;
+    bool result = true;
+
+    q.setForwardOnly(true);
+
+    // Messages are not deleted, they are only marked as purged and lose their contents.
+    // Updates of feed then still recognize them and do not download them as new ones.
+    auto purge_messages = [&](const QString &condition, QMap<QString, QVariant> values) {
+        values.insert(QSL(":account_id"), account_id);
+        values.insert(QSL(":feed"), feed_custom_id);
+
+        // Triggers only drop plain contents from full-text index.
+        if (!changeFulltextEntries(db, QSL("account_id = :account_id AND feed = :feed AND is_pdeleted = 0%1 AND %2 AND %3")
+                                   .arg(keep_important, condition, compressedContentsCondition()),
+                                   values, FulltextEntry::Whole, FulltextEntry::Headers)) {
+            return false;
+        }
+
+        q.prepare(QSL("DELETE FROM MessageBodies WHERE message_id IN "
+                      "(SELECT id FROM Messages WHERE account_id = :account_id AND feed = :feed AND is_pdeleted = 0%1 AND %2);")
+                  .arg(keep_important, condition));
+
+        for (auto i = values.constBegin(); i != values.constEnd(); ++i) {
+            q.bindValue(i.key(), i.value());
+        }
+
+        if (!DB_EXEC(q)) {
+            return false;
+        }
+
+        q.prepare(QSL("UPDATE Messages SET is_pdeleted = 1 "
+                      "WHERE account_id = :account_id AND feed = :feed AND is_pdeleted = 0%1 AND %2;")
+                  .arg(keep_important, condition));
+
+        for (auto i = values.constBegin(); i != values.constEnd(); ++i) {
+            q.bindValue(i.key(), i.value());
+        }
+
+        if (!DB_EXEC(q)) {
+            return false;
+        }
+
+        removed += qMax(q.numRowsAffected(), 0);
+        return true;
+    };
+
+    if (policy.m_maxAge > 0) {
+        QMap<QString, QVariant> values;
+
+        values.insert(QSL(":date_created"), QDateTime::currentDateTimeUtc().addDays(-policy.m_maxAge).toMSecsSinceEpoch());
+        result = purge_messages(QSL("date_created < :date_created"), values);
+    }
+
+    if (result && policy.m_maxCount > 0) {
+        // Find the newest message which does not fit into the limit,
+        // then remove it together with all older messages.
+        q.prepare(QSL("SELECT date_created, id FROM Messages "
+                      "WHERE account_id = :account_id AND feed = :feed AND is_pdeleted = 0%1 "
+                      "ORDER BY date_created DESC, id DESC LIMIT 1 OFFSET :max_count;")
+                  .arg(keep_important));
+        q.bindValue(QSL(":account_id"), account_id);
+        q.bindValue(QSL(":feed"), feed_custom_id);
+        q.bindValue(QSL(":max_count"), policy.m_maxCount);
+
+        if (!DB_EXEC(q)) {
+            result = false;
+        } else if (q.next()) {
+            QMap<QString, QVariant> values;
+
+            values.insert(QSL(":date_created"), q.value(0).value<qint64>());
+            values.insert(QSL(":date_created_same"), q.value(0).value<qint64>());
+            values.insert(QSL(":id"), q.value(1).toInt());
+            q.finish();
+
+            result = purge_messages(QSL("(date_created < :date_created OR (date_created = :date_created_same AND id <= :id))"),
+                                    values);
+        }
+    }
+
+    if (!result) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to apply retention policy to feed '" << feed_custom_id << "': '"
+                   << q.lastError().text() << "'.";
+    }
+
+    if (ok != nullptr) {
+        *ok = result;
+    }
+
+    return removed;
+}
+
 bool DatabaseQueries::deleteFeed(const QSqlDatabase &db, int feed_custom_id, int account_id)
 {
     QSqlQuery q(db);
@@ -1338,15 +2465,22 @@ bool DatabaseQueries::deleteFeed(const QSqlDatabase &db, int feed_custom_id, int
     q.bindValue(QSL(":feed"), feed_custom_id);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
+        return false;
+    }
+
+    if (!deleteMessages(db, QSL("feed = :feed AND account_id = :account_id"),
+                        { { QSL(":feed"), feed_custom_id }, { QSL(":account_id"), account_id } })) {
         return false;
     }
 
-    q.prepare(QSL("DELETE FROM Messages WHERE feed = :feed AND account_id = :account_id;"));
+    q.prepare(QSL("DELETE FROM RetentionPolicies "
+                  "WHERE item_kind = :item_kind AND custom_id = :feed AND account_id = :account_id;"));
+    q.bindValue(QSL(":item_kind"), int(RootItem::Kind::Feed));
     q.bindValue(QSL(":feed"), feed_custom_id);
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
         return false;
     }
 
@@ -1354,18 +2488,29 @@ bool DatabaseQueries::deleteFeed(const QSqlDatabase &db, int feed_custom_id, int
     q.prepare(QSL("DELETE FROM Feeds WHERE custom_id = :feed AND account_id = :account_id;"));
     q.bindValue(QSL(":feed"), feed_custom_id);
     q.bindValue(QSL(":account_id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::deleteStandardCategory(const QSqlDatabase &db, int id)
 {
     QSqlQuery q(db);
 
-    // Remove this category from database.
     q.setForwardOnly(true);
+    q.prepare(QSL("DELETE FROM RetentionPolicies "
+                  "WHERE item_kind = :item_kind AND custom_id = :custom_id AND "
+                  "account_id = (SELECT account_id FROM Categories WHERE id = :category);"));
+    q.bindValue(QSL(":item_kind"), int(RootItem::Kind::Category));
+    q.bindValue(QSL(":custom_id"), QString::number(id));
+    q.bindValue(QSL(":category"), id);
+
+    if (!DB_EXEC(q)) {
+        return false;
+    }
+
+    // Remove this category from database.
     q.prepare(QSL("DELETE FROM Categories WHERE id = :category;"));
     q.bindValue(QSL(":category"), id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 int DatabaseQueries::addStandardCategory(const QSqlDatabase &db, int parent_id, int account_id,
@@ -1377,16 +2522,16 @@ int DatabaseQueries::addStandardCategory(const QSqlDatabase &db, int parent_id,
 
     q.setForwardOnly(true);
     q.prepare("INSERT INTO Categories "
-              "(parent_id, title, description, date_created, icon, account_id) "
-              "VALUES (:parent_id, :title, :description, :date_created, :icon, :account_id);");
+              "(parent_id, title, description, date_created, icon_id, account_id) "
+              "VALUES (:parent_id, :title, :description, :date_created, :icon_id, :account_id);");
     q.bindValue(QSL(":parent_id"), parent_id);
     q.bindValue(QSL(":title"), title);
     q.bindValue(QSL(":description"), description);
     q.bindValue(QSL(":date_created"), creation_date.toMSecsSinceEpoch());
-    q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+    q.bindValue(QSL(":icon_id"), storeIcon(db, icon));
     q.bindValue(QSL(":account_id"), account_id);
 
-    if (!q.exec()) {
+    if (!DB_EXEC(q)) {
         qDebugNN << LOGSEC_DB
                  << "Failed to add category to database: '"
                  << q.lastError().text()
@@ -1409,7 +2554,7 @@ int DatabaseQueries::addStandardCategory(const QSqlDatabase &db, int parent_id,
         q.prepare(QSL("UPDATE Categories SET custom_id = :custom_id WHERE id = :id;"));
         q.bindValue(QSL(":custom_id"), QString::number(new_id));
         q.bindValue(QSL(":id"), new_id);
-        q.exec();
+        DB_EXEC(q);
         return new_id;
     }
 }
@@ -1421,14 +2566,14 @@ bool DatabaseQueries::editStandardCategory(const QSqlDatabase &db, int parent_id
 
     q.setForwardOnly(true);
     q.prepare("UPDATE Categories "
-              "SET title = :title, description = :description, icon = :icon, parent_id = :parent_id "
+              "SET title = :title, description = :description, icon = NULL, icon_id = :icon_id, parent_id = :parent_id "
               "WHERE id = :id;");
     q.bindValue(QSL(":title"), title);
     q.bindValue(QSL(":description"), description);
-    q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+    q.bindValue(QSL(":icon_id"), storeIcon(db, icon));
     q.bindValue(QSL(":parent_id"), parent_id);
     q.bindValue(QSL(":id"), category_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 int DatabaseQueries::addStandardFeed(const QSqlDatabase &db, int parent_id, int account_id,
@@ -1444,12 +2589,12 @@ int DatabaseQueries::addStandardFeed(const QSqlDatabase &db, int parent_id, int
     qDebug() << "Adding feed with title '" << title.toUtf8() << "' to DB.";
     q.setForwardOnly(true);
     q.prepare("INSERT INTO Feeds "
-              "(title, description, date_created, icon, category, encoding, url, protected, username, password, update_type, update_interval, type, account_id) "
-              "VALUES (:title, :description, :date_created, :icon, :category, :encoding, :url, :protected, :username, :password, :update_type, :update_interval, :type, :account_id);");
+              "(title, description, date_created, icon_id, category, encoding, url, protected, username, password, update_type, update_interval, type, account_id) "
+              "VALUES (:title, :description, :date_created, :icon_id, :category, :encoding, :url, :protected, :username, :password, :update_type, :update_interval, :type, :account_id);");
     q.bindValue(QSL(":title"), title.toUtf8());
     q.bindValue(QSL(":description"), description.toUtf8());
     q.bindValue(QSL(":date_created"), creation_date.toMSecsSinceEpoch());
-    q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+    q.bindValue(QSL(":icon_id"), storeIcon(db, icon));
     q.bindValue(QSL(":category"), parent_id);
     q.bindValue(QSL(":encoding"), encoding);
     q.bindValue(QSL(":url"), url);
@@ -1467,14 +2612,14 @@ int DatabaseQueries::addStandardFeed(const QSqlDatabase &db, int parent_id, int
     q.bindValue(QSL(":update_interval"), auto_update_interval);
     q.bindValue(QSL(":type"), int(feed_format));
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         int new_id = q.lastInsertId().toInt();
 
         // Now set custom ID in the DB.
         q.prepare(QSL("UPDATE Feeds SET custom_id = :custom_id WHERE id = :id;"));
         q.bindValue(QSL(":custom_id"), QString::number(new_id));
         q.bindValue(QSL(":id"), new_id);
-        q.exec();
+        DB_EXEC(q);
 
         if (ok != nullptr) {
             *ok = true;
@@ -1494,6 +2639,90 @@ int DatabaseQueries::addStandardFeed(const QSqlDatabase &db, int parent_id, int
     }
 }
 
+bool DatabaseQueries::addStandardItem(const QSqlDatabase &db, RootItem *item, int parent_id, int account_id)
+{
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+
+    // Failed item is rolled back to its savepoint, so that
+    // other items stored in the same transaction are kept.
+    if (!DB_EXEC_SQL(q, QSL("SAVEPOINT StandardItem;"))) {
+        return false;
+    }
+
+    DatabaseFactory *factory = qApp->database();
+    QSqlQuery q_item, q_id;
+
+    if (item->kind() == RootItem::Kind::Category) {
+        q_item = factory->preparedQuery(db, QSL("addStandardItemCategory"),
+                                        QSL("INSERT INTO Categories "
+                                            "(parent_id, title, description, date_created, icon_id, account_id) "
+                                            "VALUES (:parent_id, :title, :description, :date_created, :icon_id, :account_id);"));
+        q_id = factory->preparedQuery(db, QSL("addStandardItemCategoryId"),
+                                      QSL("UPDATE Categories SET custom_id = :custom_id WHERE id = :id;"));
+        q_item.bindValue(QSL(":parent_id"), parent_id);
+        q_item.bindValue(QSL(":title"), item->title());
+        q_item.bindValue(QSL(":description"), item->description());
+        q_item.bindValue(QSL(":date_created"), item->creationDate().toMSecsSinceEpoch());
+        q_item.bindValue(QSL(":icon_id"), storeIcon(db, item->icon()));
+        q_item.bindValue(QSL(":account_id"), account_id);
+    } else {
+        auto *feed = qobject_cast<StandardFeed *>(item);
+
+        q_item = factory->preparedQuery(db, QSL("addStandardItemFeed"),
+                                        QSL("INSERT INTO Feeds "
+                                            "(title, description, date_created, icon_id, category, encoding, url, protected, username, password, update_type, update_interval, type, account_id) "
+                                            "VALUES (:title, :description, :date_created, :icon_id, :category, :encoding, :url, :protected, :username, :password, :update_type, :update_interval, :type, :account_id);"));
+        q_id = factory->preparedQuery(db, QSL("addStandardItemFeedId"),
+                                      QSL("UPDATE Feeds SET custom_id = :custom_id WHERE id = :id;"));
+        q_item.bindValue(QSL(":title"), feed->title());
+        q_item.bindValue(QSL(":description"), feed->description());
+        q_item.bindValue(QSL(":date_created"), feed->creationDate().toMSecsSinceEpoch());
+        q_item.bindValue(QSL(":icon_id"), storeIcon(db, feed->icon()));
+        q_item.bindValue(QSL(":category"), parent_id);
+        q_item.bindValue(QSL(":encoding"), feed->encoding());
+        q_item.bindValue(QSL(":url"), feed->url());
+        q_item.bindValue(QSL(":protected"), feed->passwordProtected() ? 1 : 0);
+        q_item.bindValue(QSL(":username"), feed->username());
+        q_item.bindValue(QSL(":password"), feed->password().isEmpty()
+                         ? feed->password()
+                         : TextFactory::encrypt(feed->password()));
+        q_item.bindValue(QSL(":update_type"), int(feed->autoUpdateType()));
+        q_item.bindValue(QSL(":update_interval"), feed->autoUpdateInitialInterval());
+        q_item.bindValue(QSL(":type"), int(feed->type()));
+        q_item.bindValue(QSL(":account_id"), account_id);
+    }
+
+    QSqlQuery *failed_query = nullptr;
+
+    if (DB_EXEC(q_item)) {
+        item->setId(q_item.lastInsertId().toInt());
+        q_id.bindValue(QSL(":custom_id"), QString::number(item->id()));
+        q_id.bindValue(QSL(":id"), item->id());
+
+        if (!DB_EXEC(q_id)) {
+            failed_query = &q_id;
+        }
+    } else {
+        failed_query = &q_item;
+    }
+
+    if (failed_query != nullptr) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to store feed/category '" << item->title() << "': '"
+                   << failed_query->lastError().text()
+                   << "'.";
+        DB_EXEC_SQL(q, QSL("ROLLBACK TO SAVEPOINT StandardItem;"));
+    }
+
+    q_item.finish();
+    q_id.finish();
+    DB_EXEC_SQL(q, QSL("RELEASE SAVEPOINT StandardItem;"));
+
+    return failed_query == nullptr;
+}
+
 bool DatabaseQueries::editStandardFeed(const QSqlDatabase &db, int parent_id, int feed_id,
                                        const QString &title,
                                        const QString &description, const QIcon &icon,
@@ -1506,11 +2735,11 @@ bool DatabaseQueries::editStandardFeed(const QSqlDatabase &db, int parent_id, in
 
     q.setForwardOnly(true);
     q.prepare("UPDATE Feeds "
-              "SET title = :title, description = :description, icon = :icon, category = :category, encoding = :encoding, url = :url, protected = :protected, username = :username, password = :password, update_type = :update_type, update_interval = :update_interval, type = :type "
+              "SET title = :title, description = :description, icon = NULL, icon_id = :icon_id, category = :category, encoding = :encoding, url = :url, protected = :protected, username = :username, password = :password, update_type = :update_type, update_interval = :update_interval, type = :type "
               "WHERE id = :id;");
     q.bindValue(QSL(":title"), title);
     q.bindValue(QSL(":description"), description);
-    q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+    q.bindValue(QSL(":icon_id"), storeIcon(db, icon));
     q.bindValue(QSL(":category"), parent_id);
     q.bindValue(QSL(":encoding"), encoding);
     q.bindValue(QSL(":url"), url);
@@ -1528,7 +2757,7 @@ bool DatabaseQueries::editStandardFeed(const QSqlDatabase &db, int parent_id, in
     q.bindValue(QSL(":type"), int(feed_format));
     q.bindValue(QSL(":id"), feed_id);
 
-    bool suc = q.exec();
+    bool suc = DB_EXEC(q);
 
     if (!suc) {
         qWarningNN << LOGSEC_DB
@@ -1553,7 +2782,7 @@ bool DatabaseQueries::editBaseFeed(const QSqlDatabase &db, int feed_id,
     q.bindValue(QSL(":update_type"), (int) auto_update_type);
     q.bindValue(QSL(":update_interval"), auto_update_interval);
     q.bindValue(QSL(":id"), feed_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 MessageFilter *DatabaseQueries::addMessageFilter(const QSqlDatabase &db, const QString &title,
@@ -1572,7 +2801,7 @@ MessageFilter *DatabaseQueries::addMessageFilter(const QSqlDatabase &db, const Q
     q.bindValue(QSL(":script"), script);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         auto *fltr = new MessageFilter(q.lastInsertId().toInt());
 
         fltr->setName(title);
@@ -1593,7 +2822,7 @@ void DatabaseQueries::removeMessageFilter(const QSqlDatabase &db, int filter_id,
     q.bindValue(QSL(":id"), filter_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1614,7 +2843,7 @@ void DatabaseQueries::removeMessageFilterAssignments(const QSqlDatabase &db, int
     q.bindValue(QSL(":filter"), filter_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1633,7 +2862,7 @@ QList<MessageFilter *> DatabaseQueries::getMessageFilters(const QSqlDatabase &db
     q.setForwardOnly(true);
     q.prepare(QSL("SELECT * FROM MessageFilters;"));
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             auto rec = q.record();
             auto *filter = new MessageFilter(rec.value(0).toInt());
@@ -1667,7 +2896,7 @@ QMultiMap<QString, int> DatabaseQueries::messageFiltersInFeeds(const QSqlDatabas
     q.bindValue(QSL(":account_id"), account_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             auto rec = q.record();
 
@@ -1700,7 +2929,7 @@ void DatabaseQueries::assignMessageFilterToFeed(const QSqlDatabase &db,
     q.bindValue(QSL(":account_id"), account_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1711,18 +2940,19 @@ void DatabaseQueries::assignMessageFilterToFeed(const QSqlDatabase &db,
     }
 }
 
-void DatabaseQueries::updateMessageFilter(const QSqlDatabase &db, MessageFilter *filter, bool *ok)
+void DatabaseQueries::updateMessageFilter(const QSqlDatabase &db, int filter_id, const QString &name,
+                                          const QString &script, bool *ok)
 {
     QSqlQuery q(db);
 
     q.prepare("UPDATE MessageFilters SET name = :name, script = :script WHERE id = :id;");
 
-    q.bindValue(QSL(":name"), filter->name());
-    q.bindValue(QSL(":script"), filter->script());
-    q.bindValue(QSL(":id"), filter->id());
+    q.bindValue(QSL(":name"), name);
+    q.bindValue(QSL(":script"), script);
+    q.bindValue(QSL(":id"), filter_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1747,7 +2977,7 @@ void DatabaseQueries::removeMessageFilterFromFeed(const QSqlDatabase &db,
     q.bindValue(QSL(":account_id"), account_id);
     q.setForwardOnly(true);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         if (ok != nullptr) {
             *ok = true;
         }
@@ -1767,7 +2997,7 @@ QList<ServiceRoot *> DatabaseQueries::getStandardAccounts(const QSqlDatabase &db
     q.prepare(QSL("SELECT id FROM Accounts WHERE type = :type;"));
     q.bindValue(QSL(":type"), SERVICE_CODE_STD_RSS);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         while (q.next()) {
             auto *root = new StandardServiceRoot();
 
@@ -1795,7 +3025,7 @@ bool DatabaseQueries::deleteTtRssAccount(const QSqlDatabase &db, int account_id)
     q.prepare(QSL("DELETE FROM TtRssAccounts WHERE id = :id;"));
     q.bindValue(QSL(":id"), account_id);
 
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::overwriteTtRssAccount(const QSqlDatabase &db, const QString &username,
@@ -1821,7 +3051,7 @@ bool DatabaseQueries::overwriteTtRssAccount(const QSqlDatabase &db, const QStrin
     q.bindValue(QSL(":update_only_unread"), download_only_unread_messages ? 1 : 0);
     q.bindValue(QSL(":id"), account_id);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         return true;
     } else {
         qWarningNN << LOGSEC_TTRSS
@@ -1852,7 +3082,7 @@ bool DatabaseQueries::createTtRssAccount(const QSqlDatabase &db, int id_to_assig
     q.bindValue(QSL(":force_update"), force_server_side_feed_update ? 1 : 0);
     q.bindValue(QSL(":update_only_unread"), download_only_unread_messages ? 1 : 0);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         return true;
     } else {
         qWarningNN << LOGSEC_TTRSS
@@ -1874,7 +3104,7 @@ QStringList DatabaseQueries::getAllRecipients(const QSqlDatabase &db, int accoun
                       "ORDER BY lower(author) ASC;"));
     query.bindValue(QSL(":account_id"), account_id);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         while (query.next()) {
             rec.append(query.value(0).toString());
         }
@@ -1891,7 +3121,7 @@ QList<ServiceRoot *> DatabaseQueries::getGmailAccounts(const QSqlDatabase &db, b
     QSqlQuery query(db);
     QList<ServiceRoot *> roots;
 
-    if (query.exec("SELECT * FROM GmailAccounts;")) {
+    if (DB_EXEC_SQL(query, "SELECT * FROM GmailAccounts;")) {
         while (query.next()) {
             auto *root = new GmailServiceRoot(nullptr);
 
@@ -1931,7 +3161,7 @@ bool DatabaseQueries::deleteGmailAccount(const QSqlDatabase &db, int account_id)
     q.setForwardOnly(true);
     q.prepare(QSL("DELETE FROM GmailAccounts WHERE id = :id;"));
     q.bindValue(QSL(":id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::storeNewGmailTokens(const QSqlDatabase &db, const QString &refresh_token,
@@ -1945,7 +3175,7 @@ bool DatabaseQueries::storeNewGmailTokens(const QSqlDatabase &db, const QString
     query.bindValue(QSL(":refresh_token"), refresh_token);
     query.bindValue(QSL(":id"), account_id);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         return true;
     } else {
         qWarningNN << LOGSEC_GMAIL
@@ -1963,7 +3193,7 @@ bool DatabaseQueries::deleteInoreaderAccount(const QSqlDatabase &db, int account
     q.setForwardOnly(true);
     q.prepare(QSL("DELETE FROM InoreaderAccounts WHERE id = :id;"));
     q.bindValue(QSL(":id"), account_id);
-    return q.exec();
+    return DB_EXEC(q);
 }
 
 bool DatabaseQueries::storeNewInoreaderTokens(const QSqlDatabase &db, const QString &refresh_token,
@@ -1977,7 +3207,7 @@ bool DatabaseQueries::storeNewInoreaderTokens(const QSqlDatabase &db, const QStr
     query.bindValue(QSL(":refresh_token"), refresh_token);
     query.bindValue(QSL(":id"), account_id);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         return true;
     } else {
         qWarningNN << LOGSEC_INOREADER
@@ -1993,7 +3223,7 @@ QList<ServiceRoot *> DatabaseQueries::getInoreaderAccounts(const QSqlDatabase &d
     QSqlQuery query(db);
     QList<ServiceRoot *> roots;
 
-    if (query.exec("SELECT * FROM InoreaderAccounts;")) {
+    if (DB_EXEC_SQL(query, "SELECT * FROM InoreaderAccounts;")) {
         while (query.next()) {
             auto *root = new InoreaderServiceRoot(nullptr);
 
@@ -2045,7 +3275,7 @@ bool DatabaseQueries::overwriteGmailAccount(const QSqlDatabase &db, const QStrin
     query.bindValue(QSL(":id"), account_id);
     query.bindValue(QSL(":msg_limit"), batch_size <= 0 ? GMAIL_DEFAULT_BATCH_SIZE : batch_size);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         return true;
     } else {
         qWarningNN << LOGSEC_GMAIL
@@ -2073,7 +3303,7 @@ bool DatabaseQueries::createGmailAccount(const QSqlDatabase &db, int id_to_assig
     q.bindValue(QSL(":refresh_token"), refresh_token);
     q.bindValue(QSL(":msg_limit"), batch_size <= 0 ? GMAIL_DEFAULT_BATCH_SIZE : batch_size);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         return true;
     } else {
         qWarningNN << LOGSEC_GMAIL
@@ -2103,7 +3333,7 @@ bool DatabaseQueries::overwriteInoreaderAccount(const QSqlDatabase &db, const QS
     query.bindValue(QSL(":id"), account_id);
     query.bindValue(QSL(":msg_limit"), batch_size <= 0 ? INOREADER_DEFAULT_BATCH_SIZE : batch_size);
 
-    if (query.exec()) {
+    if (DB_EXEC(query)) {
         return true;
     } else {
         qWarningNN << LOGSEC_INOREADER
@@ -2131,7 +3361,7 @@ bool DatabaseQueries::createInoreaderAccount(const QSqlDatabase &db, int id_to_a
     q.bindValue(QSL(":refresh_token"), refresh_token);
     q.bindValue(QSL(":msg_limit"), batch_size <= 0 ? INOREADER_DEFAULT_BATCH_SIZE : batch_size);
 
-    if (q.exec()) {
+    if (DB_EXEC(q)) {
         return true;
     } else {
         qWarningNN << LOGSEC_INOREADER
@@ -2146,3 +3376,78 @@ QString DatabaseQueries::unnulifyString(const QString &str)
 {
     return str.isNull() ? "" : str;
 }
+
+bool DatabaseQueries::beginTransaction(QSqlDatabase &db, bool *own_transaction)
+{
+    *own_transaction = !qApp->database()->writer()->isRunningJob() &&
+                       db.driver()->hasFeature(QSqlDriver::Transactions);
+
+    if (*own_transaction && !db.transaction()) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to start transaction: '"
+                   << db.lastError().text()
+                   << "'.";
+        return false;
+    }
+
+    return true;
+}
+
+bool DatabaseQueries::deleteMessages(const QSqlDatabase &db, const QString &condition,
+                                     const QMap<QString, QVariant> &values)
+{
+    QSqlDatabase database = db;
+    QSqlQuery q(db);
+
+    q.setForwardOnly(true);
+    q.prepare(QSL("DELETE FROM Messages WHERE %1;").arg(condition));
+
+    for (auto i = values.constBegin(); i != values.constEnd(); ++i) {
+        q.bindValue(i.key(), i.value());
+    }
+
+    // Triggers remove index entries of messages with plain contents.
+    bool own_transaction;
+    bool result = beginTransaction(database, &own_transaction) &&
+                  changeFulltextEntries(db, QSL("(%1) AND %2").arg(condition, compressedContentsCondition()), values,
+                                        FulltextEntry::Whole, FulltextEntry::None) &&
+                  DB_EXEC(q);
+
+    if (!result) {
+        qWarningNN << LOGSEC_DB
+                   << "Removing of messages failed: '"
+                   << q.lastError().text()
+                   << "'.";
+    }
+
+    if (own_transaction) {
+        if (result && database.commit()) {
+            return true;
+        }
+
+        database.rollback();
+        return false;
+    }
+
+    return result;
+}
+
+QString DatabaseQueries::ftsMatchExpression(const QString &phrase)
+{
+    const QString simplified = phrase.simplified();
+
+    if (simplified.isEmpty()) {
+        return QString();
+    }
+
+    QStringList terms;
+
+    // Each term is quoted so that user input is never parsed as FTS5 query syntax.
+    for (QString term : simplified.split(QL1C(' '))) {
+        terms.append(QSL("\"%1\"").arg(term.replace(QL1C('"'), QSL("\"\""))));
+    }
+
+    // Last term is matched as prefix, so that results follow what user is typing.
+    terms.last().append(QL1C('*'));
+    return terms.join(QL1C(' '));
+}
@@ -6,6 +6,7 @@
 #include "services/abstract/rootitem.h"
 
 #include "core/messagefilter.h"
+#include "core/retentionpolicy.h"
 #include "services/abstract/category.h"
 #include "services/abstract/serviceroot.h"
 #include "services/standard/standardfeed.h"
@@ -14,10 +15,24 @@
 #include <QSqlError>
 #include <QSqlQuery>
 
+#include <functional>
+
 class DatabaseQueries
 {
 public:
 
+    // Reports progress of storing of multiple feeds/categories, it is called after each
+    // stored item. Storing is cancelled and rolled back if false is returned.
+    using StoreProgress = std::function<bool(int stored_count, int total_count)>;
+
+    // State of message in SQLite full-text index, its entry contains nothing,
+    // only title and author of message or its title, author and contents.
+    enum class FulltextEntry {
+        None,
+        Headers,
+        Whole
+    };
+
     // Message operators.
     static bool markImportantMessagesReadUnread(const QSqlDatabase &db, int account_id,
             RootItem::ReadStatus read);
@@ -43,6 +58,14 @@ public:
     static bool purgeMessagesFromBin(const QSqlDatabase &db, bool clear_only_read, int account_id);
     static bool purgeLeftoverMessages(const QSqlDatabase &db, int account_id);
 
+    // Compression of stored message contents.
+    // Compresses next batch of messages with ID greater than "last_id" and moves "last_id"
+    // past processed messages. Returns count of processed messages, zero when all is done.
+    static int compressMessageContents(QSqlDatabase db, int *last_id, int batch_size, bool *ok = nullptr);
+
+    // Returns total size of plain (first) and compressed (second) message contents.
+    static QPair<qint64, qint64> getMessageContentsSize(const QSqlDatabase &db, bool *ok = nullptr);
+
     // Counts of unread/all messages.
     static QMap<QString, QPair<int, int>> getMessageCountsForCategory(const QSqlDatabase &db,
                                        const QString &custom_id,
@@ -59,6 +82,50 @@ public:
     static int getMessageCountsForBin(const QSqlDatabase &db, int account_id,
                                       bool including_total_counts, bool *ok = nullptr);
 
+    // Returns counts of messages of all feeds of all accounts, grouped
+    // by account ID and then by feed custom ID.
+    static QHash<int, QHash<QString, MessageCounts>> getMessageCountsForAllAccounts(const QSqlDatabase &db,
+                                                                                  bool *ok = nullptr);
+
+    // Full-text search, returns IDs of matching messages ordered by relevance.
+    // Search is limited to given account and feeds when they are specified.
+    static QList<int> searchMessages(const QSqlDatabase &db, const QString &phrase,
+                                     int account_id, const QStringList &feed_custom_ids,
+                                     int limit, int offset, bool include_archive = false, bool *ok = nullptr);
+
+    // Returns SQL condition which limits message list to messages matching given phrase,
+    // condition is empty when there is nothing to search for.
+    static QString searchCondition(const QSqlDatabase &db, const QString &phrase, bool include_archive);
+
+    // Triggers keep full-text index in sync only for plain contents, entries of messages with
+    // compressed contents are changed by application. Given condition can use columns
+    // of "Messages" and "MessageBodies" in given schema, for example "archive.".
+    // NOTE: MySQL indexes are maintained by MySQL itself, so this does nothing for MySQL.
+    static bool changeFulltextEntries(const QSqlDatabase &db, const QString &condition,
+                                      const QMap<QString, QVariant> &values, FulltextEntry from,
+                                      FulltextEntry to, const QString &schema = QString());
+
+    // Returns SQL condition which matches messages with compressed contents.
+    static QString compressedContentsCondition();
+
+    // Indexes all messages in given schema again.
+    static bool rebuildFulltextIndex(const QSqlDatabase &db, const QString &schema = QString());
+
+    // Fills temporary table with given name with IDs of messages, IDs are bound
+    // in chunks so that any count of them can be stored with short statements.
+    // NOTE: Temporary tables are private to connection, so connection
+    // must stay the same until statements which use the table run.
+    static bool storeMessageIds(const QSqlDatabase &db, const QString &table,
+                                const QStringList &ids, QSqlError *error = nullptr);
+
+    // Returns name of archive table which corresponds to given working table.
+    static QString archivedTable(const QSqlDatabase &db, const QString &table);
+
+    // Moves batch of old messages to archive, returns count of moved messages.
+    // Starred messages and messages in recycle bin are never archived.
+    // NOTE: Call this inside transaction.
+    static int archiveMessages(const QSqlDatabase &db, int older_than_days, int batch_size, bool *ok = nullptr);
+
     // Get messages (for newspaper view for example).
     static QList<Message> getUndeletedImportantMessages(const QSqlDatabase &db,
             int account_id,
@@ -72,6 +139,10 @@ public:
     static QList<Message> getUndeletedMessagesForAccount(const QSqlDatabase &db, int account_id,
             bool *ok = nullptr);
 
+    // Loads contents and enclosures of message, which are not
+    // part of message list queries.
+    static void fillMessageBody(const QSqlDatabase &db, Message *message, bool *ok = nullptr);
+
     // Custom ID accumulators.
     static QStringList customIdsOfImportantMessages(const QSqlDatabase &db, int account_id,
             bool *ok = nullptr);
@@ -82,6 +153,8 @@ public:
     static QStringList customIdsOfMessagesFromFeed(const QSqlDatabase &db,
             const QString &feed_custom_id, int account_id,
             bool *ok = nullptr);
+    static QStringList customIdsOfMessages(const QSqlDatabase &db, const QStringList &ids,
+                                           bool *ok = nullptr);
 
     // Common account methods.
     static int createAccount(const QSqlDatabase &db, const QString &code, bool *ok = nullptr);
@@ -93,10 +166,21 @@ public:
     static bool cleanImportantMessages(const QSqlDatabase &db, bool clean_read_only, int account_id);
     static bool cleanFeeds(const QSqlDatabase &db, const QStringList &ids, bool clean_read_only,
                            int account_id);
-    static bool storeAccountTree(const QSqlDatabase &db, RootItem *tree_root, int account_id);
+    static bool storeAccountTree(const QSqlDatabase &db, RootItem *tree_root, int account_id,
+                                 const StoreProgress &progress = nullptr);
     static bool editBaseFeed(const QSqlDatabase &db, int feed_id, Feed::AutoUpdateType auto_update_type,
                              int auto_update_interval);
 
+    // Icon store. Each distinct icon is stored only once and
+    // feeds/categories refer to it via its ID.
+    // Returns ID of stored icon or null value for empty icon.
+    static QVariant storeIcon(const QSqlDatabase &db, const QIcon &icon);
+    static QHash<int, QByteArray> getIcons(const QSqlDatabase &db, bool *ok = nullptr);
+
+    // Moves icons stored inline by older versions to icon store.
+    static bool migrateLegacyIcons(const QSqlDatabase &db);
+    static bool purgeUnusedIcons(const QSqlDatabase &db);
+
     template<typename T>
     static Assignment getCategories(const QSqlDatabase &db, int account_id, bool *ok = nullptr);
 
@@ -117,11 +201,24 @@ public:
     static void assignMessageFilterToFeed(const QSqlDatabase &db, const QString &feed_custom_id,
                                           int filter_id,
                                           int account_id, bool *ok = nullptr);
-    static void updateMessageFilter(const QSqlDatabase &db, MessageFilter *filter, bool *ok = nullptr);
+    static void updateMessageFilter(const QSqlDatabase &db, int filter_id, const QString &name,
+                                    const QString &script, bool *ok = nullptr);
     static void removeMessageFilterFromFeed(const QSqlDatabase &db, const QString &feed_custom_id,
                                             int filter_id,
                                             int account_id, bool *ok = nullptr);
 
+    // Retention policies. Empty policy is not stored, item then
+    // uses policy of its parent category.
+    static RetentionPolicy getRetentionPolicy(const QSqlDatabase &db, RootItem::Kind item_kind,
+                                              const QString &custom_id, int account_id, bool *ok = nullptr);
+    static void storeRetentionPolicy(const QSqlDatabase &db, RootItem::Kind item_kind,
+                                     const QString &custom_id, int account_id,
+                                     const RetentionPolicy &policy, bool *ok = nullptr);
+
+    // Purges messages of given feed which exceed the policy, returns count of purged messages.
+    static int applyRetentionPolicy(const QSqlDatabase &db, const QString &feed_custom_id, int account_id,
+                                    const RetentionPolicy &policy, bool *ok = nullptr);
+
     // Standard account.
     static bool deleteFeed(const QSqlDatabase &db, int feed_custom_id, int account_id);
     static bool deleteStandardCategory(const QSqlDatabase &db, int id);
@@ -137,6 +234,10 @@ public:
                                const QString &username, const QString &password,
                                Feed::AutoUpdateType auto_update_type,
                                int auto_update_interval, StandardFeed::Type feed_format, bool *ok = nullptr);
+
+    // Stores given standard category/feed within its own savepoint, so that failed item
+    // does not affect other items stored in the same transaction. ID of stored item is set.
+    static bool addStandardItem(const QSqlDatabase &db, RootItem *item, int parent_id, int account_id);
     static bool editStandardFeed(const QSqlDatabase &db, int parent_id, int feed_id,
                                  const QString &title,
                                  const QString &description, const QIcon &icon,
@@ -203,6 +304,27 @@ public:
 
 private:
     static QString unnulifyString(const QString &str);
+    static QString ftsMatchExpression(const QString &phrase);
+
+    // Starts transaction unless calling thread runs job of database writer, whose
+    // transaction then already covers all changes. Returns false if transaction
+    // could not be started.
+    static bool beginTransaction(QSqlDatabase &db, bool *own_transaction);
+
+    // Deletes messages which match given condition together with
+    // full-text index entries of their compressed contents.
+    static bool deleteMessages(const QSqlDatabase &db, const QString &condition,
+                               const QMap<QString, QVariant> &values = QMap<QString, QVariant>());
+
+    // Runs given statement for messages with given IDs. IDs are bound in chunks into
+    // temporary table which replaces "%1" placeholder in the statement, so
+    // that statement stays short no matter how many messages are there.
+    static bool updateMessagesInBulk(const QSqlDatabase &db, const QStringList &ids, const QString &statement);
+
+    // Returns ID for next new message, it is higher than IDs of all working and archived
+    // messages. Databases would otherwise reuse ID of removed message with highest ID,
+    // which could collide with archived message. Returns 0 if ID cannot be obtained.
+    static qint64 nextMessageId(const QSqlDatabase &db, bool include_archive);
 
     explicit DatabaseQueries() = default;
 };
@@ -0,0 +1,233 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#include "miscellaneous/databasewriter.h"
+
+#include "miscellaneous/application.h"
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QSqlQuery>
+
+DatabaseWriter::DatabaseWriter(QObject *parent)
+    : QThread(parent), m_busy(false), m_stopped(false)
+{
+    setObjectName(QSL("DatabaseWriter"));
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+    stop();
+}
+
+QFuture<bool> DatabaseWriter::enqueue(const Job &job)
+{
+    Command command;
+
+    command.m_job = job;
+    command.m_result.reportStarted();
+
+    const QFuture<bool> future = command.m_result.future();
+
+    if (isWriterThread()) {
+        // Job queued by other job, it simply becomes part of running transaction.
+        const bool result = runJob(qApp->database()->connection(objectName()), job);
+
+        command.m_result.reportResult(result);
+        command.m_result.reportFinished();
+        return future;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_stopped) {
+        locker.unlock();
+
+        QList<Command> commands;
+
+        commands.append(command);
+        commit(qApp->database()->connection(objectName() + QSL("Direct")), commands);
+        return future;
+    }
+
+    m_queue.enqueue(command);
+
+    if (!isRunning()) {
+        start();
+    }
+
+    m_jobQueued.wakeOne();
+    return future;
+}
+
+void DatabaseWriter::flush()
+{
+    if (isWriterThread()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    while (isRunning() && (m_busy || !m_queue.isEmpty())) {
+        m_jobsCommitted.wait(&m_mutex);
+    }
+}
+
+void DatabaseWriter::stop()
+{
+    m_mutex.lock();
+    m_stopped = true;
+    m_jobQueued.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+}
+
+bool DatabaseWriter::isWriterThread() const
+{
+    return QThread::currentThread() == this;
+}
+
+bool DatabaseWriter::isRunningJob() const
+{
+    return m_jobDepth.hasLocalData() && m_jobDepth.localData() > 0;
+}
+
+void DatabaseWriter::whenCommitted(const QFuture<bool> &write, QObject *context,
+                                   const std::function<void()> &action)
+{
+    // Caller may run in other thread than context object, so watcher is
+    // moved to thread of context and destroyed together with it.
+    auto *watcher = new QFutureWatcher<bool>();
+
+    watcher->moveToThread(context->thread());
+    connect(context, &QObject::destroyed, watcher, &QObject::deleteLater);
+    connect(watcher, &QFutureWatcher<bool>::finished, context, [watcher, action]() {
+        if (watcher->result()) {
+            action();
+        }
+
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(write);
+}
+
+void DatabaseWriter::run()
+{
+    qDebugNN << LOGSEC_DB << "Database writer started in thread: '" << QThread::currentThreadId() << "'.";
+
+    QSqlDatabase database = qApp->database()->connection(objectName());
+    QMutexLocker locker(&m_mutex);
+
+    forever {
+        while (m_queue.isEmpty() && !m_stopped) {
+            m_jobQueued.wait(&m_mutex);
+        }
+
+        if (m_queue.isEmpty()) {
+            break;
+        }
+
+        // Give other writes short time to arrive, so that
+        // they are committed in the same transaction.
+        QElapsedTimer window;
+
+        window.start();
+
+        while (!m_stopped && m_queue.size() < APP_DB_WRITER_MAX_BATCH) {
+            const qint64 remaining = APP_DB_WRITER_COMMIT_DELAY - window.elapsed();
+
+            if (remaining <= 0 || !m_jobQueued.wait(&m_mutex, ulong(remaining))) {
+                break;
+            }
+        }
+
+        QList<Command> commands;
+
+        while (!m_queue.isEmpty() && commands.size() < APP_DB_WRITER_MAX_BATCH) {
+            commands.append(m_queue.dequeue());
+        }
+
+        m_busy = true;
+        locker.unlock();
+
+        commit(database, commands);
+
+        locker.relock();
+        m_busy = false;
+
+        if (m_queue.isEmpty()) {
+            m_jobsCommitted.wakeAll();
+        }
+    }
+
+    m_jobsCommitted.wakeAll();
+    locker.unlock();
+
+    // Connection belongs to this thread, so it is removed
+    // together with its cached statements once thread ends.
+    database = QSqlDatabase();
+    qApp->database()->removeConnection(objectName());
+}
+
+void DatabaseWriter::commit(const QSqlDatabase &database, QList<Command> &commands)
+{
+    QSqlDatabase db = database;
+    QList<bool> results;
+    const bool in_transaction = db.transaction();
+
+    if (!in_transaction) {
+        qWarningNN << LOGSEC_DB
+                   << "Database writer failed to start transaction: '"
+                   << db.lastError().text() << "'.";
+    }
+
+    for (const Command &command : commands) {
+        results.append(runJob(database, command.m_job));
+    }
+
+    bool committed = true;
+
+    if (in_transaction && !db.commit()) {
+        qCriticalNN << LOGSEC_DB
+                    << "Database writer failed to commit " << commands.size() << " writes: '"
+                    << db.lastError().text() << "'.";
+        db.rollback();
+        committed = false;
+    } else {
+        qDebugNN << LOGSEC_DB << "Database writer committed " << commands.size() << " writes.";
+    }
+
+    for (int i = 0; i < commands.size(); i++) {
+        commands[i].m_result.reportResult(committed && results.at(i));
+        commands[i].m_result.reportFinished();
+    }
+}
+
+bool DatabaseWriter::runJob(const QSqlDatabase &database, const Job &job)
+{
+    // Each job has its own savepoint, so that changes of
+    // failed job can be undone without affecting other jobs.
+    const int depth = m_jobDepth.localData();
+    const QString savepoint = QSL("WriterJob%1").arg(depth);
+    QSqlQuery q(database);
+
+    q.setForwardOnly(true);
+    m_jobDepth.setLocalData(depth + 1);
+
+    const bool has_savepoint = q.exec(QSL("SAVEPOINT %1;").arg(savepoint));
+    const bool result = job(database);
+
+    if (has_savepoint) {
+        if (!result) {
+            q.exec(QSL("ROLLBACK TO SAVEPOINT %1;").arg(savepoint));
+        }
+
+        q.exec(QSL("RELEASE SAVEPOINT %1;").arg(savepoint));
+    }
+
+    m_jobDepth.setLocalData(depth);
+    return result;
+}
@@ -0,0 +1,81 @@
+// For license of this file, see <project-root-folder>/LICENSE.md.
+
+#ifndef DATABASEWRITER_H
+#define DATABASEWRITER_H
+
+#include <QThread>
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QQueue>
+#include <QSqlDatabase>
+#include <QThreadStorage>
+#include <QWaitCondition>
+
+#include <functional>
+
+// Performs all database writes in single dedicated thread.
+// Writes which arrive shortly one after another are committed
+// together in one transaction (group commit), so there are
+// less locks and less disk syncs. Each write runs in its own
+// savepoint, so failing write does not affect other ones.
+class DatabaseWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    // Write job, returns true if it succeeded.
+    // NOTE: Job runs inside transaction, it must not start its own.
+    using Job = std::function<bool(const QSqlDatabase &db)>;
+
+    explicit DatabaseWriter(QObject *parent = nullptr);
+    virtual ~DatabaseWriter();
+
+    // Queues job, returned future reports true once job
+    // succeeded and its transaction was committed.
+    QFuture<bool> enqueue(const Job &job);
+
+    // Waits until all queued jobs are committed.
+    void flush();
+
+    // Commits all queued jobs and stops the thread, jobs
+    // queued afterwards are performed directly in caller thread.
+    void stop();
+
+    bool isWriterThread() const;
+
+    // Returns true if calling thread currently runs some job,
+    // its changes are then part of writer's transaction.
+    bool isRunningJob() const;
+
+    // Calls given action in thread of given context object once write succeeded.
+    // NOTE: This can be called from any thread.
+    static void whenCommitted(const QFuture<bool> &write, QObject *context, const std::function<void()> &action);
+
+protected:
+    void run();
+
+private:
+    struct Command {
+        Job m_job;
+        QFutureInterface<bool> m_result;
+    };
+
+    void commit(const QSqlDatabase &database, QList<Command> &commands);
+    bool runJob(const QSqlDatabase &database, const Job &job);
+
+    QMutex m_mutex;
+    QWaitCondition m_jobQueued;
+    QWaitCondition m_jobsCommitted;
+    QQueue<Command> m_queue;
+    bool m_busy;
+    bool m_stopped;
+
+    // Count of currently nested jobs of each thread, used to name their savepoints.
+    // Jobs run in caller thread once writer is stopped, so count is per thread.
+    QThreadStorage<int> m_jobDepth;
+};
+
+#endif // DATABASEWRITER_H
@@ -10,6 +10,7 @@
 #include "gui/dialogs/formmessagefiltersmanager.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/mutex.h"
 #include "services/abstract/cacheforserviceroot.h"
 #include "services/abstract/serviceroot.h"
@@ -25,17 +26,49 @@
 
 FeedReader::FeedReader(QObject *parent)
     : QObject(parent),
-      m_autoUpdateTimer(new QTimer(this)), m_feedDownloader(nullptr)
+      m_autoUpdateTimer(new QTimer(this)), m_feedDownloader(nullptr), m_vacuumTimer(new QTimer(this)),
+      m_archiveTimer(new QTimer(this)), m_lastArchiveBatch(0)
 {
     m_feedsModel = new FeedsModel(this);
     m_feedsProxyModel = new FeedsProxyModel(m_feedsModel, this);
     m_messagesModel = new MessagesModel(this);
     m_messagesProxyModel = new MessagesProxyModel(m_messagesModel, this);
 
+    m_maintenance.setMaxThreadCount(1);
+    m_maintenance.setExpiryTimeout(-1);
+
     connect(m_autoUpdateTimer, &QTimer::timeout, this, &FeedReader::executeNextAutoUpdate);
+    connect(&m_contentsCompressionWatcher, &QFutureWatcher<bool>::finished, this, [this]() {
+        if (m_contentsCompressionWatcher.result()) {
+            qDebugNN << LOGSEC_DB << "All stored message contents are compressed now.";
+            qApp->settings()->setValue(GROUP(Database), Database::CompressContentsMigrated, true);
+        }
+    });
+    connect(m_vacuumTimer, &QTimer::timeout, this, &FeedReader::runIncrementalVacuum);
+    connect(m_archiveTimer, &QTimer::timeout, this, &FeedReader::archiveOldMessages);
+    connect(&m_archiveWatcher, &QFutureWatcher<bool>::finished, this, [this]() {
+        if (!m_archiveWatcher.result() || m_lastArchiveBatch <= 0) {
+            return;
+        }
+
+        m_feedsModel->reloadCountsOfWholeModel();
+
+        if (m_lastArchiveBatch >= MSG_ARCHIVE_BATCH_SIZE && m_archiveTimer->isActive()) {
+            // There are probably more messages to archive.
+            QTimer::singleShot(0, this, &FeedReader::archiveOldMessages);
+        }
+    });
     updateAutoUpdateStatus();
     asyncCacheSaveFinished();
 
+    m_vacuumTimer->setInterval(APP_DB_VACUUM_INTERVAL);
+    m_vacuumTimer->start();
+    m_archiveTimer->setInterval(APP_DB_ARCHIVE_INTERVAL);
+    m_archiveTimer->start();
+
+    // Let application start in peace, then continue with compression of stored messages.
+    QTimer::singleShot(30000, this, &FeedReader::compressStoredMessageContents);
+
     if (qApp->settings()->value(GROUP(Feeds), SETTING(Feeds::FeedsUpdateOnStartup)).toBool()) {
         qDebugNN << LOGSEC_CORE
                  << "Requesting update for all feeds on application startup.";
@@ -187,10 +220,19 @@ void FeedReader::removeMessageFilter(MessageFilter *filter)
     }
 
     // Remove from DB.
-    DatabaseQueries::removeMessageFilterAssignments(qApp->database()->connection(
-                metaObject()->className()), filter->id());
-    DatabaseQueries::removeMessageFilter(qApp->database()->connection(metaObject()->className()),
-                                         filter->id());
+    const int filter_id = filter->id();
+
+    qApp->database()->writer()->enqueue([filter_id](const QSqlDatabase &db) {
+        bool ok;
+
+        DatabaseQueries::removeMessageFilterAssignments(db, filter_id, &ok);
+
+        if (ok) {
+            DatabaseQueries::removeMessageFilter(db, filter_id, &ok);
+        }
+
+        return ok;
+    });
 
     // Free from memory as last step.
     filter->deleteLater();
@@ -198,27 +240,49 @@ void FeedReader::removeMessageFilter(MessageFilter *filter)
 
 void FeedReader::updateMessageFilter(MessageFilter *filter)
 {
-    DatabaseQueries::updateMessageFilter(qApp->database()->connection(metaObject()->className()),
-                                         filter);
+    // Filter is changed in this thread, so writer gets copy of its data.
+    const int filter_id = filter->id();
+    const QString name = filter->name();
+    const QString script = filter->script();
+
+    qApp->database()->writer()->enqueue([filter_id, name, script](const QSqlDatabase &db) {
+        bool ok;
+
+        DatabaseQueries::updateMessageFilter(db, filter_id, name, script, &ok);
+        return ok;
+    });
 }
 
 void FeedReader::assignMessageFilterToFeed(Feed *feed, MessageFilter *filter)
 {
     feed->appendMessageFilter(filter);
-    DatabaseQueries::assignMessageFilterToFeed(qApp->database()->connection(metaObject()->className()),
-            feed->customId(),
-            filter->id(),
-            feed->getParentServiceRoot()->accountId());
+
+    const QString feed_custom_id = feed->customId();
+    const int filter_id = filter->id();
+    const int account_id = feed->getParentServiceRoot()->accountId();
+
+    qApp->database()->writer()->enqueue([feed_custom_id, filter_id, account_id](const QSqlDatabase &db) {
+        bool ok;
+
+        DatabaseQueries::assignMessageFilterToFeed(db, feed_custom_id, filter_id, account_id, &ok);
+        return ok;
+    });
 }
 
 void FeedReader::removeMessageFilterToFeedAssignment(Feed *feed, MessageFilter *filter)
 {
     feed->removeMessageFilter(filter);
-    DatabaseQueries::removeMessageFilterFromFeed(qApp->database()->connection(
-                metaObject()->className()),
-            feed->customId(),
-            filter->id(),
-            feed->getParentServiceRoot()->accountId());
+
+    const QString feed_custom_id = feed->customId();
+    const int filter_id = filter->id();
+    const int account_id = feed->getParentServiceRoot()->accountId();
+
+    qApp->database()->writer()->enqueue([feed_custom_id, filter_id, account_id](const QSqlDatabase &db) {
+        bool ok;
+
+        DatabaseQueries::removeMessageFilterFromFeed(db, feed_custom_id, filter_id, account_id, &ok);
+        return ok;
+    });
 }
 
 void FeedReader::updateAllFeeds()
@@ -331,12 +395,80 @@ QList<MessageFilter *> FeedReader::messageFilters() const
     return m_messageFilters;
 }
 
+void FeedReader::compressStoredMessageContents()
+{
+    // MySQL full-text indexes can not search compressed contents.
+    if (m_contentsCompressionWatcher.isRunning() ||
+            qApp->database()->activeDatabaseDriver() == DatabaseFactory::UsedDriver::MYSQL ||
+            !qApp->settings()->value(GROUP(Database), SETTING(Database::CompressContents)).toBool() ||
+            qApp->settings()->value(GROUP(Database), SETTING(Database::CompressContentsMigrated)).toBool()) {
+        return;
+    }
+
+    qDebugNN << LOGSEC_DB << "Starting background compression of stored message contents.";
+
+    m_stopContentsCompression = false;
+    m_contentsCompressionWatcher.setFuture(QtConcurrent::run(&m_maintenance, [this]() {
+        QSqlDatabase database = qApp->database()->connection(QSL("ContentsCompression"));
+        int last_id = 0;
+        bool ok = true;
+
+        // Each batch is committed separately so that feed updates are not blocked for long.
+        while (!m_stopContentsCompression) {
+            if (DatabaseQueries::compressMessageContents(database, &last_id, MSG_COMPRESSION_BATCH_SIZE, &ok) == 0
+                    || !ok) {
+                break;
+            }
+        }
+
+        return ok && !m_stopContentsCompression;
+    }));
+}
+
+void FeedReader::runIncrementalVacuum()
+{
+    // Vacuuming competes with feed updates for database,
+    // so it only runs when nothing else is working with it.
+    if (m_vacuumWatcher.isRunning() || m_contentsCompressionWatcher.isRunning() || isFeedUpdateRunning()) {
+        return;
+    }
+
+    m_vacuumWatcher.setFuture(QtConcurrent::run(&m_maintenance, []() {
+        return qApp->database()->incrementalVacuumDatabase(QSL("IncrementalVacuum"));
+    }));
+}
+
+void FeedReader::archiveOldMessages()
+{
+    const int days = qApp->settings()->value(GROUP(Database), SETTING(Database::ArchiveAfterDays)).toInt();
+
+    if (days <= 0 || !qApp->database()->archiveAvailable() || m_archiveWatcher.isRunning()) {
+        return;
+    }
+
+    m_archiveWatcher.setFuture(qApp->database()->writer()->enqueue([this, days](const QSqlDatabase &db) {
+        bool ok;
+
+        m_lastArchiveBatch = DatabaseQueries::archiveMessages(db, days, MSG_ARCHIVE_BATCH_SIZE, &ok);
+        return ok;
+    }));
+}
+
 void FeedReader::quit()
 {
     if (m_autoUpdateTimer->isActive()) {
         m_autoUpdateTimer->stop();
     }
 
+    m_vacuumTimer->stop();
+    m_vacuumWatcher.waitForFinished();
+    m_archiveTimer->stop();
+    m_archiveWatcher.waitForFinished();
+
+    // Stop compression of contents, it continues on next start.
+    m_stopContentsCompression = true;
+    m_contentsCompressionWatcher.waitForFinished();
+
     // Stop running updates.
     if (m_feedDownloader != nullptr) {
         m_feedDownloader->stopRunningUpdate();
@@ -10,6 +10,9 @@
 #include "services/abstract/feed.h"
 
 #include <QFutureWatcher>
+#include <QThreadPool>
+
+#include <atomic>
 
 class FeedsModel;
 class MessagesModel;
@@ -61,6 +64,10 @@ public:
     void assignMessageFilterToFeed(Feed *feed, MessageFilter *filter);
     void removeMessageFilterToFeedAssignment(Feed *feed, MessageFilter *filter);
 
+    // Compresses contents of already stored messages in background
+    // if compression is enabled and not all messages are compressed yet.
+    void compressStoredMessageContents();
+
 public slots:
     void updateAllFeeds();
     void stopRunningFeedUpdate();
@@ -70,6 +77,8 @@ private slots:
     void executeNextAutoUpdate();
     void checkServicesForAsyncOperations();
     void asyncCacheSaveFinished();
+    void runIncrementalVacuum();
+    void archiveOldMessages();
 
 signals:
     void feedUpdatesStarted();
@@ -92,6 +101,23 @@ private:
     int m_globalAutoUpdateRemainingInterval{};
     QThread *m_feedDownloaderThread;
     FeedDownloader *m_feedDownloader;
+
+    // Single thread which runs database maintenance, it never expires so
+    // that its database connections stay valid between runs.
+    QThreadPool m_maintenance;
+
+    // Background compression of message contents.
+    QFutureWatcher<bool> m_contentsCompressionWatcher;
+    std::atomic_bool m_stopContentsCompression{false};
+
+    // Background vacuuming of database.
+    QTimer *m_vacuumTimer;
+    QFutureWatcher<qint64> m_vacuumWatcher;
+
+    // Background moving of old messages to archive.
+    QTimer *m_archiveTimer;
+    QFutureWatcher<bool> m_archiveWatcher;
+    int m_lastArchiveBatch;
 };
 
 #endif // FEEDREADER_H
@@ -2,11 +2,15 @@
 
 #include "miscellaneous/iconfactory.h"
 
+#include "miscellaneous/databasequeries.h"
 #include "miscellaneous/settings.h"
 
 #include <QBuffer>
+#include <QMutexLocker>
+#include <QPixmapCache>
+#include <QThread>
 
-IconFactory::IconFactory(QObject *parent) : QObject(parent) {}
+IconFactory::IconFactory(QObject *parent) : QObject(parent), m_storedIconsLoaded(false) {}
 
 IconFactory::~IconFactory()
 {
@@ -42,6 +46,75 @@ QByteArray IconFactory::toByteArray(const QIcon &icon)
     return array.toBase64();
 }
 
+QByteArray IconFactory::toPng(const QIcon &icon)
+{
+    if (icon.isNull()) {
+        return QByteArray();
+    }
+
+    // Largest available size is stored, icons without
+    // fixed sizes are rendered in reasonable size.
+    QSize size(32, 32);
+
+    for (const QSize &available_size : icon.availableSizes()) {
+        if (available_size.width() * available_size.height() > size.width() * size.height()) {
+            size = available_size;
+        }
+    }
+
+    QByteArray array;
+    QBuffer buffer(&array);
+
+    buffer.open(QIODevice::WriteOnly);
+    icon.pixmap(size).save(&buffer, "PNG");
+    buffer.close();
+    return array;
+}
+
+QIcon IconFactory::storedIcon(int icon_id)
+{
+    // Pixmap cache can be only used in GUI thread.
+    const bool use_cache = QThread::currentThread() == thread();
+    const QString cache_key = QSL("stored-icon-%1").arg(icon_id);
+    QPixmap pixmap;
+
+    if (use_cache && QPixmapCache::find(cache_key, &pixmap)) {
+        return QIcon(pixmap);
+    }
+
+    if (pixmap.loadFromData(storedIconData(icon_id), "PNG") && use_cache) {
+        QPixmapCache::insert(cache_key, pixmap);
+    }
+
+    return QIcon(pixmap);
+}
+
+void IconFactory::addStoredIcon(int icon_id, const QByteArray &png_data)
+{
+    QMutexLocker locker(&m_storedIconsMutex);
+
+    m_storedIcons.insert(icon_id, png_data);
+}
+
+QByteArray IconFactory::storedIconData(int icon_id)
+{
+    QMutexLocker locker(&m_storedIconsMutex);
+
+    if (!m_storedIconsLoaded) {
+        // Only encoded images are loaded here, each of them
+        // is decoded when its icon is displayed.
+        const QHash<int, QByteArray> icons = DatabaseQueries::getIcons(qApp->database()->connection(metaObject()->className()));
+
+        for (auto i = icons.constBegin(); i != icons.constEnd(); ++i) {
+            m_storedIcons.insert(i.key(), i.value());
+        }
+
+        m_storedIconsLoaded = true;
+    }
+
+    return m_storedIcons.value(icon_id);
+}
+
 QIcon IconFactory::fromTheme(const QString &name)
 {
     return QIcon::fromTheme(name);
@@ -11,6 +11,7 @@
 #include <QDir>
 #include <QHash>
 #include <QIcon>
+#include <QMutex>
 #include <QString>
 
 class RSSGUARD_DLLSPEC IconFactory : public QObject
@@ -26,6 +27,16 @@ public:
     static QIcon fromByteArray(QByteArray array);
     static QByteArray toByteArray(const QIcon &icon);
 
+    // Converts icon to PNG image as it is kept in icon store in DB.
+    static QByteArray toPng(const QIcon &icon);
+
+    // Returns icon from icon store in DB. Icon is decoded when
+    // it is needed for the first time and kept in shared pixmap cache.
+    QIcon storedIcon(int icon_id);
+
+    // Makes icon which was just added to icon store available.
+    void addStoredIcon(int icon_id, const QByteArray &png_data);
+
     // Returns icon from active theme or invalid icon if
     // "no icon theme" is set.
     QIcon fromTheme(const QString &name);
@@ -49,6 +60,14 @@ public:
 
     // Sets icon theme with given name as the active one and loads it.
     void setCurrentIconTheme(const QString &theme_name);
+
+private:
+    QByteArray storedIconData(int icon_id);
+
+    // Encoded images from icon store, whole store is loaded at once.
+    QMutex m_storedIconsMutex;
+    QHash<int, QByteArray> m_storedIcons;
+    bool m_storedIconsLoaded;
 };
 
 inline QString IconFactory::currentIconTheme() const
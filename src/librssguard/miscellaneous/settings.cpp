@@ -324,6 +324,26 @@ DKEY Database::UseInMemory = "use_in_memory_db";
 
 DVALUE(bool) Database::UseInMemoryDef = false;
 
+DKEY Database::CompressContents = "compress_message_contents";
+
+DVALUE(bool) Database::CompressContentsDef = false;
+
+DKEY Database::CompressContentsMigrated = "compress_message_contents_migrated";
+
+DVALUE(bool) Database::CompressContentsMigratedDef = false;
+
+DKEY Database::ArchiveAfterDays = "archive_after_days";
+
+DVALUE(int) Database::ArchiveAfterDaysDef = 0;
+
+DKEY Database::ProfileQueries = "profile_queries";
+
+DVALUE(bool) Database::ProfileQueriesDef = false;
+
+DKEY Database::SlowQueryThreshold = "slow_query_threshold";
+
+DVALUE(int) Database::SlowQueryThresholdDef = 100;
+
 DKEY Database::MySQLHostname = "mysql_hostname";
 
 DVALUE(QString) Database::MySQLHostnameDef = QString();
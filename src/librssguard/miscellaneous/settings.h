@@ -354,6 +354,26 @@ KEY UseInMemory;
 
 VALUE(bool) UseInMemoryDef;
 
+KEY CompressContents;
+
+VALUE(bool) CompressContentsDef;
+
+KEY CompressContentsMigrated;
+
+VALUE(bool) CompressContentsMigratedDef;
+
+KEY ArchiveAfterDays;
+
+VALUE(int) ArchiveAfterDaysDef;
+
+KEY ProfileQueries;
+
+VALUE(bool) ProfileQueriesDef;
+
+KEY SlowQueryThreshold;
+
+VALUE(int) SlowQueryThresholdDef;
+
 KEY MySQLHostname;
 
 VALUE(QString) MySQLHostnameDef;
@@ -33,7 +33,13 @@ Category::Category(const QSqlRecord &record) : Category(nullptr)
     setDescription(record.value(CAT_DB_DESCRIPTION_INDEX).toString());
     setCreationDate(TextFactory::parseDateTime(record.value(
                         CAT_DB_DCREATED_INDEX).value<qint64>()).toLocalTime());
-    setIcon(qApp->icons()->fromByteArray(record.value(CAT_DB_ICON_INDEX).toByteArray()));
+
+    if (record.value(CAT_DB_ICON_ID_INDEX).toInt() > 0) {
+        setIconId(record.value(CAT_DB_ICON_ID_INDEX).toInt());
+    } else {
+        // Icon was stored by older version and is not moved to icon store yet.
+        setIcon(qApp->icons()->fromByteArray(record.value(CAT_DB_ICON_INDEX).toByteArray()));
+    }
 }
 
 Category::~Category() = default;
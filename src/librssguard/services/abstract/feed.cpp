@@ -5,6 +5,7 @@
 #include "definitions/definitions.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasewriter.h"
 #include "miscellaneous/feedreader.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/mutex.h"
@@ -14,6 +15,7 @@
 #include "services/abstract/recyclebin.h"
 #include "services/abstract/serviceroot.h"
 
+#include <QFutureInterface>
 #include <QThread>
 
 Feed::Feed(RootItem *parent)
@@ -40,7 +42,14 @@ Feed::Feed(const QSqlRecord &record) : Feed(nullptr)
     setDescription(QString::fromUtf8(record.value(FDS_DB_DESCRIPTION_INDEX).toByteArray()));
     setCreationDate(TextFactory::parseDateTime(record.value(
                         FDS_DB_DCREATED_INDEX).value<qint64>()).toLocalTime());
-    setIcon(qApp->icons()->fromByteArray(record.value(FDS_DB_ICON_INDEX).toByteArray()));
+
+    if (record.value(FDS_DB_ICON_ID_INDEX).toInt() > 0) {
+        setIconId(record.value(FDS_DB_ICON_ID_INDEX).toInt());
+    } else {
+        // Icon was stored by older version and is not moved to icon store yet.
+        setIcon(qApp->icons()->fromByteArray(record.value(FDS_DB_ICON_INDEX).toByteArray()));
+    }
+
     setAutoUpdateType(static_cast<Feed::AutoUpdateType>(record.value(
                           FDS_DB_UPDATE_TYPE_INDEX).toInt()));
     setAutoUpdateInitialInterval(record.value(FDS_DB_UPDATE_INTERVAL_INDEX).toInt());
@@ -211,58 +220,111 @@ bool Feed::markAsReadUnread(RootItem::ReadStatus status)
     return service->markFeedsReadUnread(QList<Feed *>() << this, status);
 }
 
-int Feed::updateMessages(const QList<Message> &messages, bool error_during_obtaining)
+RetentionPolicy Feed::effectiveRetentionPolicy(const QSqlDatabase &db) const
 {
-    QList<RootItem *> items_to_update;
-    int updated_messages = 0;
+    const int account_id = getParentServiceRoot()->accountId();
+    RetentionPolicy policy = DatabaseQueries::getRetentionPolicy(db, RootItem::Kind::Feed, customId(), account_id);
 
-    if (!error_during_obtaining) {
-        bool is_main_thread = QThread::currentThread() == qApp->thread();
+    for (const RootItem *item = parent();
+         policy.isEmpty() && item != nullptr && item->kind() == RootItem::Kind::Category;
+         item = item->parent()) {
+        policy = DatabaseQueries::getRetentionPolicy(db, RootItem::Kind::Category, item->customId(), account_id);
+    }
 
-        qDebug("Updating messages in DB. Main thread: '%s'.",
-               qPrintable(is_main_thread ? "true" : "false"));
+    return policy;
+}
 
-        bool anything_updated = false;
-        bool ok = true;
+QFuture<bool> Feed::updateMessages(const QList<Message> &messages, bool error_during_obtaining,
+                                   const QSharedPointer<int> &updated_messages)
+{
+    *updated_messages = 0;
 
-        if (!messages.isEmpty()) {
-            qDebug("There are some messages to be updated/added to DB.");
+    if (error_during_obtaining) {
+        qCritical("There is indication that there was error during messages obtaining.");
+        getParentServiceRoot()->itemChanged(QList<RootItem *>() << this);
 
-            QString custom_id = customId();
-            int account_id = getParentServiceRoot()->accountId();
-            QSqlDatabase database = is_main_thread ?
-                                    qApp->database()->connection(metaObject()->className()) :
-                                    qApp->database()->connection(QSL("feed_upd"));
+        QFutureInterface<bool> failed;
 
-            updated_messages = DatabaseQueries::updateMessages(database, messages, custom_id, account_id, url(),
-                               &anything_updated, &ok);
-        } else {
-            qWarning("There are no messages for update.");
+        failed.reportStarted();
+        failed.reportResult(false);
+        failed.reportFinished();
+        return failed.future();
+    }
+
+    bool is_main_thread = QThread::currentThread() == qApp->thread();
+
+    qDebug("Updating messages in DB. Main thread: '%s'.",
+           qPrintable(is_main_thread ? "true" : "false"));
+
+    if (messages.isEmpty()) {
+        qWarning("There are no messages for update.");
+    } else {
+        qDebug("There are some messages to be updated/added to DB.");
+    }
+
+    QString custom_id = customId();
+    int account_id = getParentServiceRoot()->accountId();
+    QString feed_url = url();
+
+    // Policy is resolved here, because it is inherited from parent items
+    // which must not be accessed from database writer thread.
+    QSqlDatabase policy_database = is_main_thread ?
+                                   qApp->database()->connection(metaObject()->className()) :
+                                   qApp->database()->connection(QSL("feed_upd"));
+    const RetentionPolicy policy = effectiveRetentionPolicy(policy_database);
+    QSharedPointer<bool> anything_updated(new bool(false));
+
+    // Messages are written by database writer, so that they are committed
+    // together with writes of other feeds. Counts are recalculated from the
+    // database once the write is committed.
+    const QFuture<bool> write = qApp->database()->writer()->enqueue([messages, custom_id, account_id, feed_url, policy,
+                                                                     updated_messages,
+                                                                     anything_updated](const QSqlDatabase &database) {
+        if (messages.isEmpty()) {
+            return true;
         }
 
-        if (ok) {
-            setStatus(updated_messages > 0 ? Status::NewMessages : Status::Normal);
-            updateCounts(true);
+        bool written = true;
 
-            if (getParentServiceRoot()->recycleBin() != nullptr && anything_updated) {
-                getParentServiceRoot()->recycleBin()->updateCounts(true);
-                items_to_update.append(getParentServiceRoot()->recycleBin());
-            }
+        *updated_messages = DatabaseQueries::updateMessages(database, messages, custom_id, account_id, feed_url,
+                                                            anything_updated.data(), &written);
 
-            if (getParentServiceRoot()->importantNode() != nullptr && anything_updated) {
-                getParentServiceRoot()->importantNode()->updateCounts(true);
-                items_to_update.append(getParentServiceRoot()->importantNode());
+        if (written) {
+            // Keep only as many messages as allowed, this touches only
+            // rows of this feed so it is cheap enough to run after each update.
+            if (!policy.isEmpty() &&
+                DatabaseQueries::applyRetentionPolicy(database, custom_id, account_id, policy) > 0) {
+                *anything_updated = true;
             }
+        } else {
+            *updated_messages = 0;
+        }
+
+        return written;
+    });
+
+    DatabaseWriter::whenCommitted(write, this, [this, updated_messages, anything_updated]() {
+        QList<RootItem *> items_to_update;
+
+        setStatus(*updated_messages > 0 ? Status::NewMessages : Status::Normal);
+        updateCounts(true);
+
+        if (getParentServiceRoot()->recycleBin() != nullptr && *anything_updated) {
+            getParentServiceRoot()->recycleBin()->updateCounts(true);
+            items_to_update.append(getParentServiceRoot()->recycleBin());
+        }
+
+        if (getParentServiceRoot()->importantNode() != nullptr && *anything_updated) {
+            getParentServiceRoot()->importantNode()->updateCounts(true);
+            items_to_update.append(getParentServiceRoot()->importantNode());
         }
-    } else {
-        qCritical("There is indication that there was error during messages obtaining.");
-    }
 
-    // Some messages were really added to DB, reload feed in model.
-    items_to_update.append(this);
-    getParentServiceRoot()->itemChanged(items_to_update);
+        // Some messages were really added to DB, reload feed in model.
+        items_to_update.append(this);
+        getParentServiceRoot()->itemChanged(items_to_update);
+    });
 
-    return updated_messages;
+    return write;
 }
 
 QString Feed::getAutoUpdateStatusDescription() const
@@ -7,8 +7,11 @@
 
 #include "core/message.h"
 #include "core/messagefilter.h"
+#include "core/retentionpolicy.h"
 
+#include <QFuture>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QVariant>
 
 // Base class for "feed" nodes.
@@ -78,11 +81,20 @@ public:
     bool markAsReadUnread(ReadStatus status);
     bool cleanMessages(bool clean_read_only);
 
+    // Returns retention policy of this feed or, if feed
+    // does not have its own, policy of the nearest parent category.
+    RetentionPolicy effectiveRetentionPolicy(const QSqlDatabase &db) const;
+
+    // Stores messages through database writer and does not wait for them to be written.
+    // Returned future reports true once messages are committed, "updated_messages"
+    // then holds count of new/updated messages. Feed refreshes itself afterwards.
+    QFuture<bool> updateMessages(const QList<Message> &messages, bool error_during_obtaining,
+                                 const QSharedPointer<int> &updated_messages);
+
     virtual QList<Message> obtainNewMessages(bool *error_during_obtaining) = 0;
 
 public slots:
     void updateCounts(bool including_total_count);
-    int updateMessages(const QList<Message> &messages, bool error_during_obtaining);
 
 protected:
     QString getAutoUpdateStatusDescription() const;
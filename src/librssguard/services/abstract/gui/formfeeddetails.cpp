@@ -7,6 +7,7 @@
 #include "gui/baselineedit.h"
 #include "gui/messagebox.h"
 #include "gui/systemtrayicon.h"
+#include "miscellaneous/databasequeries.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/textfactory.h"
 #include "network-web/networkfactory.h"
@@ -313,6 +314,30 @@ void FormFeedDetails::setEditableFeed(Feed *editable_feed)
     m_ui->m_cmbAutoUpdateType->setCurrentIndex(m_ui->m_cmbAutoUpdateType->findData(QVariant::fromValue((
                 int) editable_feed->autoUpdateType())));
     m_ui->m_spinAutoUpdateInterval->setValue(editable_feed->autoUpdateInitialInterval());
+
+    const RetentionPolicy policy = DatabaseQueries::getRetentionPolicy(qApp->database()->connection(metaObject()->className()),
+                                                                       RootItem::Kind::Feed,
+                                                                       editable_feed->customId(),
+                                                                       editable_feed->getParentServiceRoot()->accountId());
+
+    m_ui->m_spinRetentionMaxAge->setValue(policy.m_maxAge);
+    m_ui->m_spinRetentionMaxCount->setValue(policy.m_maxCount);
+    m_ui->m_checkRetentionKeepImportant->setChecked(policy.m_keepImportant);
+}
+
+void FormFeedDetails::saveRetentionPolicy(Feed *feed)
+{
+    RetentionPolicy policy;
+
+    policy.m_maxAge = m_ui->m_spinRetentionMaxAge->value();
+    policy.m_maxCount = m_ui->m_spinRetentionMaxCount->value();
+    policy.m_keepImportant = m_ui->m_checkRetentionKeepImportant->isChecked();
+
+    DatabaseQueries::storeRetentionPolicy(qApp->database()->connection(metaObject()->className()),
+                                          RootItem::Kind::Feed,
+                                          feed->customId(),
+                                          feed->getParentServiceRoot()->accountId(),
+                                          policy);
 }
 
 void FormFeedDetails::initialize()
@@ -393,6 +418,12 @@ void FormFeedDetails::initialize()
     m_ui->m_cmbAutoUpdateType->addItem(tr("Do not auto-update at all"),
                                        QVariant::fromValue(int(Feed::AutoUpdateType::DontAutoUpdate)));
 
+    // Setup retention options.
+    m_ui->m_spinRetentionMaxAge->setSuffix(tr(" days"));
+    m_ui->m_spinRetentionMaxAge->setSpecialValueText(tr("no limit"));
+    m_ui->m_spinRetentionMaxCount->setSuffix(tr(" messages"));
+    m_ui->m_spinRetentionMaxCount->setSpecialValueText(tr("no limit"));
+
     // Set tab order.
     setTabOrder(m_ui->m_cmbParentCategory, m_ui->m_cmbType);
     setTabOrder(m_ui->m_cmbType, m_ui->m_cmbEncoding);
@@ -406,6 +437,9 @@ void FormFeedDetails::initialize()
     setTabOrder(m_ui->m_btnIcon, m_ui->m_gbAuthentication);
     setTabOrder(m_ui->m_gbAuthentication, m_ui->m_txtUsername->lineEdit());
     setTabOrder(m_ui->m_txtUsername->lineEdit(), m_ui->m_txtPassword->lineEdit());
+    setTabOrder(m_ui->m_txtPassword->lineEdit(), m_ui->m_spinRetentionMaxAge);
+    setTabOrder(m_ui->m_spinRetentionMaxAge, m_ui->m_spinRetentionMaxCount);
+    setTabOrder(m_ui->m_spinRetentionMaxCount, m_ui->m_checkRetentionKeepImportant);
     m_ui->m_txtUrl->lineEdit()->setFocus(Qt::TabFocusReason);
 }
 
@@ -62,6 +62,10 @@ protected:
     // base implementation must be called first.
     void virtual setEditableFeed(Feed *editable_feed);
 
+    // Stores retention policy from the dialog for given feed.
+    // NOTE: Subclasses call this once the feed is saved and has its custom ID.
+    void saveRetentionPolicy(Feed *feed);
+
     // Creates needed connections.
     void createConnections();
 
@@ -43,6 +43,12 @@ void ImportantNode::updateCounts(bool including_total_count)
     m_unreadCount = DatabaseQueries::getImportantMessageCounts(database, account_id, false);
 }
 
+void ImportantNode::setCounts(int unread_count, int total_count)
+{
+    m_unreadCount = unread_count;
+    m_totalCount = total_count;
+}
+
 bool ImportantNode::cleanMessages(bool clean_read_only)
 {
     ServiceRoot *service = getParentServiceRoot();
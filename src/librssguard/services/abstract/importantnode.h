@@ -16,6 +16,7 @@ public:
     QList<Message> undeletedMessages() const;
     bool cleanMessages(bool clean_read_only);
     void updateCounts(bool including_total_count);
+    void setCounts(int unread_count, int total_count);
     bool markAsReadUnread(ReadStatus status);
     int countOfUnreadMessages() const;
     int countOfAllMessages() const;
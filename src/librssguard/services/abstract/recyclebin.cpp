@@ -53,6 +53,12 @@ void RecycleBin::updateCounts(bool update_total_count)
     }
 }
 
+void RecycleBin::setCounts(int unread_count, int total_count)
+{
+    m_unreadCount = unread_count;
+    m_totalCount = total_count;
+}
+
 QList<QAction *> RecycleBin::contextMenuFeedsList()
 {
     if (m_contextMenu.isEmpty()) {
@@ -25,6 +25,7 @@ public:
     int countOfAllMessages() const;
 
     void updateCounts(bool update_total_count);
+    void setCounts(int unread_count, int total_count);
 
 public slots:
     virtual bool empty();
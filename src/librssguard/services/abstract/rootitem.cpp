@@ -14,14 +14,15 @@
 
 RootItem::RootItem(RootItem *parent_item)
     : QObject(nullptr), m_kind(RootItem::Kind::Root), m_id(NO_PARENT_CATEGORY), m_customId(QL1S("")),
-      m_title(QString()), m_description(QString()), m_keepOnTop(false), m_parentItem(parent_item) {}
+      m_title(QString()), m_description(QString()), m_iconId(0), m_keepOnTop(false), m_parentItem(parent_item) {}
 
 RootItem::RootItem(const RootItem &other) : RootItem(nullptr)
 {
     setTitle(other.title());
     setId(other.id());
     setCustomId(other.customId());
-    setIcon(other.icon());
+    setIcon(other.m_icon);
+    setIconId(other.iconId());
     setChildItems(other.childItems());
     setParent(other.parent());
     setCreationDate(other.creationDate());
@@ -409,12 +410,27 @@ void RootItem::setKind(RootItem::Kind kind)
 
 QIcon RootItem::icon() const
 {
+    if (m_icon.isNull() && m_iconId > 0) {
+        return qApp->icons()->storedIcon(m_iconId);
+    }
+
     return m_icon;
 }
 
 void RootItem::setIcon(const QIcon &icon)
 {
     m_icon = icon;
+    m_iconId = 0;
+}
+
+int RootItem::iconId() const
+{
+    return m_iconId;
+}
+
+void RootItem::setIconId(int icon_id)
+{
+    m_iconId = icon_id;
 }
 
 int RootItem::id() const
@@ -181,6 +181,10 @@ public:
     QIcon icon() const;
     void setIcon(const QIcon &icon);
 
+    // ID of icon in icon store, icon is decoded only when it is needed.
+    int iconId() const;
+    void setIconId(int icon_id);
+
     // This ALWAYS represents primary column number/ID under which
     // the item is stored in DB.
     int id() const;
@@ -216,6 +220,7 @@ private:
     QString m_title;
     QString m_description;
     QIcon m_icon;
+    int m_iconId;
     QDateTime m_creationDate;
     bool m_keepOnTop;
     QList<RootItem *> m_childItems;
@@ -109,6 +109,15 @@ void ServiceRoot::stop() {}
 
 void ServiceRoot::updateCounts(bool including_total_count)
 {
+    if (m_hasPreloadedCounts) {
+        // Counts were loaded together with counts of other accounts.
+        applyCounts(m_preloadedCounts, true);
+
+        m_hasPreloadedCounts = false;
+        m_preloadedCounts.clear();
+        return;
+    }
+
     QList<Feed *> feeds;
 
     for (RootItem *child : getSubTree()) {
@@ -148,6 +157,60 @@ void ServiceRoot::updateCounts(bool including_total_count)
     }
 }
 
+void ServiceRoot::setPreloadedCounts(const QHash<QString, MessageCounts> &counts)
+{
+    m_hasPreloadedCounts = true;
+    m_preloadedCounts = counts;
+}
+
+void ServiceRoot::applyCounts(const QHash<QString, MessageCounts> &counts, bool including_total_count)
+{
+    MessageCounts bin, important;
+
+    // Special nodes contain messages of all feeds, even of those which
+    // do not exist anymore.
+    for (const MessageCounts &feed_counts : counts) {
+        bin.m_unread += feed_counts.m_binUnread;
+        bin.m_total += feed_counts.m_binTotal;
+        important.m_unread += feed_counts.m_importantUnread;
+        important.m_total += feed_counts.m_importantTotal;
+    }
+
+    for (RootItem *child : getSubTree()) {
+        switch (child->kind()) {
+            case RootItem::Kind::Feed: {
+                const MessageCounts feed_counts = counts.value(child->customId());
+
+                child->toFeed()->setCountOfUnreadMessages(feed_counts.m_unread);
+
+                if (including_total_count) {
+                    child->toFeed()->setCountOfAllMessages(feed_counts.m_total);
+                }
+
+                break;
+            }
+
+            case RootItem::Kind::Bin:
+                static_cast<RecycleBin *>(child)->setCounts(bin.m_unread,
+                        including_total_count ? bin.m_total : child->countOfAllMessages());
+                break;
+
+            case RootItem::Kind::Important:
+                static_cast<ImportantNode *>(child)->setCounts(important.m_unread,
+                        including_total_count ? important.m_total : child->countOfAllMessages());
+                break;
+
+            case RootItem::Kind::Category:
+            case RootItem::Kind::ServiceRoot:
+                break;
+
+            default:
+                child->updateCounts(including_total_count);
+                break;
+        }
+    }
+}
+
 void ServiceRoot::completelyRemoveAllData()
 {
     // Purge old data from SQL and clean all model items.
@@ -552,7 +615,7 @@ bool ServiceRoot::loadMessagesForItem(RootItem *item, MessagesModel *model)
         }
 
         model->setFilter(
-            QString("Feeds.custom_id IN (%1) AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.account_id = %2").arg(
+            QString("Messages.feed IN (%1) AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.account_id = %2").arg(
                 filter_clause,
                 QString::
                 number(accountId())));
@@ -708,6 +771,51 @@ bool ServiceRoot::onAfterMessagesRestoredFromBin(RootItem *selected_item,
     return true;
 }
 
+bool ServiceRoot::onBeforeSetBatchMessagesRead(RootItem *selected_item, const QStringList &message_ids,
+        RootItem::ReadStatus read)
+{
+    auto cache = dynamic_cast<CacheForServiceRoot *>(this);
+
+    if (cache != nullptr) {
+        QSqlDatabase database = qApp->database()->connection(metaObject()->className());
+
+        cache->addMessageStatesToCache(DatabaseQueries::customIdsOfMessages(database, message_ids), read);
+    }
+
+    return onBeforeSetMessagesRead(selected_item, QList<Message>(), read);
+}
+
+bool ServiceRoot::onAfterSetBatchMessagesRead(RootItem *selected_item, const QStringList &message_ids,
+        RootItem::ReadStatus read)
+{
+    Q_UNUSED(message_ids)
+    return onAfterSetMessagesRead(selected_item, QList<Message>(), read);
+}
+
+bool ServiceRoot::onBeforeBatchMessagesDelete(RootItem *selected_item, const QStringList &message_ids)
+{
+    Q_UNUSED(message_ids)
+    return onBeforeMessagesDelete(selected_item, QList<Message>());
+}
+
+bool ServiceRoot::onAfterBatchMessagesDelete(RootItem *selected_item, const QStringList &message_ids)
+{
+    Q_UNUSED(message_ids)
+    return onAfterMessagesDelete(selected_item, QList<Message>());
+}
+
+bool ServiceRoot::onBeforeBatchMessagesRestoredFromBin(RootItem *selected_item, const QStringList &message_ids)
+{
+    Q_UNUSED(message_ids)
+    return onBeforeMessagesRestoredFromBin(selected_item, QList<Message>());
+}
+
+bool ServiceRoot::onAfterBatchMessagesRestoredFromBin(RootItem *selected_item, const QStringList &message_ids)
+{
+    Q_UNUSED(message_ids)
+    return onAfterMessagesRestoredFromBin(selected_item, QList<Message>());
+}
+
 void ServiceRoot::assembleFeeds(Assignment feeds)
 {
     QHash<int, Category *> categories = getHashedSubTreeCategories();
@@ -7,6 +7,7 @@
 
 #include "core/message.h"
 
+#include <QHash>
 #include <QPair>
 
 class FeedsModel;
@@ -20,6 +21,16 @@ typedef QList<QPair<int, RootItem *>> Assignment;
 typedef QPair<int, RootItem *> AssignmentItem;
 typedef QPair<Message, RootItem::Importance> ImportanceChange;
 
+// Counts of messages of single feed, including those in special nodes.
+struct MessageCounts {
+    int m_unread = 0;
+    int m_total = 0;
+    int m_binUnread = 0;
+    int m_binTotal = 0;
+    int m_importantUnread = 0;
+    int m_importantTotal = 0;
+};
+
 // THIS IS the root node of the service.
 // NOTE: The root usually contains some core functionality of the
 // service like service account username/password etc.
@@ -32,6 +43,12 @@ public:
     virtual ~ServiceRoot();
 
     void updateCounts(bool including_total_count);
+
+    // Gives this account counts of its messages (per feed custom ID) which were
+    // loaded for all accounts at once. Next "updateCounts" call uses them instead
+    // of querying the database.
+    void setPreloadedCounts(const QHash<QString, MessageCounts> &counts);
+
     bool deleteViaGui();
     bool markAsReadUnread(ReadStatus status);
 
@@ -164,6 +181,19 @@ public:
     virtual bool onAfterMessagesRestoredFromBin(RootItem *selected_item,
             const QList<Message> &messages);
 
+    // Variants of methods above used for batches of messages changed in message list.
+    // Messages are given only by their IDs, so that they do not have to be loaded.
+    // Default implementations pass custom IDs of messages to state cache, which
+    // are loaded with single query, and then call methods above with no messages.
+    virtual bool onBeforeSetBatchMessagesRead(RootItem *selected_item, const QStringList &message_ids,
+            ReadStatus read);
+    virtual bool onAfterSetBatchMessagesRead(RootItem *selected_item, const QStringList &message_ids,
+            ReadStatus read);
+    virtual bool onBeforeBatchMessagesDelete(RootItem *selected_item, const QStringList &message_ids);
+    virtual bool onAfterBatchMessagesDelete(RootItem *selected_item, const QStringList &message_ids);
+    virtual bool onBeforeBatchMessagesRestoredFromBin(RootItem *selected_item, const QStringList &message_ids);
+    virtual bool onAfterBatchMessagesRestoredFromBin(RootItem *selected_item, const QStringList &message_ids);
+
 public slots:
     virtual void addNewFeed(const QString &url = QString());
     virtual void addNewCategory();
@@ -218,6 +248,12 @@ private:
     virtual void restoreCustomFeedsData(const QMap<QString, QVariantMap> &data,
                                         const QHash<QString, Feed *> &feeds);
 
+    // Distributes given counts to all feeds and special nodes in one pass.
+    void applyCounts(const QHash<QString, MessageCounts> &counts, bool including_total_count);
+
+    bool m_hasPreloadedCounts{};
+    QHash<QString, MessageCounts> m_preloadedCounts;
+
 protected:
     RecycleBin *m_recycleBin;
     ImportantNode *m_importantNode;
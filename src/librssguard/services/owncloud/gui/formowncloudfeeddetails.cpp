@@ -21,6 +21,7 @@ FormOwnCloudFeedDetails::FormOwnCloudFeedDetails(ServiceRoot *service_root, QWid
     m_ui->m_txtTitle->setEnabled(false);
     m_ui->m_txtUrl->setEnabled(true);
     m_ui->m_txtDescription->setEnabled(false);
+    m_ui->m_gbRetention->setEnabled(false);
 }
 
 void FormOwnCloudFeedDetails::apply()
@@ -47,6 +48,7 @@ void FormOwnCloudFeedDetails::apply()
         new_feed_data->setAutoUpdateInitialInterval(int(m_ui->m_spinAutoUpdateInterval->value()));
         qobject_cast<OwnCloudFeed *>(m_editableFeed)->editItself(new_feed_data);
         delete new_feed_data;
+        saveRetentionPolicy(m_editableFeed);
 
         if (renamed) {
             QTimer::singleShot(200, m_serviceRoot, SLOT(syncIn()));
@@ -80,6 +82,7 @@ void FormOwnCloudFeedDetails::apply()
 void FormOwnCloudFeedDetails::setEditableFeed(Feed *editable_feed)
 {
     m_ui->m_cmbAutoUpdateType->setEnabled(true);
+    m_ui->m_gbRetention->setEnabled(true);
     FormFeedDetails::setEditableFeed(editable_feed);
     m_ui->m_txtTitle->setEnabled(true);
     m_ui->m_gbAuthentication->setEnabled(false);
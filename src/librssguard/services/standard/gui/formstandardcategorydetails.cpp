@@ -8,6 +8,7 @@
 #include "gui/feedsview.h"
 #include "gui/messagebox.h"
 #include "gui/systemtrayicon.h"
+#include "miscellaneous/databasequeries.h"
 #include "miscellaneous/iconfactory.h"
 #include "services/abstract/category.h"
 #include "services/abstract/rootitem.h"
@@ -62,6 +63,30 @@ void FormStandardCategoryDetails::setEditableCategory(StandardCategory *editable
     m_ui->m_txtTitle->lineEdit()->setText(editable_category->title());
     m_ui->m_txtDescription->lineEdit()->setText(editable_category->description());
     m_ui->m_btnIcon->setIcon(editable_category->icon());
+
+    const RetentionPolicy policy = DatabaseQueries::getRetentionPolicy(qApp->database()->connection(metaObject()->className()),
+                                                                       RootItem::Kind::Category,
+                                                                       editable_category->customId(),
+                                                                       m_serviceRoot->accountId());
+
+    m_ui->m_spinRetentionMaxAge->setValue(policy.m_maxAge);
+    m_ui->m_spinRetentionMaxCount->setValue(policy.m_maxCount);
+    m_ui->m_checkRetentionKeepImportant->setChecked(policy.m_keepImportant);
+}
+
+void FormStandardCategoryDetails::saveRetentionPolicy(StandardCategory *category)
+{
+    RetentionPolicy policy;
+
+    policy.m_maxAge = m_ui->m_spinRetentionMaxAge->value();
+    policy.m_maxCount = m_ui->m_spinRetentionMaxCount->value();
+    policy.m_keepImportant = m_ui->m_checkRetentionKeepImportant->isChecked();
+
+    DatabaseQueries::storeRetentionPolicy(qApp->database()->connection(metaObject()->className()),
+                                          RootItem::Kind::Category,
+                                          category->customId(),
+                                          m_serviceRoot->accountId(),
+                                          policy);
 }
 
 int FormStandardCategoryDetails::addEditCategory(StandardCategory *input_category,
@@ -117,6 +142,7 @@ void FormStandardCategoryDetails::apply()
         // Add the category.
         if (new_category->addItself(parent)) {
             m_serviceRoot->requestItemReassignment(new_category, parent);
+            saveRetentionPolicy(new_category);
             accept();
         } else {
             delete new_category;
@@ -131,6 +157,7 @@ void FormStandardCategoryDetails::apply()
 
         if (edited) {
             m_serviceRoot->requestItemReassignment(m_editableCategory, new_category->parent());
+            saveRetentionPolicy(m_editableCategory);
             accept();
         } else {
             qApp->showGuiMessage(tr("Cannot edit category"),
@@ -221,11 +248,20 @@ void FormStandardCategoryDetails::initialize()
     m_iconMenu->addAction(m_actionUseDefaultIcon);
     m_ui->m_btnIcon->setMenu(m_iconMenu);
 
+    // Setup retention options.
+    m_ui->m_spinRetentionMaxAge->setSuffix(tr(" days"));
+    m_ui->m_spinRetentionMaxAge->setSpecialValueText(tr("no limit"));
+    m_ui->m_spinRetentionMaxCount->setSuffix(tr(" messages"));
+    m_ui->m_spinRetentionMaxCount->setSpecialValueText(tr("no limit"));
+
     // Setup tab order.
     setTabOrder(m_ui->m_cmbParentCategory, m_ui->m_txtTitle->lineEdit());
     setTabOrder(m_ui->m_txtTitle->lineEdit(), m_ui->m_txtDescription->lineEdit());
     setTabOrder(m_ui->m_txtDescription->lineEdit(), m_ui->m_btnIcon);
-    setTabOrder(m_ui->m_btnIcon, m_ui->m_buttonBox);
+    setTabOrder(m_ui->m_btnIcon, m_ui->m_spinRetentionMaxAge);
+    setTabOrder(m_ui->m_spinRetentionMaxAge, m_ui->m_spinRetentionMaxCount);
+    setTabOrder(m_ui->m_spinRetentionMaxCount, m_ui->m_checkRetentionKeepImportant);
+    setTabOrder(m_ui->m_checkRetentionKeepImportant, m_ui->m_buttonBox);
     m_ui->m_txtTitle->lineEdit()->setFocus(Qt::TabFocusReason);
 }
 
@@ -56,6 +56,9 @@ protected:
     // Sets the category which will be edited.
     void setEditableCategory(StandardCategory *editable_category);
 
+    // Stores retention policy from the dialog for given category.
+    void saveRetentionPolicy(StandardCategory *category);
+
     // Initializes the dialog.
     void initialize();
 
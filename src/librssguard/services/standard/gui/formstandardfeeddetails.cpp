@@ -37,6 +37,7 @@ void FormStandardFeedDetails::apply()
         // Add the feed.
         if (new_feed->addItself(parent)) {
             m_serviceRoot->requestItemReassignment(new_feed, parent);
+            saveRetentionPolicy(new_feed);
             accept();
         } else {
             delete new_feed;
@@ -52,6 +53,7 @@ void FormStandardFeedDetails::apply()
 
         if (edited) {
             m_serviceRoot->requestItemReassignment(m_editableFeed, new_feed->parent());
+            saveRetentionPolicy(m_editableFeed);
             accept();
         } else {
             qApp->showGuiMessage(tr("Cannot edit feed"),
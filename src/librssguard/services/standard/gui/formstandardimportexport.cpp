@@ -14,6 +14,7 @@
 #include "services/standard/standardserviceroot.h"
 
 #include <QFileDialog>
+#include <QProgressDialog>
 #include <QTextStream>
 
 FormStandardImportExport::FormStandardImportExport(StandardServiceRoot *service_root,
@@ -306,7 +307,21 @@ void FormStandardImportExport::importFeeds()
     RootItem *parent = static_cast<RootItem *>(m_ui->m_cmbRootNode->itemData(
                            m_ui->m_cmbRootNode->currentIndex()).value<void *>());
 
-    if (m_serviceRoot->mergeImportExportModel(m_model, parent, output_message)) {
+    QProgressDialog progress(tr("Importing feeds..."), tr("Cancel"), 0, 0, this);
+
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    const bool imported = m_serviceRoot->mergeImportExportModel(m_model, parent, output_message,
+                                                                [&progress](int stored_count, int total_count) {
+        progress.setMaximum(total_count);
+        progress.setValue(stored_count);
+        return !progress.wasCanceled();
+    });
+
+    progress.reset();
+
+    if (imported) {
         m_serviceRoot->requestItemExpand(parent->getSubTree(), true);
         m_ui->m_lblResult->setStatus(WidgetWithStatus::StatusType::Ok, output_message, output_message);
     } else {
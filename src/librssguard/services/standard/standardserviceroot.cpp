@@ -23,6 +23,7 @@
 
 #include <QAction>
 #include <QClipboard>
+#include <QSqlError>
 #include <QSqlTableModel>
 #include <QStack>
 
@@ -209,7 +210,8 @@ QList<QAction *> StandardServiceRoot::getContextMenuForFeed(StandardFeed *feed)
 }
 
 bool StandardServiceRoot::mergeImportExportModel(FeedsImportExportModel *model,
-        RootItem *target_root_node, QString &output_message)
+        RootItem *target_root_node, QString &output_message,
+        const std::function<bool(int, int)> &progress)
 {
     QStack<RootItem *> original_parents;
 
@@ -217,7 +219,9 @@ bool StandardServiceRoot::mergeImportExportModel(FeedsImportExportModel *model,
     QStack<RootItem *> new_parents;
 
     new_parents.push(model->rootItem());
-    bool some_feed_category_error = false;
+
+    // New items paired with their new parents, parents always precede their children.
+    QList<QPair<RootItem *, RootItem *>> new_items;
 
     // Iterate all new items we would like to merge into current model.
     while (!new_parents.isEmpty()) {
@@ -234,53 +238,111 @@ bool StandardServiceRoot::mergeImportExportModel(FeedsImportExportModel *model,
             if (source_item->kind() == RootItem::Kind::Category) {
                 auto *source_category = dynamic_cast<StandardCategory *>(source_item);
                 auto *new_category = new StandardCategory(*source_category);
-                QString new_category_title = new_category->title();
 
-                // Add category to model.
                 new_category->clearChildren();
+                new_items.append(QPair<RootItem *, RootItem *>(new_category, target_parent));
 
-                if (new_category->addItself(target_parent)) {
-                    requestItemReassignment(new_category, target_parent);
+                // Process all children of this category.
+                original_parents.push(new_category);
+                new_parents.push(source_category);
+            } else if (source_item->kind() == RootItem::Kind::Feed) {
+                auto *source_feed = dynamic_cast<StandardFeed *>(source_item);
 
-                    // Process all children of this category.
-                    original_parents.push(new_category);
-                    new_parents.push(source_category);
-                } else {
-                    delete new_category;
+                new_items.append(QPair<RootItem *, RootItem *>(new StandardFeed(*source_feed), target_parent));
+            }
+        }
+    }
 
-                    // Add category failed, but this can mean that the same category (with same title)
-                    // already exists. If such a category exists in current parent, then find it and
-                    // add descendants to it.
-                    RootItem *existing_category = nullptr;
+    QSqlDatabase database = qApp->database()->connection(metaObject()->className());
 
-                    for (RootItem *child : target_parent->childItems()) {
-                        if (child->kind() == RootItem::Kind::Category && child->title() == new_category_title) {
-                            existing_category = child;
-                        }
-                    }
+    // All items are stored in single transaction, so that cancelled import does
+    // not leave anything behind. Each item is stored in its own savepoint, items
+    // which fail to be stored are skipped.
+    if (!database.transaction()) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to start transaction for import of feeds/categories: '"
+                   << database.lastError().text()
+                   << "'.";
+
+        for (const auto &item : new_items) {
+            delete item.first;
+        }
 
-                    if (existing_category != nullptr) {
-                        original_parents.push(existing_category);
-                        new_parents.push(source_category);
-                    } else {
-                        some_feed_category_error = true;
+        output_message = tr("Import failed, no feeds/categories were imported.");
+        return false;
+    }
+
+    // Category which fails to be stored is replaced by existing category with the same title,
+    // if there is such category in the target parent, and its descendants are added to it.
+    // Otherwise descendants of failed category are skipped too.
+    QHash<RootItem *, RootItem *> replaced_parents;
+    QList<QPair<RootItem *, RootItem *>> stored_items;
+    QList<RootItem *> failed_items;
+    bool some_feed_category_error = false;
+    int processed = 0;
+
+    for (const auto &item : new_items) {
+        RootItem *new_item = item.first;
+        RootItem *target_parent = replaced_parents.value(item.second, item.second);
+
+        if (target_parent != nullptr &&
+            DatabaseQueries::addStandardItem(database, new_item, target_parent->id(), accountId())) {
+            new_item->setCustomId(QString::number(new_item->id()));
+            stored_items.append(QPair<RootItem *, RootItem *>(new_item, target_parent));
+        } else {
+            RootItem *existing_category = nullptr;
+
+            if (new_item->kind() == RootItem::Kind::Category && target_parent != nullptr) {
+                for (RootItem *child : target_parent->childItems()) {
+                    if (child->kind() == RootItem::Kind::Category && child->title() == new_item->title()) {
+                        existing_category = child;
                     }
                 }
-            } else if (source_item->kind() == RootItem::Kind::Feed) {
-                auto *source_feed = dynamic_cast<StandardFeed *>(source_item);
-                auto *new_feed = new StandardFeed(*source_feed);
-
-                // Append this feed and end this iteration.
-                if (new_feed->addItself(target_parent)) {
-                    requestItemReassignment(new_feed, target_parent);
-                } else {
-                    delete new_feed;
-                    some_feed_category_error = true;
-                }
+
+                replaced_parents.insert(new_item, existing_category);
+            }
+
+            if (existing_category == nullptr) {
+                some_feed_category_error = true;
+            }
+
+            failed_items.append(new_item);
+        }
+
+        if (progress != nullptr && !progress(++processed, new_items.size())) {
+            qWarningNN << LOGSEC_DB << "Import of " << new_items.size() << " feeds/categories was cancelled.";
+            database.rollback();
+
+            for (const auto &new_item_pair : new_items) {
+                delete new_item_pair.first;
             }
+
+            output_message = tr("Import was cancelled, no feeds/categories were imported.");
+            return false;
         }
     }
 
+    if (!database.commit()) {
+        qWarningNN << LOGSEC_DB
+                   << "Failed to commit import of feeds/categories: '"
+                   << database.lastError().text()
+                   << "'.";
+        database.rollback();
+
+        for (const auto &new_item_pair : new_items) {
+            delete new_item_pair.first;
+        }
+
+        output_message = tr("Import failed, no feeds/categories were imported.");
+        return false;
+    }
+
+    for (const auto &item : stored_items) {
+        requestItemReassignment(item.first, item.second);
+    }
+
+    qDeleteAll(failed_items);
+
     if (some_feed_category_error) {
         output_message = tr("Import successful, but some feeds/categories were not imported due to error.");
     } else {
@@ -289,6 +351,7 @@ bool StandardServiceRoot::mergeImportExportModel(FeedsImportExportModel *model,
 
     return !some_feed_category_error;
 }
+}
 
 void StandardServiceRoot::addNewCategory()
 {
@@ -10,6 +10,8 @@
 #include <QCoreApplication>
 #include <QPair>
 
+#include <functional>
+
 class StandardCategory;
 class FeedsImportExportModel;
 class QMenu;
@@ -45,8 +47,11 @@ public:
     // Takes structure residing under given root item and adds feeds/categories from
     // it to active structure.
     // NOTE: This is used for import/export of the model.
+    // All items are stored in single transaction, items which fail to be stored are skipped.
+    // "progress" can report progress of storing and cancel whole import by returning false.
     bool mergeImportExportModel(FeedsImportExportModel *model, RootItem *target_root_node,
-                                QString &output_message);
+                                QString &output_message,
+                                const std::function<bool(int, int)> &progress = nullptr);
 
     void loadFromDatabase();
     void checkArgumentForFeedAdding(const QString &argument);